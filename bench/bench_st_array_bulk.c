@@ -0,0 +1,133 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stdlib.h>
+#include "bench.h"
+#include "../lib/st_array.h"
+
+#define MAX_NUMBERS 100000
+
+enum { MODE_LIST, MODE_VECTOR, MODE_UNROLLED, MODE_COUNT };
+
+static const char *_modes[] = { "list", "vector", "unrolled" };
+static const unsigned long _sizes[] = { 1000, 10000, MAX_NUMBERS };
+
+static st_array_t *new_array(st_malloc_t *st_m, int mode)
+{
+    switch(mode) {
+        case MODE_VECTOR:
+            return st_array_new_vector(st_m, 0);
+        case MODE_UNROLLED:
+            return st_array_new_unrolled(st_m, FALSE);
+        default:
+            return st_array_new(st_m);
+    }
+}
+
+/**
+ * Times building an array one append at a time against one batch append, and
+ * merging two halves element by element against a concat.  Returns FALSE if
+ * the heap was too small.
+ */
+static st_bool_t run(st_malloc_t *st_m, st_object_t **objects, unsigned long count, int mode, double *times)
+{
+    st_array_t *array, *left, *right;
+    st_array_cursor_t cursor;
+    unsigned long i;
+    double start;
+
+    start = bench_seconds();
+    array = new_array(st_m, mode);
+    for (i=0; i<count; i++) {
+        st_array_append_object(array, objects[i]);
+    }
+    times[0] = bench_seconds() - start;
+
+    start = bench_seconds();
+    array = new_array(st_m, mode);
+    st_array_append_objects(array, objects, ST_SIZE(count));
+    times[1] = bench_seconds() - start;
+
+    left = new_array(st_m, mode);
+    right = new_array(st_m, mode);
+    st_array_append_objects(left, objects, ST_SIZE(count / 2));
+    st_array_append_objects(right, objects + count / 2, ST_SIZE(count - count / 2));
+    start = bench_seconds();
+    ST_ARRAY_CURSOR_FOREACH(&cursor, right) {
+        st_array_append_object(left, st_array_cursor_get_object(&cursor));
+    }
+    times[2] = bench_seconds() - start;
+
+    left = new_array(st_m, mode);
+    right = new_array(st_m, mode);
+    st_array_append_objects(left, objects, ST_SIZE(count / 2));
+    st_array_append_objects(right, objects + count / 2, ST_SIZE(count - count / 2));
+    start = bench_seconds();
+    st_array_concat(left, right);
+    times[3] = bench_seconds() - start;
+
+    return ST_BOOL(!st_malloc_did_overflow(st_m) && st_array_get_size(left) == count);
+}
+
+void bench_st_array_bulk()
+{
+    size_t heap_size = MAX_NUMBERS * (sizeof(st_object_t) + 5 * sizeof(st_link_t) + 8 * sizeof(st_ptr_t));
+    st_byte_t *heap = malloc(heap_size);
+    st_object_t **objects = malloc(MAX_NUMBERS * sizeof(st_object_t *));
+    st_malloc_t st_m;
+    double times[4];
+    unsigned long n, i;
+    int mode;
+
+    if (heap == NULL || objects == NULL) {
+        printf("could not allocate the heap\n");
+        free(heap);
+        free(objects);
+        return;
+    }
+
+    printf("%-10s %-9s %12s %19s %12s %12s\n", "elements", "mode", "append (us)", "append_objects (us)",
+           "merge (us)", "concat (us)");
+    for (n=0; n<sizeof(_sizes)/sizeof(_sizes[0]); n++) {
+        for (mode=0; mode<MODE_COUNT; mode++) {
+            st_malloc_init(&st_m, heap, ST_SIZE(heap_size));
+            for (i=0; i<_sizes[n]; i++) {
+                objects[i] = st_object_new_int(&st_m, (st_int_t)i);
+            }
+            if (!run(&st_m, objects, _sizes[n], mode, times)) {
+                printf("the heap overflowed\n");
+                continue;
+            }
+
+            printf("%-10lu %-9s %12.1f %19.1f %12.1f %12.1f\n", _sizes[n], _modes[mode], times[0] * 1e6,
+                   times[1] * 1e6, times[2] * 1e6, times[3] * 1e6);
+        }
+    }
+
+    free(objects);
+    free(heap);
+}
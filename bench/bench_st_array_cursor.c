@@ -0,0 +1,103 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stdlib.h>
+#include "bench.h"
+#include "../lib/st_array.h"
+
+#define MAX_NUMBERS 100000
+
+/* The indexed scan is O(n^2) and only run up to this size */
+#define MAX_INDEXED 20000
+
+static const unsigned long _sizes[] = { 100, 1000, 10000, 20000, MAX_NUMBERS };
+
+/* How st_array_has_object used to search, indexing every link from the first one */
+static st_bool_t indexed_has_object(st_array_t *array, st_object_t *object)
+{
+    st_size_t i;
+
+    for (i=0; i<st_array_get_size(array); i++) {
+        if (st_array_get_link(array, i)->object == object) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+void bench_st_array_cursor()
+{
+    size_t heap_size = MAX_NUMBERS * (sizeof(st_link_t) + sizeof(st_object_t) + 2 * sizeof(st_ptr_t)) + 1024;
+    st_byte_t *heap = malloc(heap_size);
+    st_malloc_t st_m;
+    st_array_t *array;
+    st_object_t *missing;
+    unsigned long n, i;
+    double start, indexed, cursor;
+    int found = 0;
+
+    if (heap == NULL) {
+        printf("could not allocate the heap\n");
+        return;
+    }
+
+    // A search that misses visits every link, the time per link shows the curve
+    printf("%-10s %18s %18s\n", "elements", "indexed (ns/link)", "cursor (ns/link)");
+    for (n=0; n<sizeof(_sizes)/sizeof(_sizes[0]); n++) {
+        st_malloc_init(&st_m, heap, ST_SIZE(heap_size));
+        array = st_array_new(&st_m);
+        for (i=0; i<_sizes[n]; i++) {
+            st_array_append_object(array, st_object_new_int(&st_m, (st_int_t)i));
+        }
+        missing = st_object_new_int(&st_m, -1);
+
+        indexed = -1;
+        if (_sizes[n] <= MAX_INDEXED) {
+            start = bench_seconds();
+            found += indexed_has_object(array, missing);
+            indexed = (bench_seconds() - start) * 1e9 / _sizes[n];
+        }
+
+        start = bench_seconds();
+        found += st_array_has_object(array, missing);
+        cursor = (bench_seconds() - start) * 1e9 / _sizes[n];
+
+        printf("%-10lu ", _sizes[n]);
+        if (indexed < 0) {
+            printf("%18s ", "-");
+        }
+        else {
+            printf("%18.1f ", indexed);
+        }
+        printf("%18.1f\n", cursor);
+    }
+
+    if (found != 0) {
+        printf("unexpected match\n");
+    }
+    free(heap);
+}
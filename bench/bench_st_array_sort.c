@@ -0,0 +1,112 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stdlib.h>
+#include "bench.h"
+#include "../lib/st_array.h"
+
+#define MAX_NUMBERS 1000000
+#define LOOKUPS 100000
+
+static const unsigned long _sizes[] = { 10000, 100000, MAX_NUMBERS };
+
+static int _qsort_order(const void *object1, const void *object2)
+{
+    return st_object_order(*(st_object_t *const *)object1, *(st_object_t *const *)object2);
+}
+
+/* Builds an array of "count" ints in a pseudo random order */
+static st_array_t *build(st_malloc_t *st_m, unsigned long count)
+{
+    st_array_t *array = st_array_new(st_m);
+    uint32_t seed = 12345;
+    unsigned long i;
+
+    for (i=0; i<count; i++) {
+        seed = seed * 1103515245u + 12345u;
+        st_array_append_object(array, st_object_new_int(st_m, (st_int_t)(seed >> 1)));
+    }
+    return array;
+}
+
+void bench_st_array_sort()
+{
+    size_t heap_size = MAX_NUMBERS * (sizeof(st_link_t) + sizeof(st_object_t) + 2 * sizeof(st_ptr_t)) + 1024;
+    st_byte_t *heap = malloc(heap_size);
+    st_object_t **objects = malloc(MAX_NUMBERS * sizeof(st_object_t *));
+    st_malloc_t st_m;
+    st_array_t *array;
+    st_link_t *link;
+    unsigned long n, i, found = 0;
+    double start, sort_time, qsort_time, lookup_time;
+
+    if (heap == NULL || objects == NULL) {
+        printf("could not allocate the heap\n");
+        free(heap);
+        free(objects);
+        return;
+    }
+
+    printf("%-10s %15s %15s %18s\n", "elements", "merge sort (ms)", "qsort (ms)", "lower bound (ns)");
+    for (n=0; n<sizeof(_sizes)/sizeof(_sizes[0]); n++) {
+        st_malloc_init(&st_m, heap, ST_SIZE(heap_size));
+        array = build(&st_m, _sizes[n]);
+
+        start = bench_seconds();
+        st_array_sort(array, NULL);
+        sort_time = bench_seconds() - start;
+
+        // The alternative, sorting a copy of the pointers and relinking
+        array = build(&st_m, _sizes[n]);
+        start = bench_seconds();
+        for (link = array->first, i = 0; link != NULL; link = link->next, i++) {
+            objects[i] = link->object;
+        }
+        qsort(objects, _sizes[n], sizeof(st_object_t *), _qsort_order);
+        for (link = array->first, i = 0; link != NULL; link = link->next, i++) {
+            link->object = objects[i];
+        }
+        qsort_time = bench_seconds() - start;
+
+        start = bench_seconds();
+        for (i=0; i<LOOKUPS; i++) {
+            found += st_object_lower_bound(objects, ST_SIZE(_sizes[n]), objects[(i * 7919) % _sizes[n]], NULL);
+        }
+        lookup_time = bench_seconds() - start;
+
+        printf("%-10lu %15.2f %15.2f %18.1f\n", _sizes[n], sort_time * 1e3, qsort_time * 1e3,
+               lookup_time * 1e9 / LOOKUPS);
+    }
+
+    // Keep the lookups from being optimized away
+    if (found == 0) {
+        printf("checksum %lu\n", found);
+    }
+
+    free(heap);
+    free(objects);
+}
@@ -0,0 +1,151 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stdlib.h>
+#include "bench.h"
+#include "../lib/st_array.h"
+
+#define MAX_NUMBERS 100000
+#define INSERTS 1000
+#define WALKS 10
+
+/* The linked list is only indexed up to this size, the loop is O(n^2) */
+#define MAX_LIST_INDEXED 10000
+
+enum { MODE_LIST, MODE_VECTOR, MODE_UNROLLED, MODE_COUNT };
+
+static const char *_modes[] = { "list", "vector", "unrolled" };
+static const unsigned long _sizes[] = { 1000, 10000, MAX_NUMBERS };
+
+/* Keeps the reads from being optimized away */
+static st_long_t _checksum = 0;
+
+static st_array_t *new_array(st_malloc_t *st_m, int mode)
+{
+    switch(mode) {
+        case MODE_VECTOR:
+            return st_array_new_vector(st_m, 0);
+        case MODE_UNROLLED:
+            return st_array_new_unrolled(st_m, FALSE);
+        default:
+            return st_array_new(st_m);
+    }
+}
+
+/**
+ * Measures the bytes taken by the array itself, a cursor walk, an indexed
+ * read loop and inserts in the middle, returns FALSE if the heap was too small
+ */
+static st_bool_t run(st_malloc_t *st_m, st_object_t **objects, unsigned long count, int mode,
+                     st_size_t *bytes, double *times)
+{
+    st_size_t used = st_malloc_used_bytes(st_m);
+    st_array_t *array = new_array(st_m, mode);
+    st_array_cursor_t cursor;
+    unsigned long i;
+    double start;
+    int walk;
+
+    for (i=0; i<count; i++) {
+        st_array_append_object(array, objects[i]);
+    }
+    *bytes = ST_SIZE(st_malloc_used_bytes(st_m) - used);
+
+    start = bench_seconds();
+    for (walk=0; walk<WALKS; walk++) {
+        ST_ARRAY_CURSOR_FOREACH(&cursor, array) {
+            _checksum += st_object_get_int(st_array_cursor_get_object(&cursor));
+        }
+    }
+    times[0] = (bench_seconds() - start) / WALKS;
+
+    times[1] = -1;
+    if (mode != MODE_LIST || count <= MAX_LIST_INDEXED) {
+        start = bench_seconds();
+        for (i=0; i<count; i++) {
+            _checksum += st_object_get_int(st_array_get_object(array, ST_SIZE(i)));
+        }
+        times[1] = bench_seconds() - start;
+    }
+
+    start = bench_seconds();
+    for (i=0; i<INSERTS; i++) {
+        st_array_insert_object(array, objects[i], ST_SIZE(count / 2));
+    }
+    times[2] = bench_seconds() - start;
+
+    return ST_BOOL(!st_malloc_did_overflow(st_m));
+}
+
+void bench_st_array_unrolled()
+{
+    size_t heap_size = (MAX_NUMBERS + INSERTS) * (sizeof(st_link_t) + sizeof(st_object_t) + 4 * sizeof(st_ptr_t));
+    st_byte_t *heap = malloc(heap_size);
+    st_object_t **objects = malloc(MAX_NUMBERS * sizeof(st_object_t *));
+    st_malloc_t st_m;
+    st_size_t bytes;
+    double times[3];
+    unsigned long n, i;
+    int mode;
+
+    if (heap == NULL || objects == NULL) {
+        printf("could not allocate the heap\n");
+        free(heap);
+        free(objects);
+        return;
+    }
+
+    printf("%-10s %-9s %10s %10s %17s %14s\n", "elements", "mode", "bytes/elem", "walk (us)", "indexed read (us)",
+           "inserts (us)");
+    for (n=0; n<sizeof(_sizes)/sizeof(_sizes[0]); n++) {
+        for (mode=0; mode<MODE_COUNT; mode++) {
+            st_malloc_init(&st_m, heap, ST_SIZE(heap_size));
+            for (i=0; i<_sizes[n]; i++) {
+                objects[i] = st_object_new_int(&st_m, (st_int_t)i);
+            }
+            if (!run(&st_m, objects, _sizes[n], mode, &bytes, times)) {
+                printf("the heap overflowed\n");
+                continue;
+            }
+
+            printf("%-10lu %-9s %10.1f %10.1f ", _sizes[n], _modes[mode], (double)bytes / _sizes[n], times[0] * 1e6);
+            if (times[1] < 0) {
+                printf("%17s ", "-");
+            }
+            else {
+                printf("%17.1f ", times[1] * 1e6);
+            }
+            printf("%14.1f\n", times[2] * 1e6);
+        }
+    }
+
+    if (_checksum == 0) {
+        printf("checksum %ld\n", (long)_checksum);
+    }
+    free(objects);
+    free(heap);
+}
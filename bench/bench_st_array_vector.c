@@ -0,0 +1,112 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stdlib.h>
+#include "bench.h"
+#include "../lib/st_array.h"
+
+#define MAX_NUMBERS 100000
+#define INSERTS 1000
+
+/* The linked list is only indexed up to this size, the loop is O(n^2) */
+#define MAX_LIST_INDEXED 10000
+
+static const unsigned long _sizes[] = { 1000, 10000, MAX_NUMBERS };
+
+/* Keeps the reads from being optimized away */
+static st_long_t _checksum = 0;
+
+/* Times appending, an indexed read loop and inserts in the middle, returns FALSE if the heap was too small */
+static st_bool_t run(st_malloc_t *st_m, unsigned long count, st_bool_t vector, double *times)
+{
+    st_array_t *array = vector?st_array_new_vector(st_m, 0):st_array_new(st_m);
+    unsigned long i;
+    double start;
+
+    start = bench_seconds();
+    for (i=0; i<count; i++) {
+        st_array_append_object(array, st_object_new_int(st_m, (st_int_t)i));
+    }
+    times[0] = bench_seconds() - start;
+
+    times[1] = -1;
+    if (vector || count <= MAX_LIST_INDEXED) {
+        start = bench_seconds();
+        for (i=0; i<st_array_get_size(array); i++) {
+            _checksum += st_object_get_int(st_array_get_object(array, ST_SIZE(i)));
+        }
+        times[1] = bench_seconds() - start;
+    }
+
+    start = bench_seconds();
+    for (i=0; i<INSERTS; i++) {
+        st_array_insert_object(array, st_object_new_int(st_m, 0), ST_SIZE(count / 2));
+    }
+    times[2] = bench_seconds() - start;
+
+    return ST_BOOL(!st_malloc_did_overflow(st_m));
+}
+
+void bench_st_array_vector()
+{
+    size_t heap_size = (MAX_NUMBERS + INSERTS) * (sizeof(st_link_t) + sizeof(st_object_t) + 4 * sizeof(st_ptr_t));
+    st_byte_t *heap = malloc(heap_size);
+    st_malloc_t st_m;
+    double times[3];
+    unsigned long n;
+    int vector;
+
+    if (heap == NULL) {
+        printf("could not allocate the heap\n");
+        return;
+    }
+
+    printf("%-10s %-8s %12s %17s %14s\n", "elements", "mode", "append (us)", "indexed read (us)", "inserts (us)");
+    for (n=0; n<sizeof(_sizes)/sizeof(_sizes[0]); n++) {
+        for (vector=0; vector<2; vector++) {
+            st_malloc_init(&st_m, heap, ST_SIZE(heap_size));
+            if (!run(&st_m, _sizes[n], ST_BOOL(vector), times)) {
+                printf("the heap overflowed\n");
+                continue;
+            }
+
+            printf("%-10lu %-8s %12.1f ", _sizes[n], vector?"vector":"list", times[0] * 1e6);
+            if (times[1] < 0) {
+                printf("%17s ", "-");
+            }
+            else {
+                printf("%17.1f ", times[1] * 1e6);
+            }
+            printf("%14.1f\n", times[2] * 1e6);
+        }
+    }
+
+    if (_checksum == 0) {
+        printf("checksum %ld\n", (long)_checksum);
+    }
+    free(heap);
+}
@@ -0,0 +1,118 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stdlib.h>
+#include "bench.h"
+#include "../lib/st_dict.h"
+
+#define MAX_KEYS 4096
+
+/* Every size does about this many lookups so the small dicts are timed long enough */
+#define LOOKUPS 200000
+
+static const unsigned long _sizes[] = { 8, 64, 512, MAX_KEYS };
+
+/* Keeps the lookups from being optimized away */
+static st_long_t _checksum = 0;
+
+/**
+ * Times setting "count" new keys, looking them up with equal (not identical)
+ * keys and removing them again.  Returns FALSE if the heap was too small.
+ */
+static st_bool_t run(st_malloc_t *st_m, unsigned long count, st_bool_t indexed, double *times)
+{
+    static st_object_t *keys[MAX_KEYS], *probes[MAX_KEYS];
+    st_dict_t *dict = st_dict_new(st_m);
+    unsigned long i, round, rounds = (LOOKUPS + count - 1) / count;
+    char key[32];
+    double start;
+
+    for (i=0; i<count; i++) {
+        snprintf(key, sizeof(key), "key-%lu", i);
+        keys[i] = st_object_new_string(st_m, key);
+        probes[i] = st_object_new_string(st_m, key);
+    }
+    if (indexed && !st_dict_use_index(dict)) {
+        return FALSE;
+    }
+
+    start = bench_seconds();
+    for (i=0; i<count; i++) {
+        st_dict_set_object(dict, keys[i], keys[i]);
+    }
+    times[0] = (bench_seconds() - start) / count;
+
+    start = bench_seconds();
+    for (round=0; round<rounds; round++) {
+        for (i=0; i<count; i++) {
+            _checksum += (st_dict_get_object(dict, probes[i]) != NULL);
+        }
+    }
+    times[1] = (bench_seconds() - start) / (rounds * count);
+
+    // The keys are removed in a scattered order (the sizes are powers of two, so an odd stride visits them all)
+    start = bench_seconds();
+    for (i=0; i<count; i++) {
+        st_dict_remove_object(dict, probes[(i * 7919) % count]);
+    }
+    times[2] = (bench_seconds() - start) / count;
+
+    return ST_BOOL(!st_malloc_did_overflow(st_m) && st_dict_get_size(dict) == 0);
+}
+
+void bench_st_dict_index()
+{
+    size_t heap_size = 1024 * 1024;
+    st_byte_t *heap = malloc(heap_size);
+    st_malloc_t st_m;
+    double times[3];
+    unsigned long n;
+    int indexed;
+
+    if (heap == NULL) {
+        printf("could not allocate the heap\n");
+        return;
+    }
+
+    printf("%-6s %-8s %12s %12s %12s\n", "keys", "mode", "set (ns)", "get (ns)", "remove (ns)");
+    for (n=0; n<sizeof(_sizes)/sizeof(_sizes[0]); n++) {
+        for (indexed=0; indexed<2; indexed++) {
+            st_malloc_init(&st_m, heap, ST_SIZE(heap_size));
+            if (!run(&st_m, _sizes[n], ST_BOOL(indexed), times)) {
+                printf("the heap overflowed\n");
+                continue;
+            }
+            printf("%-6lu %-8s %12.1f %12.1f %12.1f\n", _sizes[n], indexed?"index":"list", times[0] * 1e9,
+                   times[1] * 1e9, times[2] * 1e9);
+        }
+    }
+
+    if (_checksum == 0) {
+        printf("checksum %ld\n", (long)_checksum);
+    }
+    free(heap);
+}
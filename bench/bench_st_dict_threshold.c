@@ -0,0 +1,134 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stdlib.h>
+#include "bench.h"
+#include "../lib/st_dict.h"
+
+#define MAX_KEYS 64
+
+/* Every size does about this many lookups */
+#define LOOKUPS 2000000
+
+static const unsigned long _sizes[] = { 1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, MAX_KEYS };
+
+/* Keeps the lookups from being optimized away */
+static st_long_t _checksum = 0;
+
+static st_object_t *new_key(st_malloc_t *st_m, unsigned long i, st_bool_t strings)
+{
+    char key[32];
+
+    if (!strings) {
+        return st_object_new_int(st_m, (st_int_t)i);
+    }
+    snprintf(key, sizeof(key), "key-%lu", i);
+    return st_object_new_string(st_m, key);
+}
+
+/**
+ * Returns the time of a lookup (with an equal, not identical, key) in a dict
+ * of "count" keys, or a negative time if the heap was too small.  The list is
+ * filled through its array so that it is not indexed on the way.
+ */
+static double run(st_malloc_t *st_m, unsigned long count, st_bool_t strings, st_bool_t indexed)
+{
+    st_object_t *probes[MAX_KEYS];
+    st_dict_t *dict = st_dict_new(st_m);
+    unsigned long i, round, rounds = LOOKUPS / count;
+    double start;
+
+    if (indexed && !st_dict_use_index(dict)) {
+        return -1;
+    }
+    for (i=0; i<count; i++) {
+        probes[i] = new_key(st_m, i, strings);
+        st_array_append_entry(dict->array, new_key(st_m, i, strings), probes[i]);
+    }
+    if (st_malloc_did_overflow(st_m)) {
+        return -1;
+    }
+
+    start = bench_seconds();
+    for (round=0; round<rounds; round++) {
+        for (i=0; i<count; i++) {
+            _checksum += (st_dict_get_object(dict, probes[i]) != NULL);
+        }
+    }
+    return (bench_seconds() - start) / (rounds * count);
+}
+
+void bench_st_dict_threshold()
+{
+    size_t heap_size = 64 * 1024;
+    st_byte_t *heap = malloc(heap_size);
+    st_malloc_t st_m;
+    double list, index;
+    unsigned long n, crossover;
+    int strings;
+
+    if (heap == NULL) {
+        printf("could not allocate the heap\n");
+        return;
+    }
+
+    printf("ST_DICT_INDEX_THRESHOLD is %d\n", ST_DICT_INDEX_THRESHOLD);
+    for (strings=0; strings<2; strings++) {
+        printf("\n%-6s %-6s %12s %12s\n", "keys", "type", "list (ns)", "index (ns)");
+        crossover = 0;
+        for (n=0; n<sizeof(_sizes)/sizeof(_sizes[0]); n++) {
+            st_malloc_init(&st_m, heap, ST_SIZE(heap_size));
+            list = run(&st_m, _sizes[n], ST_BOOL(strings), FALSE);
+            st_malloc_init(&st_m, heap, ST_SIZE(heap_size));
+            index = run(&st_m, _sizes[n], ST_BOOL(strings), TRUE);
+            if (list < 0 || index < 0) {
+                printf("the heap overflowed\n");
+                continue;
+            }
+
+            // The first size from which on the index stays ahead
+            if (index >= list) {
+                crossover = 0;
+            }
+            else if (crossover == 0) {
+                crossover = _sizes[n];
+            }
+            printf("%-6lu %-6s %12.1f %12.1f\n", _sizes[n], strings?"str":"int", list * 1e9, index * 1e9);
+        }
+        if (crossover > 0) {
+            printf("the index is faster from %lu keys\n", crossover);
+        }
+        else {
+            printf("the index is not faster at these sizes\n");
+        }
+    }
+
+    if (_checksum == 0) {
+        printf("checksum %ld\n", (long)_checksum);
+    }
+    free(heap);
+}
@@ -0,0 +1,146 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "bench.h"
+#include "../lib/st_malloc_mmap.h"
+
+#define HEAP_SIZE (128*1024*1024)
+#define RECORD_SIZE 32
+#define READS 10000000
+
+static st_byte_t _heap[HEAP_SIZE];
+
+/* Opens a data TLB miss counter, returns -1 if perf events are not available */
+static int open_dtlb_counter(void)
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+static void run(const char *name, st_malloc_t *st_m)
+{
+    struct rusage before, after;
+    long long misses = -1;
+    uint64_t seed = 1, sum = 0;
+    size_t count = 0, i;
+    st_ptr_t *record;
+    double start, build_time, read_time;
+    int counter = open_dtlb_counter();
+
+    getrusage(RUSAGE_SELF, &before);
+#ifdef __linux__
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+
+    // Fill the heap with records, then read them back in a random order
+    start = bench_seconds();
+    while ((record = st_malloc_struct(st_m, RECORD_SIZE)) != NULL) {
+        record[0] = count++;
+    }
+    build_time = bench_seconds() - start;
+
+    start = bench_seconds();
+    for (i=0; i<READS; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        sum += *(st_ptr_t *)(st_m->heap + ((seed >> 33) % count) * RECORD_SIZE);
+    }
+    read_time = bench_seconds() - start;
+
+#ifdef __linux__
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter, &misses, sizeof(misses)) != sizeof(misses)) {
+            misses = -1;
+        }
+        close(counter);
+    }
+#endif
+    getrusage(RUSAGE_SELF, &after);
+
+    printf("%-16s %10.1f %10.1f %14ld ", name, build_time * 1e3, read_time * 1e3,
+           after.ru_minflt - before.ru_minflt);
+    if (misses >= 0) {
+        printf("%14lld\n", misses);
+    }
+    else {
+        printf("%14s\n", "n/a");
+    }
+
+    // Keep the reads from being optimized away
+    if (sum == 0) {
+        printf("checksum %llu\n", (unsigned long long)sum);
+    }
+}
+
+void bench_st_malloc_mmap()
+{
+    st_malloc_t st_m;
+    st_malloc_mmap_t mmap_heap;
+
+    printf("%-16s %10s %10s %14s %14s\n", "heap", "build (ms)", "read (ms)", "page faults", "dTLB misses");
+
+    st_malloc_init(&st_m, _heap, sizeof(_heap));
+    run("static", &st_m);
+
+    if (st_malloc_mmap_init(&mmap_heap, HEAP_SIZE, 0, FALSE)) {
+        run("mmap", &mmap_heap.malloc);
+        st_malloc_mmap_destroy(&mmap_heap);
+    }
+
+    if (st_malloc_mmap_init(&mmap_heap, HEAP_SIZE, 0, TRUE)) {
+        run("mmap huge pages", &mmap_heap.malloc);
+
+        // A second build after a release faults the pages in again
+        st_malloc_free(&mmap_heap.malloc);
+        run("mmap after free", &mmap_heap.malloc);
+        st_malloc_mmap_destroy(&mmap_heap);
+    }
+}
@@ -0,0 +1,92 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <pthread.h>
+#include "bench.h"
+#include "../lib/st_malloc_shared.h"
+
+#define MAX_THREADS 8
+#define ALLOCATIONS 200000
+#define ALLOCATION_SIZE 16
+
+static st_byte_t _heap[MAX_THREADS * ALLOCATIONS * (ALLOCATION_SIZE + 8)];
+static st_malloc_shared_t _shared;
+
+static void *shared_worker(void *arg)
+{
+    int i;
+    for (i=0; i<ALLOCATIONS; i++) {
+        st_malloc_shared_struct(&_shared, ALLOCATION_SIZE);
+    }
+    return NULL;
+}
+
+static void *local_worker(void *arg)
+{
+    st_malloc_t local;
+    int i;
+
+    st_malloc_shared_init_local(&_shared, &local);
+    for (i=0; i<ALLOCATIONS; i++) {
+        st_malloc_struct(&local, ALLOCATION_SIZE);
+    }
+    return NULL;
+}
+
+static double run(void *(*worker)(void *), int count)
+{
+    pthread_t threads[MAX_THREADS];
+    double start;
+    int i;
+
+    st_malloc_shared_free(&_shared);
+
+    start = bench_seconds();
+    for (i=0; i<count; i++) {
+        pthread_create(&threads[i], NULL, worker, NULL);
+    }
+    for (i=0; i<count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    return bench_seconds() - start;
+}
+
+void bench_st_malloc_shared()
+{
+    double shared, local;
+    int count;
+
+    st_malloc_shared_init(&_shared, _heap, sizeof(_heap), 64*1024);
+
+    printf("%8s %22s %22s\n", "threads", "shared (Mallocs/s)", "local (Mallocs/s)");
+    for (count=1; count<=MAX_THREADS; count*=2) {
+        shared = run(shared_worker, count);
+        local = run(local_worker, count);
+        printf("%8d %22.1f %22.1f\n", count,
+               count * ALLOCATIONS / shared / 1e6, count * ALLOCATIONS / local / 1e6);
+    }
+}
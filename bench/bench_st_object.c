@@ -0,0 +1,87 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include "bench.h"
+#include "../lib/st_array.h"
+
+#define NUMBERS 10000
+#define RUNS 50
+
+static st_ptr_t _heap[1024*1024/sizeof(st_ptr_t)];
+
+/* Builds an array of NUMBERS alternating ints and doubles */
+static st_array_t *build(st_malloc_t *st_m)
+{
+    st_array_t *array = st_array_new(st_m);
+    int i;
+
+    for (i=0; i<NUMBERS; i++) {
+        if (i & 1) {
+            st_array_append_object(array, st_object_new_float(st_m, i * 0.5));
+        }
+        else {
+            st_array_append_object(array, st_object_new_int(st_m, i));
+        }
+    }
+    return array;
+}
+
+void bench_st_object()
+{
+    st_malloc_t st_m;
+    st_array_t *array = NULL;
+    st_link_t *link;
+    st_float_t sum = 0;
+    double start, build_time = 1e9, read_time = 1e9, elapsed;
+    int i;
+
+    for (i=0; i<RUNS; i++) {
+        st_malloc_init(&st_m, (st_byte_t *)_heap, sizeof(_heap));
+
+        start = bench_seconds();
+        array = build(&st_m);
+        elapsed = bench_seconds() - start;
+        build_time = (elapsed < build_time)?elapsed:build_time;
+
+        start = bench_seconds();
+        for (link = array->first; link != NULL; link = link->next) {
+            sum += st_object_get_float(link->object) + st_object_get_int(link->object);
+        }
+        elapsed = bench_seconds() - start;
+        read_time = (elapsed < read_time)?elapsed:read_time;
+    }
+
+    printf("%-10s %12s %10s %10s %10s\n", "layout", "heap bytes", "per number", "build (us)", "read (us)");
+    printf("%-10s %12u %10.1f %10.1f %10.1f\n", ST_OBJECT_NAN_BOX?"nan-box":"tagged",
+           (unsigned)st_malloc_used_bytes(&st_m), (double)st_malloc_used_bytes(&st_m) / NUMBERS,
+           build_time * 1e6, read_time * 1e6);
+
+    // Keep the reads from being optimized away
+    if (sum == 0) {
+        printf("checksum %f\n", sum);
+    }
+}
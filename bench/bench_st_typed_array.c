@@ -0,0 +1,104 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include "bench.h"
+#include "../lib/st_array.h"
+#include "../lib/st_typed_array.h"
+
+#define NUMBERS 10000
+#define RUNS 50
+
+static st_ptr_t _heap[1024*1024/sizeof(st_ptr_t)];
+
+/* Best time of RUNS sums, "sum" keeps the reads from being optimized away */
+static double time_sum(st_typed_array_t *array, st_float_t *sum)
+{
+    double start, best = 1e9, elapsed;
+    int i;
+
+    for (i=0; i<RUNS; i++) {
+        start = bench_seconds();
+        *sum += st_typed_array_sum(array) + st_typed_array_dot(array, array);
+        elapsed = bench_seconds() - start;
+        best = (elapsed < best)?elapsed:best;
+    }
+    return best;
+}
+
+void bench_st_typed_array()
+{
+    static const char *const isa_names[] = { "scalar", "sse2", "avx2" };
+    st_typed_array_isa_t isa = st_typed_array_get_isa();
+    st_malloc_t st_m;
+    st_array_t *array;
+    st_typed_array_t *typed_array;
+    st_link_t *link;
+    st_float_t sum = 0, square;
+    st_size_t used;
+    double start, best = 1e9, elapsed;
+    int i, n;
+
+    st_malloc_init(&st_m, (st_byte_t *)_heap, sizeof(_heap));
+    array = st_array_new(&st_m);
+    for (i=0; i<NUMBERS; i++) {
+        st_array_append_object(array, st_object_new_float(&st_m, i * 0.5));
+    }
+    used = st_malloc_used_bytes(&st_m);
+
+    // The same sum and dot product over the linked objects
+    for (n=0; n<RUNS; n++) {
+        start = bench_seconds();
+        for (link = array->first; link != NULL; link = link->next) {
+            square = st_object_get_float(link->object);
+            sum += square + square * square;
+        }
+        elapsed = bench_seconds() - start;
+        best = (elapsed < best)?elapsed:best;
+    }
+
+    printf("%-10s %12s %10s %15s\n", "storage", "heap bytes", "per number", "sum+dot (us)");
+    printf("%-10s %12u %10.1f %15.1f\n", "st_array", (unsigned)used, (double)used / NUMBERS, best * 1e6);
+
+    st_malloc_init(&st_m, (st_byte_t *)_heap, sizeof(_heap));
+    typed_array = st_typed_array_new(&st_m, ST_TYPED_ARRAY_FLOAT64, 0);
+    for (i=0; i<NUMBERS; i++) {
+        st_typed_array_append_float(typed_array, i * 0.5);
+    }
+    used = st_malloc_used_bytes(&st_m);
+
+    for (n=ST_TYPED_ARRAY_ISA_SCALAR; n<=ST_TYPED_ARRAY_ISA_AVX2; n++) {
+        if (st_typed_array_use_isa((st_typed_array_isa_t)n)) {
+            printf("%-10s %12u %10.1f %15.1f\n", isa_names[n], (unsigned)used, (double)used / NUMBERS,
+                   time_sum(typed_array, &sum) * 1e6);
+        }
+    }
+    st_typed_array_use_isa(isa);
+
+    if (sum == 0) {
+        printf("checksum %f\n", sum);
+    }
+}
@@ -0,0 +1,77 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+extern void bench_st_malloc_shared();
+extern void bench_st_malloc_mmap();
+extern void bench_st_object();
+extern void bench_st_typed_array();
+extern void bench_st_array_sort();
+extern void bench_st_array_vector();
+extern void bench_st_array_cursor();
+extern void bench_st_array_unrolled();
+extern void bench_st_array_bulk();
+extern void bench_st_dict_index();
+extern void bench_st_dict_threshold();
+
+typedef struct bench_s
+{
+    const char *name;
+    void (*run)();
+} bench_t;
+
+static const bench_t _benches[] = {
+    { "st_malloc_shared", bench_st_malloc_shared },
+    { "st_malloc_mmap", bench_st_malloc_mmap },
+    { "st_object", bench_st_object },
+    { "st_typed_array", bench_st_typed_array },
+    { "st_array_sort", bench_st_array_sort },
+    { "st_array_vector", bench_st_array_vector },
+    { "st_array_cursor", bench_st_array_cursor },
+    { "st_array_unrolled", bench_st_array_unrolled },
+    { "st_array_bulk", bench_st_array_bulk },
+    { "st_dict_index", bench_st_dict_index },
+    { "st_dict_threshold", bench_st_dict_threshold },
+};
+
+/* Runs every benchmark, or only the ones named on the command line */
+int main(int argc, char *argv[]) {
+    size_t i;
+    int j;
+
+    for (i=0; i<sizeof(_benches)/sizeof(_benches[0]); i++) {
+        for (j=1; j<argc && strcmp(argv[j], _benches[i].name) != 0; j++);
+        if (argc == 1 || j < argc) {
+            printf("\nRunning '%s' benchmark\n", _benches[i].name);
+            _benches[i].run();
+        }
+    }
+
+    return 0;
+}
@@ -25,13 +25,21 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <string.h>
 #include "st_array.h"
 
+#define ST_ARRAY_MIN_CAPACITY 8
+
+/* Views share the storage of another array and are never modified */
+#define ST_ARRAY_READ_ONLY(array) ((array)->frozen || (array)->view)
+
 st_array_t *st_array_new(st_malloc_t *malloc)
 {
     st_array_t *array = st_malloc_struct(malloc, sizeof(st_array_t));
-    array->malloc = malloc;
-    st_array_init(array);
+    if (array != NULL) {
+        array->malloc = malloc;
+        st_array_init(array);
+    }
     return array;
 }
 
@@ -40,6 +48,102 @@ void st_array_init(st_array_t *this)
     this->first = NULL;
     this->last = NULL;
     this->size = 0;
+    this->hash = 0;
+    this->frozen = FALSE;
+    this->view = FALSE;
+    this->unrolled = FALSE;
+    this->keyed = FALSE;
+    this->slots = NULL;
+    this->capacity = 0;
+    this->first_block = NULL;
+    this->last_block = NULL;
+    this->index = NULL;
+    this->index_threshold = 0;
+}
+
+st_array_t *st_array_new_vector(st_malloc_t *malloc, st_size_t capacity)
+{
+    st_array_t *array = st_array_new(malloc);
+    return (array != NULL && st_array_use_vector(array, capacity))?array:NULL;
+}
+
+st_array_t *st_array_new_unrolled(st_malloc_t *malloc, st_bool_t keyed)
+{
+    st_array_t *array = st_array_new(malloc);
+    if (array != NULL) {
+        array->unrolled = TRUE;
+        array->keyed = keyed;
+    }
+    return array;
+}
+
+/* Moves the slots to a buffer of at least "capacity" slots */
+static st_bool_t _st_array_grow(st_array_t *this, st_size_t capacity)
+{
+    st_link_t **slots;
+
+    if (capacity > ST_SIZE_MAX / sizeof(st_link_t *) ||
+        (slots = st_malloc_struct(this->malloc, ST_SIZE(capacity * sizeof(st_link_t *)))) == NULL)
+    {
+        return FALSE;
+    }
+
+    if (this->slots != NULL && this->size > 0) {
+        memcpy(slots, this->slots, this->size * sizeof(st_link_t *));
+    }
+    this->slots = slots;
+    this->capacity = capacity;
+    return TRUE;
+}
+
+st_bool_t st_array_use_vector(st_array_t *this, st_size_t capacity)
+{
+    st_link_t *link;
+    st_size_t i;
+
+    if (this->unrolled) {
+        return FALSE;
+    }
+
+    capacity = (capacity < this->size)?this->size:capacity;
+    if (this->slots != NULL) {
+        return (capacity > this->capacity)?_st_array_grow(this, capacity):TRUE;
+    }
+
+    if (!_st_array_grow(this, (capacity > 0)?capacity:ST_ARRAY_MIN_CAPACITY)) {
+        return FALSE;
+    }
+
+    for (link = this->first, i = 0; i < this->size; link = link->next, i++) {
+        this->slots[i] = link;
+    }
+    return TRUE;
+}
+
+/* Makes room for "count" more slots, the capacity doubles (or grows to fit) */
+static st_bool_t _st_array_reserve(st_array_t *this, st_size_t count)
+{
+    st_size_t capacity;
+
+    if (this->slots == NULL || count <= this->capacity - this->size) {
+        return TRUE;
+    }
+    if (count > ST_SIZE_MAX - this->size) {
+        return FALSE;
+    }
+
+    capacity = (this->capacity > ST_SIZE_MAX / 2)?ST_SIZE_MAX:ST_SIZE(this->capacity * 2);
+    return _st_array_grow(this, (capacity < this->size + count)?ST_SIZE(this->size + count):capacity);
+}
+
+/* Returns the link "steps" links after "link" */
+static st_link_t *_st_array_walk(st_link_t *link, st_size_t steps)
+{
+    while (steps > 0) {
+        link = link->next;
+        steps--;
+    }
+    return link;
 }
 
 st_size_t st_array_get_size(st_array_t *this)
@@ -47,12 +151,268 @@ st_size_t st_array_get_size(st_array_t *this)
     return this->size;
 }
 
-st_bool_t st_array_insert_link(st_array_t *this, st_link_t *link, st_size_t index)
+st_bool_t st_array_use_index(st_array_t *this)
 {
-    st_link_t *cur_link = st_array_get_link(this, index);
+    st_malloc_mark_t mark;
+    st_index_t *index;
+    st_link_t *link;
+
+    if (this->index != NULL) {
+        return TRUE;
+    }
+    if (this->unrolled) {
+        return FALSE;
+    }
+
+    // An index that does not fit is rolled back, so the heap is not left in its sticky overflow
+    st_malloc_mark(this->malloc, &mark);
+    if ((index = st_index_new(this->malloc, this->size)) == NULL) {
+        st_malloc_rewind(this->malloc, &mark);
+        return FALSE;
+    }
+
+    // The index has room for every link, so the inserts can not fail
+    ST_ARRAY_FOREACH(this, link) {
+        if (link->key != NULL) {
+            st_index_insert(index, link);
+        }
+    }
+    this->index = index;
+    return TRUE;
+}
+
+void st_array_set_index_threshold(st_array_t *this, st_size_t threshold)
+{
+    this->index_threshold = threshold;
+}
+
+/* Indexes an array that the last link or splice took past its threshold */
+static void _st_array_check_index(st_array_t *this)
+{
+    if (this->index_threshold > 0 && this->index == NULL && this->size > this->index_threshold) {
+        st_array_use_index(this);
+    }
+}
+
+/* The keys of a keyed block follow its objects */
+#define ST_ARRAY_BLOCK_KEYS(block) ((block)->slots + ST_ARRAY_BLOCK_SLOTS)
+
+static st_size_t _st_array_block_size(st_array_t *this)
+{
+    return ST_SIZE(sizeof(st_array_block_t) + (this->keyed?2:1) * ST_ARRAY_BLOCK_SLOTS * sizeof(st_object_t *));
+}
+
+/* Allocates an empty block and chains it after "prev" (at the front if "prev" is NULL) */
+static st_array_block_t *_st_array_block_new(st_array_t *this, st_array_block_t *prev)
+{
+    st_array_block_t *block = st_malloc_struct(this->malloc, _st_array_block_size(this));
+
+    if (block == NULL) {
+        return NULL;
+    }
+
+    block->count = 0;
+    block->prev = prev;
+    block->next = (prev != NULL)?prev->next:this->first_block;
+    if (block->next == NULL) {
+        this->last_block = block;
+    }
+    else {
+        block->next->prev = block;
+    }
+    if (prev == NULL) {
+        this->first_block = block;
+    }
+    else {
+        prev->next = block;
+    }
+    return block;
+}
+
+static void _st_array_block_free(st_array_t *this, st_array_block_t *block)
+{
+    if (block->prev == NULL) {
+        this->first_block = block->next;
+    }
+    else {
+        block->prev->next = block->next;
+    }
+    if (block->next == NULL) {
+        this->last_block = block->prev;
+    }
+    else {
+        block->next->prev = block->prev;
+    }
+    st_malloc_recycle(this->malloc, block, _st_array_block_size(this));
+}
+
+/* Copies "count" entries of "src" from "src_slot" to "dst_slot" of "dst" (the ranges may overlap) */
+static void _st_array_block_move(st_array_t *this, st_array_block_t *dst, int dst_slot,
+                                 st_array_block_t *src, int src_slot, int count)
+{
+    memmove(dst->slots + dst_slot, src->slots + src_slot, count * sizeof(st_object_t *));
+    if (this->keyed) {
+        memmove(ST_ARRAY_BLOCK_KEYS(dst) + dst_slot, ST_ARRAY_BLOCK_KEYS(src) + src_slot,
+                count * sizeof(st_object_t *));
+    }
+}
+
+/* Finds the block holding "index" by skipping whole blocks from the nearer end */
+static st_array_block_t *_st_array_block_find(st_array_t *this, st_size_t index, uint8_t *slot)
+{
+    st_array_block_t *block;
+    st_size_t end;
+
+    if (index >= this->size) {
+        return NULL;
+    }
+
+    if (index < this->size / 2) {
+        for (block = this->first_block; index >= block->count; block = block->next) {
+            index -= block->count;
+        }
+    }
+    else {
+        for (block = this->last_block, end = this->size - block->count; index < end; ) {
+            block = block->prev;
+            end -= block->count;
+        }
+        index -= end;
+    }
+    *slot = (uint8_t)index;
+    return block;
+}
+
+/* Moves an unrolled position one entry forward (or back if "reverse"), NULL past either end */
+static st_array_block_t *_st_array_block_step(st_array_block_t *block, uint8_t *slot, st_bool_t reverse)
+{
+    if (!reverse) {
+        if (*slot + 1 < block->count) {
+            (*slot)++;
+            return block;
+        }
+        *slot = 0;
+        return block->next;
+    }
+
+    if (*slot > 0) {
+        (*slot)--;
+        return block;
+    }
+    block = block->prev;
+    *slot = (block != NULL)?block->count - 1:0;
+    return block;
+}
+
+/**
+ * Inserts an entry at "*slot" of "block" (NULL to append).  A full block is
+ * split in half unless the entry goes to its end and the next block has room.
+ * "*slot" is set to the slot of the new entry in the returned block.
+ */
+static st_array_block_t *_st_array_block_insert(st_array_t *this, st_array_block_t *block, uint8_t *slot,
+                                                st_object_t *key, st_object_t *object)
+{
+    st_array_block_t *next;
+    int half = ST_ARRAY_BLOCK_SLOTS / 2;
+
+    if (block == NULL) {
+        block = this->last_block;
+        *slot = (block != NULL)?block->count:0;
+    }
+
+    if (block == NULL || (*slot == block->count && block->count == ST_ARRAY_BLOCK_SLOTS)) {
+        // Appending to a full block starts the next one
+        next = (block != NULL)?block->next:NULL;
+        if (next == NULL || next->count == ST_ARRAY_BLOCK_SLOTS) {
+            next = _st_array_block_new(this, block);
+        }
+        if (next == NULL) {
+            return NULL;
+        }
+        block = next;
+        *slot = 0;
+    }
+    else if (block->count == ST_ARRAY_BLOCK_SLOTS) {
+        if ((next = _st_array_block_new(this, block)) == NULL) {
+            return NULL;
+        }
+        _st_array_block_move(this, next, 0, block, half, ST_ARRAY_BLOCK_SLOTS - half);
+        next->count = ST_ARRAY_BLOCK_SLOTS - half;
+        block->count = half;
+        if (*slot > half) {
+            block = next;
+            *slot -= half;
+        }
+    }
+
+    _st_array_block_move(this, block, *slot + 1, block, *slot, block->count - *slot);
+    block->slots[*slot] = object;
+    if (this->keyed) {
+        ST_ARRAY_BLOCK_KEYS(block)[*slot] = key;
+    }
+    block->count++;
+    this->size++;
+    return block;
+}
+
+/**
+ * Removes the entry at "*slot" of "block".  An emptied block is freed and a
+ * block that falls below half full is merged with the next one if they fit.
+ * Returns the block and "*slot" of the entry that followed (NULL at the end).
+ */
+static st_array_block_t *_st_array_block_remove(st_array_t *this, st_array_block_t *block, uint8_t *slot)
+{
+    st_array_block_t *next = block->next;
+
+    block->count--;
+    this->size--;
+    _st_array_block_move(this, block, *slot, block, *slot + 1, block->count - *slot);
+
+    if (block->count == 0) {
+        _st_array_block_free(this, block);
+        *slot = 0;
+        return next;
+    }
+
+    if (next != NULL && block->count < ST_ARRAY_BLOCK_SLOTS / 2 && block->count + next->count <= ST_ARRAY_BLOCK_SLOTS) {
+        _st_array_block_move(this, block, block->count, next, 0, next->count);
+        block->count += next->count;
+        _st_array_block_free(this, next);
+    }
+
+    if (*slot == block->count) {
+        *slot = 0;
+        return block->next;
+    }
+    return block;
+}
+
+static st_bool_t _st_array_unrolled_insert(st_array_t *this, st_object_t *key, st_object_t *object, st_size_t index)
+{
+    st_array_block_t *block = NULL;
+    uint8_t slot = 0;
+
+    if (ST_ARRAY_READ_ONLY(this) || index > this->size) {
+        return FALSE;
+    }
+    if (index < this->size) {
+        block = _st_array_block_find(this, index, &slot);
+    }
+    return _st_array_block_insert(this, block, &slot, key, object) != NULL;
+}
+
+/* Links "link" in front of "cur_link" (at "index"), or appends it if "cur_link" is NULL */
+static st_bool_t _st_array_link(st_array_t *this, st_link_t *link, st_link_t *cur_link, st_size_t index)
+{
+    if (ST_ARRAY_READ_ONLY(this) || this->unrolled || !_st_array_reserve(this, 1) ||
+        (this->index != NULL && link->key != NULL && !st_index_insert(this->index, link)))
+    {
+        return FALSE;
+    }
 
     if (cur_link == NULL) {
         // Append operation
+        index = this->size;
         cur_link = this->last;
         link->prev = cur_link;
         link->next = NULL;
@@ -81,24 +441,31 @@ st_bool_t st_array_insert_link(st_array_t *this, st_link_t *link, st_size_t inde
         }
     }
 
+    if (this->slots != NULL) {
+        memmove(this->slots + index + 1, this->slots + index, (this->size - index) * sizeof(st_link_t *));
+        this->slots[index] = link;
+    }
     this->size++;
 
+    _st_array_check_index(this);
     return TRUE;
 }
 
+st_bool_t st_array_insert_link(st_array_t *this, st_link_t *link, st_size_t index)
+{
+    return _st_array_link(this, link, st_array_get_link(this, index), index);
+}
+
 st_bool_t st_array_append_link(st_array_t *this, st_link_t *link)
 {
     return st_array_insert_link(this, link, st_array_get_size(this));
 }
 
-st_bool_t st_array_remove_link(st_array_t *this, st_size_t index)
+static void _st_array_unlink(st_array_t *this, st_link_t *cur_link, st_size_t index)
 {
-    st_link_t *cur_link = st_array_get_link(this, index);
-
-    if (cur_link == NULL) {
-        return FALSE;
+    if (this->index != NULL && cur_link->key != NULL) {
+        st_index_remove(this->index, cur_link);
     }
-
     if (cur_link->prev == NULL) {
         this->first = cur_link->next;
     }
@@ -114,7 +481,20 @@ st_bool_t st_array_remove_link(st_array_t *this, st_size_t index)
     }
 
     this->size--;
+    if (this->slots != NULL) {
+        memmove(this->slots + index, this->slots + index + 1, (this->size - index) * sizeof(st_link_t *));
+    }
+}
 
+st_bool_t st_array_remove_link(st_array_t *this, st_size_t index)
+{
+    st_link_t *cur_link = st_array_get_link(this, index);
+
+    if (cur_link == NULL || ST_ARRAY_READ_ONLY(this)) {
+        return FALSE;
+    }
+
+    _st_array_unlink(this, cur_link, index);
     return TRUE;
 }
 
@@ -122,9 +502,12 @@ st_link_t *st_array_get_link(st_array_t *this, st_size_t index)
 {
     st_link_t *cur_link;
 
-    if (index >= st_array_get_size(this)) {
+    if (index >= st_array_get_size(this) || this->unrolled) {
         return NULL;
     }
+    if (this->slots != NULL) {
+        return this->slots[index];
+    }
 
     cur_link = this->first;
     while(index > 0) {
@@ -137,33 +520,611 @@ st_link_t *st_array_get_link(st_array_t *this, st_size_t index)
 
 st_bool_t st_array_insert_object(st_array_t *this, st_object_t *object, st_size_t index)
 {
-    st_link_t *new_link = st_link_new(this->malloc, object, NULL);
-    return st_array_insert_link(this, new_link, index);
+    st_link_t *new_link;
+
+    if (this->unrolled) {
+        return _st_array_unrolled_insert(this, NULL, object, index);
+    }
+    new_link = (!ST_ARRAY_READ_ONLY(this))?st_link_new(this->malloc, object, NULL):NULL;
+    return (new_link != NULL)?st_array_insert_link(this, new_link, index):FALSE;
 }
 
 st_bool_t st_array_append_object(st_array_t *this, st_object_t *object)
 {
-    st_link_t *new_link = st_link_new(this->malloc, object, NULL);
-    return st_array_insert_link(this, new_link, st_array_get_size(this));
+    return st_array_append_entry(this, NULL, object);
+}
+
+st_bool_t st_array_append_entry(st_array_t *this, st_object_t *key, st_object_t *object)
+{
+    st_link_t *new_link;
+
+    if (this->unrolled) {
+        return _st_array_unrolled_insert(this, key, object, this->size);
+    }
+    new_link = (!ST_ARRAY_READ_ONLY(this))?st_link_new(this->malloc, object, key):NULL;
+    return (new_link != NULL)?st_array_insert_link(this, new_link, st_array_get_size(this)):FALSE;
 }
 
 st_object_t *st_array_get_object(st_array_t *this, st_size_t index)
 {
-    st_link_t *link = st_array_get_link(this, index);
+    st_array_block_t *block;
+    st_link_t *link;
+    uint8_t slot = 0;
+
+    if (this->unrolled) {
+        block = _st_array_block_find(this, index, &slot);
+        return (block != NULL)?block->slots[slot]:NULL;
+    }
+    link = st_array_get_link(this, index);
     return (link != NULL)?link->object:NULL;
 }
 
 st_bool_t st_array_remove_object(st_array_t *this, st_size_t index)
 {
-    return st_array_remove_link(this, index);
+    st_link_t *cur_link;
+    st_array_block_t *block;
+    uint8_t slot = 0;
+
+    if (this->unrolled) {
+        if (ST_ARRAY_READ_ONLY(this) || (block = _st_array_block_find(this, index, &slot)) == NULL) {
+            return FALSE;
+        }
+        _st_array_block_remove(this, block, &slot);
+        return TRUE;
+    }
+
+    cur_link = st_array_get_link(this, index);
+    if (cur_link == NULL || ST_ARRAY_READ_ONLY(this)) {
+        return FALSE;
+    }
+
+    _st_array_unlink(this, cur_link, index);
+    return TRUE;
 }
 
-st_bool_t st_array_has_link(st_array_t *this, st_link_t *link)
+/* Appends to the last block, then to new blocks that are all allocated before any entry is written */
+static st_bool_t _st_array_unrolled_append(st_array_t *this, st_object_t **objects, st_size_t count)
+{
+    st_array_block_t *last = this->last_block, *block;
+    st_size_t needed, i;
+    int n;
+
+    needed = (last != NULL)?ST_SIZE(ST_ARRAY_BLOCK_SLOTS - last->count):0;
+    for (needed = (count > needed)?ST_SIZE(count - needed):0; needed > 0;
+         needed = (needed > ST_ARRAY_BLOCK_SLOTS)?ST_SIZE(needed - ST_ARRAY_BLOCK_SLOTS):0)
+    {
+        if (_st_array_block_new(this, this->last_block) == NULL) {
+            while (this->last_block != last) {
+                _st_array_block_free(this, this->last_block);
+            }
+            return FALSE;
+        }
+    }
+
+    block = (last != NULL)?last:this->first_block;
+    for (i = 0; i < count; i += n, block = block->next) {
+        n = ST_ARRAY_BLOCK_SLOTS - block->count;
+        n = (count - i < (st_size_t)n)?(int)(count - i):n;
+        memcpy(block->slots + block->count, objects + i, n * sizeof(st_object_t *));
+        if (this->keyed) {
+            memset(ST_ARRAY_BLOCK_KEYS(block) + block->count, 0, n * sizeof(st_object_t *));
+        }
+        block->count += n;
+    }
+    this->size += count;
+    return TRUE;
+}
+
+st_bool_t st_array_append_objects(st_array_t *this, st_object_t **objects, st_size_t count)
+{
+    st_link_t *links;
+    st_size_t i;
+
+    if (ST_ARRAY_READ_ONLY(this) || count > ST_SIZE_MAX - this->size) {
+        return FALSE;
+    }
+    if (count == 0) {
+        return TRUE;
+    }
+    if (this->unrolled) {
+        return _st_array_unrolled_append(this, objects, count);
+    }
+
+    // One allocation for all of the links, each of them can still be recycled on its own
+    if (count > ST_SIZE_MAX / sizeof(st_link_t) || !_st_array_reserve(this, count) ||
+        (links = st_malloc_struct(this->malloc, ST_SIZE(count * sizeof(st_link_t)))) == NULL)
+    {
+        return FALSE;
+    }
+
+    for (i = 0; i < count; i++) {
+        links[i].object = objects[i];
+        links[i].key = NULL;
+        links[i].prev = (i > 0)?&links[i - 1]:this->last;
+        links[i].next = (i + 1 < count)?&links[i + 1]:NULL;
+        if (this->slots != NULL) {
+            this->slots[this->size + i] = &links[i];
+        }
+    }
+
+    if (this->last == NULL) {
+        this->first = links;
+    }
+    else {
+        this->last->next = links;
+    }
+    this->last = &links[count - 1];
+    this->size += count;
+    return TRUE;
+}
+
+/* Cuts the run of links out of "src" and links it in front of "index" */
+static st_bool_t _st_array_splice_links(st_array_t *this, st_size_t index, st_array_t *src, st_size_t start,
+                                        st_size_t count)
+{
+    st_link_t *first, *last, *before, *link;
+    st_size_t i;
+
+    if (!_st_array_reserve(this, count) || (this->index != NULL && !st_index_reserve(this->index, count))) {
+        return FALSE;
+    }
+
+    first = st_array_get_link(src, start);
+    if (start + count == src->size) {
+        last = src->last;
+    }
+    else {
+        last = (src->slots != NULL)?src->slots[start + count - 1]:_st_array_walk(first, ST_SIZE(count - 1));
+    }
+    before = st_array_get_link(this, index);
+
+    if (first->prev == NULL) {
+        src->first = last->next;
+    }
+    else {
+        first->prev->next = last->next;
+    }
+    if (last->next == NULL) {
+        src->last = first->prev;
+    }
+    else {
+        last->next->prev = first->prev;
+    }
+    if (src->slots != NULL) {
+        memmove(src->slots + start, src->slots + start + count, (src->size - start - count) * sizeof(st_link_t *));
+    }
+    src->size -= count;
+
+    first->prev = (before != NULL)?before->prev:this->last;
+    last->next = before;
+    if (first->prev == NULL) {
+        this->first = first;
+    }
+    else {
+        first->prev->next = first;
+    }
+    if (before == NULL) {
+        this->last = last;
+    }
+    else {
+        before->prev = last;
+    }
+    if (this->slots != NULL) {
+        memmove(this->slots + index + count, this->slots + index, (this->size - index) * sizeof(st_link_t *));
+    }
+
+    // The slots and the indexes are the only parts that are not O(1)
+    if (this->slots != NULL || this->index != NULL || src->index != NULL) {
+        for (link = first, i = 0; i < count; link = link->next, i++) {
+            if (this->slots != NULL) {
+                this->slots[index + i] = link;
+            }
+            if (link->key != NULL && src->index != NULL) {
+                st_index_remove(src->index, link);
+            }
+            if (link->key != NULL && this->index != NULL) {
+                st_index_insert(this->index, link);
+            }
+        }
+    }
+    this->size += count;
+
+    _st_array_check_index(this);
+    return TRUE;
+}
+
+/* Moves whole blocks when "src" is appended, otherwise moves the entries one by one */
+static st_bool_t _st_array_splice_blocks(st_array_t *this, st_size_t index, st_array_t *src, st_size_t start,
+                                         st_size_t count)
 {
+    st_array_block_t *src_block, *block = NULL;
+    uint8_t src_slot = 0, slot = 0;
+    st_object_t *key;
     st_size_t i;
-    for(i=0; i<st_array_get_size(this); i++)
+
+    if (index == this->size && count == src->size) {
+        src->first_block->prev = this->last_block;
+        if (this->last_block == NULL) {
+            this->first_block = src->first_block;
+        }
+        else {
+            this->last_block->next = src->first_block;
+        }
+        this->last_block = src->last_block;
+        src->first_block = NULL;
+        src->last_block = NULL;
+        src->size = 0;
+        this->size += count;
+        return TRUE;
+    }
+
+    src_block = _st_array_block_find(src, start, &src_slot);
+    if (index < this->size) {
+        block = _st_array_block_find(this, index, &slot);
+    }
+    for (i = 0; i < count; i++) {
+        key = this->keyed?ST_ARRAY_BLOCK_KEYS(src_block)[src_slot]:NULL;
+        if ((block = _st_array_block_insert(this, block, &slot, key, src_block->slots[src_slot])) == NULL) {
+            return FALSE;
+        }
+        // The next entry goes in front of the one that followed (NULL keeps appending)
+        block = _st_array_block_step(block, &slot, FALSE);
+        src_block = _st_array_block_remove(src, src_block, &src_slot);
+    }
+    return TRUE;
+}
+
+st_bool_t st_array_splice(st_array_t *this, st_size_t index, st_array_t *src, st_size_t start, st_size_t count)
+{
+    if (this == src || ST_ARRAY_READ_ONLY(this) || ST_ARRAY_READ_ONLY(src) || this->malloc != src->malloc ||
+        this->unrolled != src->unrolled || this->keyed != src->keyed || index > this->size ||
+        start > src->size || count > src->size - start || count > ST_SIZE_MAX - this->size)
     {
-        if (st_array_get_link(this, i) == link) {
+        return FALSE;
+    }
+    if (count == 0) {
+        return TRUE;
+    }
+    return this->unrolled?_st_array_splice_blocks(this, index, src, start, count):
+                          _st_array_splice_links(this, index, src, start, count);
+}
+
+st_bool_t st_array_concat(st_array_t *this, st_array_t *src)
+{
+    return st_array_splice(this, this->size, src, 0, src->size);
+}
+
+st_array_t *st_array_slice(st_array_t *this, st_size_t start, st_size_t count)
+{
+    st_array_t *view;
+
+    if (this->unrolled || start > this->size || count > this->size - start ||
+        (view = st_array_new(this->malloc)) == NULL)
+    {
+        return NULL;
+    }
+
+    view->view = TRUE;
+    view->size = count;
+    if (count > 0) {
+        view->first = st_array_get_link(this, start);
+        view->last = (this->slots != NULL)?this->slots[start + count - 1]:_st_array_walk(view->first, ST_SIZE(count - 1));
+    }
+    if (this->slots != NULL) {
+        view->slots = this->slots + start;
+        view->capacity = count;
+    }
+    return view;
+}
+
+/* Merges two sorted "next" chains, "left" holds the older links and wins ties to keep the sort stable */
+static st_link_t *_st_array_merge(st_link_t *left, st_link_t *right, st_object_order_t order, st_bool_t by_key)
+{
+    st_link_t *list = NULL, **tail = &list;
+
+    while (left != NULL && right != NULL) {
+        if ((by_key?order(right->key, left->key):order(right->object, left->object)) < 0) {
+            *tail = right;
+            right = right->next;
+        }
+        else {
+            *tail = left;
+            left = left->next;
+        }
+        tail = &(*tail)->next;
+    }
+    *tail = (left != NULL)?left:right;
+    return list;
+}
+
+/**
+ * Merge sort of the "next" chain.  Bin "i" holds a sorted run of 2^i links,
+ * every link is merged into the bins like a carry into a binary counter, so
+ * the recently merged links are still in the cache and nothing is allocated.
+ * The "prev" links (and the slots in vector mode) are restored at the end.
+ */
+static st_bool_t _st_array_sort(st_array_t *this, st_object_order_t order, st_bool_t by_key)
+{
+    st_link_t *bins[ST_SIZE_BITS + 1], *link, *next, *carry;
+    st_size_t index = 0;
+    int i, used = 0;
+
+    if (ST_ARRAY_READ_ONLY(this) || this->unrolled) {
+        return FALSE;
+    }
+    order = (order != NULL)?order:st_object_order;
+
+    for (link = this->first; link != NULL; link = next) {
+        next = link->next;
+        link->next = NULL;
+
+        for (i = 0, carry = link; i < used && bins[i] != NULL; i++) {
+            carry = _st_array_merge(bins[i], carry, order, by_key);
+            bins[i] = NULL;
+        }
+        bins[i] = carry;
+        used = (i == used)?used + 1:used;
+    }
+
+    // The higher bins hold the older links
+    for (i = 0, carry = NULL; i < used; i++) {
+        carry = (bins[i] != NULL)?_st_array_merge(bins[i], carry, order, by_key):carry;
+    }
+
+    this->first = carry;
+    for (link = carry, next = NULL; link != NULL; next = link, link = link->next) {
+        link->prev = next;
+        if (this->slots != NULL) {
+            this->slots[index++] = link;
+        }
+    }
+    this->last = next;
+    return TRUE;
+}
+
+st_bool_t st_array_sort(st_array_t *this, st_object_order_t order)
+{
+    return _st_array_sort(this, order, FALSE);
+}
+
+st_bool_t st_array_sort_keys(st_array_t *this, st_object_order_t order)
+{
+    return _st_array_sort(this, order, TRUE);
+}
+
+void st_array_cursor_init(st_array_cursor_t *this, st_array_t *array, st_bool_t reverse)
+{
+    this->array = array;
+    this->reverse = reverse;
+    this->link = reverse?array->last:array->first;
+    this->index = reverse?ST_SIZE(array->size - 1):0;
+    this->block = reverse?array->last_block:array->first_block;
+    this->slot = (reverse && this->block != NULL)?this->block->count - 1:0;
+}
+
+st_bool_t st_array_cursor_at_end(st_array_cursor_t *this)
+{
+    return this->array->unrolled?this->block == NULL:this->link == NULL;
+}
+
+st_object_t *st_array_cursor_get_object(st_array_cursor_t *this)
+{
+    if (this->array->unrolled) {
+        return (this->block != NULL)?this->block->slots[this->slot]:NULL;
+    }
+    return (this->link != NULL)?this->link->object:NULL;
+}
+
+st_object_t *st_array_cursor_get_key(st_array_cursor_t *this)
+{
+    if (this->array->unrolled) {
+        return (this->block != NULL && this->array->keyed)?ST_ARRAY_BLOCK_KEYS(this->block)[this->slot]:NULL;
+    }
+    return (this->link != NULL)?this->link->key:NULL;
+}
+
+st_link_t *st_array_cursor_next(st_array_cursor_t *this)
+{
+    if (this->array->unrolled) {
+        if (this->block != NULL) {
+            this->block = _st_array_block_step(this->block, &this->slot, this->reverse);
+            this->index = this->reverse?ST_SIZE(this->index - 1):ST_SIZE(this->index + 1);
+        }
+        return NULL;
+    }
+
+    // The walk stops at the ends of the array, not at the end of the chain, so that it works for views
+    if (this->link != NULL) {
+        this->link = (this->link == (this->reverse?this->array->first:this->array->last))?NULL:
+                     (this->reverse?this->link->prev:this->link->next);
+        this->index = this->reverse?ST_SIZE(this->index - 1):ST_SIZE(this->index + 1);
+    }
+    return this->link;
+}
+
+/* The unrolled variant of "st_array_cursor_prev", returns "FALSE" if the cursor stays */
+static st_bool_t _st_array_cursor_prev_unrolled(st_array_cursor_t *this)
+{
+    st_array_t *array = this->array;
+    st_array_block_t *block;
+    uint8_t slot = this->slot;
+
+    if (this->block == NULL) {
+        block = this->reverse?array->first_block:array->last_block;
+        slot = (!this->reverse && block != NULL)?block->count - 1:0;
+    }
+    else {
+        block = _st_array_block_step(this->block, &slot, !this->reverse);
+    }
+    if (block == NULL) {
+        return FALSE;
+    }
+
+    this->index = (this->block == NULL)?(this->reverse?0:ST_SIZE(array->size - 1)):
+                  (this->reverse?ST_SIZE(this->index + 1):ST_SIZE(this->index - 1));
+    this->block = block;
+    this->slot = slot;
+    return TRUE;
+}
+
+st_link_t *st_array_cursor_prev(st_array_cursor_t *this)
+{
+    st_link_t *link;
+
+    if (this->array->unrolled) {
+        _st_array_cursor_prev_unrolled(this);
+        return NULL;
+    }
+
+    // Stepping back from the end returns to the last link visited
+    if (this->link == NULL) {
+        link = this->reverse?this->array->first:this->array->last;
+        this->index = this->reverse?0:ST_SIZE(this->array->size - 1);
+    }
+    else {
+        link = (this->link == (this->reverse?this->array->last:this->array->first))?NULL:
+               (this->reverse?this->link->next:this->link->prev);
+        this->index = this->reverse?ST_SIZE(this->index + 1):ST_SIZE(this->index - 1);
+    }
+
+    // Stepping back from the first link leaves the cursor where it was
+    if (link == NULL && this->link != NULL) {
+        this->index = this->reverse?ST_SIZE(this->index - 1):ST_SIZE(this->index + 1);
+        return NULL;
+    }
+    this->link = link;
+    return link;
+}
+
+/* The unrolled variant of "st_array_cursor_remove" */
+static st_bool_t _st_array_cursor_remove_unrolled(st_array_cursor_t *this)
+{
+    st_array_block_t *prev;
+    uint8_t prev_slot = this->slot;
+
+    if (this->block == NULL || ST_ARRAY_READ_ONLY(this->array)) {
+        return FALSE;
+    }
+
+    // The entries before the removed one are neither moved nor merged away
+    if (this->reverse) {
+        prev = _st_array_block_step(this->block, &prev_slot, TRUE);
+        _st_array_block_remove(this->array, this->block, &this->slot);
+        this->block = prev;
+        this->slot = prev_slot;
+        this->index--;
+    }
+    else {
+        this->block = _st_array_block_remove(this->array, this->block, &this->slot);
+    }
+    return TRUE;
+}
+
+/* Removes the current link, "recycle" hands it back to the free lists */
+static st_bool_t _st_array_cursor_remove(st_array_cursor_t *this, st_bool_t recycle)
+{
+    st_link_t *link = this->link;
+
+    if (this->array->unrolled) {
+        return _st_array_cursor_remove_unrolled(this);
+    }
+
+    if (link == NULL || ST_ARRAY_READ_ONLY(this->array)) {
+        return FALSE;
+    }
+
+    // The cursor moves on to the link that follows in its direction
+    this->link = this->reverse?link->prev:link->next;
+    _st_array_unlink(this->array, link, this->index);
+    if (recycle) {
+        st_link_free(this->array->malloc, link);
+    }
+    if (this->reverse) {
+        this->index--;
+    }
+    return TRUE;
+}
+
+st_bool_t st_array_cursor_remove(st_array_cursor_t *this)
+{
+    return _st_array_cursor_remove(this, FALSE);
+}
+
+/* The unrolled variant of "st_array_cursor_insert" */
+static st_bool_t _st_array_cursor_insert_unrolled(st_array_cursor_t *this, st_object_t *object)
+{
+    st_array_t *array = this->array;
+    st_array_block_t *block = this->block;
+    uint8_t slot = this->slot;
+
+    if (ST_ARRAY_READ_ONLY(array)) {
+        return FALSE;
+    }
+
+    // The new entry goes in front of the current one, or behind it in reverse
+    if (this->reverse) {
+        if (block == NULL) {
+            block = array->first_block;
+        }
+        else {
+            slot++;
+        }
+    }
+
+    if ((block = _st_array_block_insert(array, block, &slot, NULL, object)) == NULL) {
+        return FALSE;
+    }
+
+    // A split may have moved the current entry, it is the neighbour of the new one
+    if (this->block != NULL) {
+        this->block = _st_array_block_step(block, &slot, this->reverse);
+        this->slot = slot;
+    }
+    if (!this->reverse) {
+        this->index++;
+    }
+    return TRUE;
+}
+
+st_bool_t st_array_cursor_insert(st_array_cursor_t *this, st_object_t *object)
+{
+    st_array_t *array = this->array;
+    st_link_t *new_link, *before;
+    st_size_t index;
+
+    if (array->unrolled) {
+        return _st_array_cursor_insert_unrolled(this, object);
+    }
+
+    if (ST_ARRAY_READ_ONLY(array) || (new_link = st_link_new(array->malloc, object, NULL)) == NULL) {
+        return FALSE;
+    }
+
+    // The new link is visited right before the current one
+    if (!this->reverse) {
+        before = this->link;
+        index = (before != NULL)?this->index:array->size;
+    }
+    else {
+        before = (this->link != NULL)?this->link->next:array->first;
+        index = ST_SIZE(this->index + 1);
+    }
+
+    if (!_st_array_link(array, new_link, before, index)) {
+        return FALSE;
+    }
+    if (!this->reverse) {
+        this->index++;
+    }
+    return TRUE;
+}
+
+st_bool_t st_array_has_link(st_array_t *this, st_link_t *link)
+{
+    st_link_t *cur_link;
+
+    ST_ARRAY_FOREACH(this, cur_link) {
+        if (cur_link == link) {
             return TRUE;
         }
     }
@@ -172,12 +1133,20 @@ st_bool_t st_array_has_link(st_array_t *this, st_link_t *link)
 
 st_bool_t st_array_has_object(st_array_t *this, st_object_t *object)
 {
-    st_size_t i;
+    st_array_block_t *block;
     st_link_t *link;
-    for(i=0; i<st_array_get_size(this); i++)
-    {
-        link = st_array_get_link(this, i);
-        if (link != NULL && link->object == object) {
+    int i;
+
+    for (block = this->first_block; block != NULL; block = block->next) {
+        for (i = 0; i < block->count; i++) {
+            if (block->slots[i] == object) {
+                return TRUE;
+            }
+        }
+    }
+
+    ST_ARRAY_FOREACH(this, link) {
+        if (link->object == object) {
             return TRUE;
         }
     }
@@ -186,14 +1155,115 @@ st_bool_t st_array_has_object(st_array_t *this, st_object_t *object)
 
 st_bool_t st_array_has_key(st_array_t *this, st_object_t *key)
 {
-    st_size_t i;
+    st_array_block_t *block;
+    st_object_t *cur_key;
     st_link_t *link;
-    for(i=0; i<st_array_get_size(this); i++)
-    {
-        link = st_array_get_link(this, i);
-        if (link != NULL && st_object_compare(key, link->key)) {
+    int i;
+
+    if (this->index != NULL) {
+        return ST_BOOL(st_index_find(this->index, key) != NULL);
+    }
+
+    // Objects appended without a key have a NULL key, like links
+    for (block = this->keyed?this->first_block:NULL; block != NULL; block = block->next) {
+        for (i = 0; i < block->count; i++) {
+            if ((cur_key = ST_ARRAY_BLOCK_KEYS(block)[i]) != NULL && st_object_compare(key, cur_key)) {
+                return TRUE;
+            }
+        }
+    }
+
+    ST_ARRAY_FOREACH(this, link) {
+        if (link->key != NULL && st_object_compare(key, link->key)) {
             return TRUE;
         }
     }
     return FALSE;
 }
+
+st_link_t *st_array_find_key(st_array_t *this, st_object_t *key)
+{
+    st_link_t *link;
+
+    if (this->index != NULL) {
+        return st_index_find(this->index, key);
+    }
+
+    ST_ARRAY_FOREACH(this, link) {
+        if (link->key != NULL && st_object_compare(key, link->key)) {
+            return link;
+        }
+    }
+    return NULL;
+}
+
+static st_bool_t _st_array_remove_key(st_array_t *this, st_object_t *key, st_bool_t recycle)
+{
+    st_array_cursor_t cursor;
+    st_object_t *cur_key;
+    st_link_t *link;
+    st_size_t index = 0;
+
+    if (ST_ARRAY_READ_ONLY(this)) {
+        return FALSE;
+    }
+
+    // A vector still needs the position of the link for its slots
+    if (this->index != NULL) {
+        if ((link = st_index_find(this->index, key)) == NULL) {
+            return FALSE;
+        }
+        while (this->slots != NULL && this->slots[index] != link) {
+            index++;
+        }
+        _st_array_unlink(this, link, index);
+        if (recycle) {
+            st_link_free(this->malloc, link);
+        }
+        return TRUE;
+    }
+
+    ST_ARRAY_CURSOR_FOREACH(&cursor, this) {
+        if ((cur_key = st_array_cursor_get_key(&cursor)) != NULL && st_object_compare(key, cur_key)) {
+            return _st_array_cursor_remove(&cursor, recycle);
+        }
+    }
+    return FALSE;
+}
+
+st_bool_t st_array_replace_key(st_array_t *this, st_object_t *key, st_object_t *object)
+{
+    st_array_cursor_t cursor;
+    st_object_t *cur_key;
+    st_link_t *link;
+
+    if (ST_ARRAY_READ_ONLY(this)) {
+        return FALSE;
+    }
+
+    if (this->unrolled) {
+        ST_ARRAY_CURSOR_FOREACH(&cursor, this) {
+            if ((cur_key = st_array_cursor_get_key(&cursor)) != NULL && st_object_compare(key, cur_key)) {
+                cursor.block->slots[cursor.slot] = object;
+                return TRUE;
+            }
+        }
+        return FALSE;
+    }
+
+    if ((link = st_array_find_key(this, key)) == NULL) {
+        return FALSE;
+    }
+    link->object = object;
+    return TRUE;
+}
+
+st_bool_t st_array_remove_key(st_array_t *this, st_object_t *key)
+{
+    return _st_array_remove_key(this, key, FALSE);
+}
+
+st_bool_t st_array_recycle_key(st_array_t *this, st_object_t *key)
+{
+    return _st_array_remove_key(this, key, TRUE);
+}
@@ -28,36 +28,276 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef __ST_OBJECTS_ST_ARRAY_H__
 #define __ST_OBJECTS_ST_ARRAY_H__
 
-#include "st_link.h"
+#include "st_index.h"
 
+/**
+ * A block of an unrolled array.  "slots" holds "count" objects followed, for
+ * a dict, by their keys at "slots[ST_ARRAY_BLOCK_SLOTS + i]".
+ */
+typedef struct st_array_block_s
+{
+    struct st_array_block_s *prev;
+    struct st_array_block_s *next;
+    uint8_t count;
+    st_object_t *slots[];
+} st_array_block_t;
+
+/**
+ * A doubly linked list of links.  In vector mode "slots" additionally holds
+ * the links in order, so indexing is O(1) instead of a walk from "first".
+ * The links stay chained either way so that code walking "first"/"next"
+ * works in both modes.  An unrolled array has no links at all, its objects
+ * are stored in the chain of blocks from "first_block" instead.
+ */
 typedef struct st_array_s
 {
     st_link_t *first;
     st_link_t *last;
     st_size_t size;
+    uint32_t hash;
+    st_bool_t frozen;
+    st_bool_t view;
+    st_bool_t unrolled;
+    st_bool_t keyed;
     st_malloc_t *malloc;
+    st_link_t **slots;
+    st_size_t capacity;
+    st_array_block_t *first_block;
+    st_array_block_t *last_block;
+    st_index_t *index;
+    st_size_t index_threshold;
 } st_array_t;
 
 st_array_t *st_array_new(st_malloc_t *malloc);
 void st_array_init(st_array_t *this);
 
+/**
+ * Creates an array in vector mode (see "st_array_use_vector")
+ * @param malloc Pointer to the st_malloc instance
+ * @param capacity The number of slots to reserve (can be 0)
+ * @return Pointer to the array (or NULL)
+ */
+st_array_t *st_array_new_vector(st_malloc_t *malloc, st_size_t capacity);
+
+/**
+ * Switches an array to vector mode.  The links are indexed by a contiguous
+ * buffer of slots in the heap, so get is O(1), append is amortized O(1) and
+ * insert and remove move the slots after the index with memmove.  When the
+ * buffer is full it is replaced by one twice the size and the old one is
+ * left to the heap.  An array can not be switched back.
+ * @param this Pointer to the array
+ * @param capacity The number of slots to reserve (at least the current size)
+ * @return "TRUE" if the array is in vector mode, "FALSE" if the heap is full
+ */
+st_bool_t st_array_use_vector(st_array_t *this, st_size_t capacity);
+
 st_size_t st_array_get_size(st_array_t *this);
 
-/* Link Manipulation Methods */
+/**
+ * Indexes the keyed links of an array in a hash index (see "st_index_t"), so
+ * that "st_array_find_key" and "st_array_remove_key" (and with them the dict
+ * lookups) no longer walk the links.  Every link that is linked or unlinked
+ * afterwards updates the index.  Unrolled arrays can not be indexed.  If the
+ * index does not fit the heap is rewound, it stays usable and not overflowed.
+ * @param this Pointer to the array
+ * @return "TRUE" if the array is indexed, "FALSE" if the heap is full or the array is unrolled
+ */
+st_bool_t st_array_use_index(st_array_t *this);
+
+/**
+ * Makes an array index itself (see "st_array_use_index") once any insert,
+ * append or splice takes it past "threshold" links.  It stays a list if the
+ * heap is full at that point, the next link tries again.
+ * @param this Pointer to the array
+ * @param threshold The number of links, 0 never indexes the array
+ */
+void st_array_set_index_threshold(st_array_t *this, st_size_t threshold);
+
+/**
+ * Creates an unrolled array.  Its objects (and keys) are stored in blocks of
+ * ST_ARRAY_BLOCK_SLOTS pointers, so an element costs one or two pointers
+ * instead of a link and walking the array reads consecutive pointers instead
+ * of following one link per element.
+ * Indexing skips whole blocks, inserting into a full block splits it and
+ * removing merges a block that is less than half full with the next one.
+ * Unrolled arrays have no links, the link methods (and the FOREACH macros)
+ * do not apply to them and sorting is not supported, use the object methods
+ * and cursors instead.
+ * @param malloc Pointer to the st_malloc instance
+ * @param keyed "TRUE" to store a key with every object (e.g. for a dict)
+ * @return Pointer to the array (or NULL)
+ */
+st_array_t *st_array_new_unrolled(st_malloc_t *malloc, st_bool_t keyed);
+
+/* Link Manipulation Methods (all of the methods that modify the array return
+   "FALSE" once it is frozen, see "st_object_set_frozen") */
 st_bool_t st_array_insert_link(st_array_t *this, st_link_t *link, st_size_t index);
 st_bool_t st_array_append_link(st_array_t *this, st_link_t *link);
 st_link_t *st_array_get_link(st_array_t *this, st_size_t index);
 st_bool_t st_array_remove_link(st_array_t *this, st_size_t index);
 
-/* Object Manipulation Methods */
+/* Object Manipulation Methods (the links are allocated by the array, removing
+   an object leaves its link to the heap like "st_array_remove_link" does) */
 st_bool_t st_array_insert_object(st_array_t *this, st_object_t *object, st_size_t index);
 st_bool_t st_array_append_object(st_array_t *this, st_object_t *object);
 st_object_t *st_array_get_object(st_array_t *this, st_size_t index);
 st_bool_t st_array_remove_object(st_array_t *this, st_size_t index);
 
+/* Appends an object with a key (the key is dropped by an unrolled array that is not keyed) */
+st_bool_t st_array_append_entry(st_array_t *this, st_object_t *key, st_object_t *object);
+
+/* Bulk Methods (the arrays must share their st_malloc instance and storage mode, lists and vectors mix) */
+
+/**
+ * Appends "count" objects, the links are allocated in one contiguous block
+ * (and the slots of a vector are reserved once)
+ * @param this Pointer to the array
+ * @param objects The objects to append
+ * @param count The number of objects
+ * @return "TRUE" if the objects were appended, "FALSE" if the heap is full (nothing is appended)
+ */
+st_bool_t st_array_append_objects(st_array_t *this, st_object_t **objects, st_size_t count);
+
+/**
+ * Moves "count" entries of "src" from "start" in front of "index" of the
+ * array.  The run of links is cut out and linked in as a whole, so the cost
+ * is finding the two positions (plus moving the slots of a vector).  An
+ * unrolled array moves its entries one by one (and keeps the ones already
+ * moved if a split runs out of heap), except for a whole array appended to
+ * another, which moves its blocks.
+ * @param this Pointer to the array
+ * @param index The index to move the entries to (the size of the array to append them)
+ * @param src Pointer to the array to take the entries from (not the array itself)
+ * @param start The index of the first entry to move
+ * @param count The number of entries to move
+ * @return "TRUE" if the entries were moved, "FALSE" (and nothing changed) if a range is out of bounds,
+ *         either array is read only or they do not match
+ */
+st_bool_t st_array_splice(st_array_t *this, st_size_t index, st_array_t *src, st_size_t start, st_size_t count);
+
+/* Moves all of the entries of "src" to the end of the array (O(1) for lists and unrolled arrays) */
+st_bool_t st_array_concat(st_array_t *this, st_array_t *src);
+
+/**
+ * Creates a read-only view of "count" entries from "start".  The view shares
+ * the links (and the slots of a vector) of the array, so it costs one
+ * st_array_t whatever its size.  Modifying the array invalidates the view.
+ * Unrolled arrays have no views.
+ * @param this Pointer to the array
+ * @param start The index of the first entry of the view
+ * @param count The number of entries in the view
+ * @return Pointer to the view (or NULL)
+ */
+st_array_t *st_array_slice(st_array_t *this, st_size_t start, st_size_t count);
+
+/**
+ * Sorts the array in place with a stable merge sort.  The links are relinked,
+ * nothing is allocated and the objects stay in their links.
+ * @param this Pointer to the array
+ * @param order The order of the objects (NULL for "st_object_order")
+ * @return "TRUE" if the array was sorted, "FALSE" if it is frozen or unrolled
+ */
+st_bool_t st_array_sort(st_array_t *this, st_object_order_t order);
+
+/* Same as "st_array_sort" but orders the links by their keys (e.g. the array of a dict) */
+st_bool_t st_array_sort_keys(st_array_t *this, st_object_order_t order);
+
+/**
+ * Walks the links of an array without indexing, e.g.
+ *   ST_ARRAY_FOREACH(array, link) { ... link->object ... }
+ * The current link must not be removed inside of the loop (use a cursor).
+ * The walks stop at "last" (and "first") so that they also work for views.
+ * Unrolled arrays have no links, walk them with ST_ARRAY_CURSOR_FOREACH.
+ */
+#define ST_ARRAY_FOREACH(array, link) \
+    for ((link) = (array)->first; (link) != NULL; (link) = ((link) == (array)->last)?NULL:(link)->next)
+#define ST_ARRAY_FOREACH_REVERSE(array, link) \
+    for ((link) = (array)->last; (link) != NULL; (link) = ((link) == (array)->first)?NULL:(link)->prev)
+
+/**
+ * A position in an array that is moved one link at a time, forward or in
+ * reverse.  It keeps the index of its link so that removing or inserting at
+ * the cursor is O(1) for lists (and a memmove for vectors).  Modifying the
+ * array other than through the cursor invalidates it.
+ */
+typedef struct st_array_cursor_s
+{
+    st_array_t *array;
+    st_link_t *link;
+    st_size_t index;
+    st_bool_t reverse;
+    st_array_block_t *block;
+    uint8_t slot;
+} st_array_cursor_t;
+
+/**
+ * Places a cursor on the first link of an array (the last one if "reverse")
+ * @param this Pointer to the cursor
+ * @param array Pointer to the array
+ * @param reverse "TRUE" to walk from the last link to the first one
+ */
+void st_array_cursor_init(st_array_cursor_t *this, st_array_t *array, st_bool_t reverse);
+
+/* Returns the current link (NULL once the cursor is past the end, always NULL for an unrolled array) */
+#define st_array_cursor_get_link(this) ((this)->link)
+
+/* Accessors that work for every kind of array */
+st_bool_t st_array_cursor_at_end(st_array_cursor_t *this);
+st_object_t *st_array_cursor_get_object(st_array_cursor_t *this);
+st_object_t *st_array_cursor_get_key(st_array_cursor_t *this);
+
+/* Walks the objects of any kind of array with a cursor */
+#define ST_ARRAY_CURSOR_FOREACH(cursor, array) \
+    for (st_array_cursor_init((cursor), (array), FALSE); !st_array_cursor_at_end(cursor); \
+         st_array_cursor_next(cursor))
+
+/* Moves the cursor one entry in its direction and returns the new current link (or NULL at the end) */
+st_link_t *st_array_cursor_next(st_array_cursor_t *this);
+
+/* Moves the cursor one link back, returns NULL (and stays) if it is on the first link
+   (always NULL for an unrolled array, read the entry with "st_array_cursor_get_object") */
+st_link_t *st_array_cursor_prev(st_array_cursor_t *this);
+
+/**
+ * Removes the current link (it is not handed back to the free lists).  The
+ * cursor moves on to the link that followed in its direction.
+ * @param this Pointer to the cursor
+ * @return "TRUE" if a link was removed
+ */
+st_bool_t st_array_cursor_remove(st_array_cursor_t *this);
+
+/**
+ * Inserts an object so that it is visited right before the current link
+ * (appended in the cursor's direction if it is past the end).  The cursor
+ * stays on the current link.
+ * @param this Pointer to the cursor
+ * @param object Pointer to the object
+ * @return "TRUE" if the object was inserted
+ */
+st_bool_t st_array_cursor_insert(st_array_cursor_t *this, st_object_t *object);
+
 /* Search Methods */
 st_bool_t st_array_has_link(st_array_t *this, st_link_t *link);
 st_bool_t st_array_has_object(st_array_t *this, st_object_t *object);
 st_bool_t st_array_has_key(st_array_t *this, st_object_t *key);
 
+/* Returns the link of a key (NULL if there is none or the array is unrolled) */
+st_link_t *st_array_find_key(st_array_t *this, st_object_t *key);
+
+/* Replaces the object of an existing key in place, "FALSE" if there is none or the array is read only */
+st_bool_t st_array_replace_key(st_array_t *this, st_object_t *key, st_object_t *object);
+
+/* Removes the entry of a key, "FALSE" if there is none or the array is read only */
+st_bool_t st_array_remove_key(st_array_t *this, st_object_t *key);
+
+/**
+ * Removes the entry of a key like "st_array_remove_key" and hands its link
+ * back to the free lists of the array's st_malloc instance.  Only for arrays
+ * whose links were all allocated by the array itself (e.g. the one of a dict).
+ * @param this Pointer to the array
+ * @param key Pointer to the key
+ * @return "TRUE" if an entry was removed
+ */
+st_bool_t st_array_recycle_key(st_array_t *this, st_object_t *key);
+
 #endif // __ST_OBJECTS_ST_ARRAY_H__
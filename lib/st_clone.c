@@ -0,0 +1,243 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include "st_clone.h"
+
+static st_object_t *_st_clone(st_malloc_t *malloc, st_malloc_t *owner, st_object_t *object);
+
+/* The copy of "src" is indexed if "src" is or if it is past the threshold the copy gets */
+static st_bool_t _st_clone_indexed(st_array_t *src, st_size_t threshold)
+{
+    return ST_BOOL(src->index != NULL || (threshold > 0 && src->size > threshold));
+}
+
+/* The threshold of the copy of "object" (an array or a dict) */
+static st_size_t _st_clone_threshold(st_object_t *object)
+{
+    return (st_object_get_type(object) == ST_OBJECT_TYPE_DICT)?ST_DICT_INDEX_THRESHOLD:
+                                                                st_object_get_array(object)->index_threshold;
+}
+
+/* Advances "offset" the same way st_malloc would for an allocation */
+static void _st_clone_size_add(st_size_t *offset, st_size_t size, st_size_t align)
+{
+    *offset = ST_SIZE(((*offset + align - 1) & ~(st_size_t)(align - 1)) + size);
+}
+
+static void _st_clone_size_object(st_size_t *offset, st_object_t *object)
+{
+    st_array_t *array = NULL;
+    st_typed_array_t *typed_array;
+    st_array_cursor_t cursor;
+    st_size_t capacity;
+
+    if (object == NULL) {
+        return;
+    }
+
+    // Mirrors the order of the allocations made by _st_clone
+    switch(st_object_get_type(object)) {
+#if ST_OBJECT_NAN_BOX
+        case ST_OBJECT_TYPE_LONG:
+            _st_clone_size_add(offset, sizeof(st_long_t), sizeof(st_long_t));
+            break;
+#endif
+        case ST_OBJECT_TYPE_STR:
+            _st_clone_size_add(offset, ST_SIZE(sizeof(st_object_string_t) + st_object_get_string_length(object) + 1),
+                               sizeof(st_ptr_t));
+            break;
+        case ST_OBJECT_TYPE_BLOB:
+            _st_clone_size_add(offset, ST_SIZE(sizeof(st_object_string_t) + st_object_get_blob_length(object) + 1),
+                               sizeof(st_ptr_t));
+            break;
+        case ST_OBJECT_TYPE_ARRAY:
+            array = st_object_get_array(object);
+            _st_clone_size_add(offset, sizeof(st_array_t), sizeof(st_ptr_t));
+            break;
+        case ST_OBJECT_TYPE_DICT:
+            array = st_object_get_dict(object)->array;
+            _st_clone_size_add(offset, sizeof(st_dict_t), sizeof(st_ptr_t));
+            _st_clone_size_add(offset, sizeof(st_array_t), sizeof(st_ptr_t));
+            break;
+        case ST_OBJECT_TYPE_TYPED_ARRAY:
+            typed_array = st_object_get_typed_array(object);
+            _st_clone_size_add(offset, sizeof(st_typed_array_t), sizeof(st_ptr_t));
+            if (typed_array->size > 0) {
+                // Worst case padding, the address of the data is not known in advance
+                _st_clone_size_add(offset, ST_SIZE(ST_TYPED_ARRAY_ALIGN - sizeof(st_ptr_t) +
+                                   typed_array->size * st_typed_array_get_element_size(typed_array)), 1);
+            }
+            break;
+        default:
+            break;
+    }
+
+    _st_clone_size_add(offset, sizeof(st_object_t), sizeof(st_ptr_t));
+
+    if (array == NULL) {
+        return;
+    }
+    ST_ARRAY_CURSOR_FOREACH(&cursor, array) {
+        _st_clone_size_add(offset, sizeof(st_link_t), sizeof(st_ptr_t));
+        _st_clone_size_object(offset, st_array_cursor_get_key(&cursor));
+        _st_clone_size_object(offset, st_array_cursor_get_object(&cursor));
+    }
+
+    if (_st_clone_indexed(array, _st_clone_threshold(object))) {
+        capacity = st_index_get_capacity(array->size);
+        _st_clone_size_add(offset, sizeof(st_index_t), sizeof(st_ptr_t));
+        // Worst case padding, the control bytes are aligned to a group
+        _st_clone_size_add(offset, ST_SIZE(ST_INDEX_GROUP_SIZE - sizeof(st_ptr_t) + capacity), 1);
+        _st_clone_size_add(offset, ST_SIZE(capacity * sizeof(st_link_t *)), sizeof(st_ptr_t));
+    }
+}
+
+/**
+ * Copies the entries of "src" (and the objects they hold) to the end of "dst",
+ * the copy is always linked.  "dst" is indexed once all of them are linked,
+ * instead of rehashing as it grows past "threshold".
+ */
+static st_bool_t _st_clone_links(st_malloc_t *malloc, st_malloc_t *owner, st_array_t *dst, st_array_t *src,
+                                 st_size_t threshold)
+{
+    st_array_cursor_t cursor;
+    st_object_t *key, *object;
+    st_link_t *new_link;
+
+    st_array_set_index_threshold(dst, 0);
+    ST_ARRAY_CURSOR_FOREACH(&cursor, src) {
+        new_link = st_link_new(malloc, NULL, NULL);
+        if (new_link == NULL) {
+            return FALSE;
+        }
+
+        key = st_array_cursor_get_key(&cursor);
+        object = st_array_cursor_get_object(&cursor);
+        if (key != NULL && (new_link->key = _st_clone(malloc, owner, key)) == NULL) {
+            return FALSE;
+        }
+        if (object != NULL && (new_link->object = _st_clone(malloc, owner, object)) == NULL) {
+            return FALSE;
+        }
+
+        st_array_append_link(dst, new_link);
+    }
+
+    if (_st_clone_indexed(src, threshold)) {
+        if (!st_array_use_index(dst)) {
+            return FALSE;
+        }
+        dst->index->malloc = owner;
+    }
+    st_array_set_index_threshold(dst, threshold);
+    return TRUE;
+}
+
+/**
+ * Copies "object" by allocating from "malloc".  The containers in the copy
+ * are given "owner" for their later allocations.
+ */
+static st_object_t *_st_clone(st_malloc_t *malloc, st_malloc_t *owner, st_object_t *object)
+{
+    st_object_t *copy;
+    st_array_t *array;
+    st_dict_t *dict;
+    st_typed_array_t *typed_array, *src;
+
+    switch(st_object_get_type(object)) {
+        case ST_OBJECT_TYPE_BOOL:
+            return st_object_new_bool(malloc, st_object_get_bool(object));
+        case ST_OBJECT_TYPE_INT:
+            return st_object_new_int(malloc, st_object_get_int(object));
+        case ST_OBJECT_TYPE_LONG:
+            return st_object_new_long(malloc, st_object_get_long(object));
+        case ST_OBJECT_TYPE_FLOAT:
+            return st_object_new_float(malloc, st_object_get_float(object));
+        case ST_OBJECT_TYPE_STR:
+            return st_object_new_string_n(malloc, st_object_get_string(object), st_object_get_string_length(object));
+        case ST_OBJECT_TYPE_BLOB:
+            return st_object_new_blob(malloc, st_object_get_blob(object), st_object_get_blob_length(object));
+        case ST_OBJECT_TYPE_ARRAY:
+            array = st_array_new(malloc);
+            copy = (array != NULL)?st_object_new_array(malloc, array):NULL;
+            if (copy == NULL ||
+                !_st_clone_links(malloc, owner, array, st_object_get_array(object), _st_clone_threshold(object)))
+            {
+                return NULL;
+            }
+            array->malloc = owner;
+            return copy;
+        case ST_OBJECT_TYPE_DICT:
+            dict = st_dict_new(malloc);
+            copy = (dict != NULL)?st_object_new_dict(malloc, dict):NULL;
+            if (copy == NULL || !_st_clone_links(malloc, owner, dict->array, st_object_get_dict(object)->array,
+                                                 _st_clone_threshold(object)))
+            {
+                return NULL;
+            }
+            dict->malloc = owner;
+            dict->array->malloc = owner;
+            return copy;
+        case ST_OBJECT_TYPE_TYPED_ARRAY:
+            src = st_object_get_typed_array(object);
+            typed_array = st_typed_array_new(malloc, src->type, src->size);
+            if (typed_array == NULL || !st_typed_array_append_values(typed_array, src->data, src->size)) {
+                return NULL;
+            }
+            typed_array->malloc = owner;
+            return st_object_new_typed_array(malloc, typed_array);
+        default:
+            return NULL;
+    }
+}
+
+st_object_t *st_object_clone(st_malloc_t *malloc, st_object_t *object)
+{
+    return _st_clone(malloc, malloc, object);
+}
+
+st_size_t st_object_clone_size(st_object_t *object)
+{
+    st_size_t offset = 0;
+    _st_clone_size_object(&offset, object);
+    return offset;
+}
+
+st_object_t *st_object_clone_reserved(st_malloc_t *malloc, st_object_t *object)
+{
+    st_size_t size = st_object_clone_size(object);
+    st_byte_t *block = st_malloc_struct(malloc, size);
+    st_malloc_t reserved;
+
+    if (block == NULL) {
+        return NULL;
+    }
+
+    // Build the copy inside of the reserved block, it can not overflow
+    st_malloc_init(&reserved, block, size);
+    return _st_clone(&reserved, malloc, object);
+}
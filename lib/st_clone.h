@@ -0,0 +1,65 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef __ST_OBJECTS_ST_CLONE_H__
+#define __ST_OBJECTS_ST_CLONE_H__
+
+#include "st_dict.h"
+#include "st_typed_array.h"
+
+/**
+ * Deep copies an object (strings, blobs, scalars, arrays, dicts and typed
+ * arrays) into another heap in a single linear pass.  The copy is laid out
+ * depth-first, i.e. every link is followed by the object it holds, so
+ * traversing it afterwards walks the heap forward.  Arrays and dicts in the copy allocate from "malloc".
+ * @param malloc Pointer to the destination st_malloc instance
+ * @param object Pointer to the object to copy
+ * @return Pointer to the copy (or NULL if the destination overflowed)
+ */
+st_object_t *st_object_clone(st_malloc_t *malloc, st_object_t *object);
+
+/**
+ * Returns the exact number of bytes "st_object_clone_reserved" takes from a
+ * heap (i.e. the size of the copy when it starts at pointer alignment).  With
+ * typed arrays or indexed dicts in the object it is an upper bound, their data
+ * is aligned to "ST_TYPED_ARRAY_ALIGN" (or a group of the index) and the
+ * padding is only known once it is allocated.
+ * @param object Pointer to the object to copy
+ * @return Number of bytes needed for the copy
+ */
+st_size_t st_object_clone_size(st_object_t *object);
+
+/**
+ * Same as "st_object_clone" but computes the size first and reserves the whole
+ * copy with a single allocation, so it either fits entirely or not at all.
+ * @param malloc Pointer to the destination st_malloc instance
+ * @param object Pointer to the object to copy
+ * @return Pointer to the copy (or NULL if it did not fit)
+ */
+st_object_t *st_object_clone_reserved(st_malloc_t *malloc, st_object_t *object);
+
+#endif // __ST_OBJECTS_ST_CLONE_H__
@@ -0,0 +1,110 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef __ST_OBJECTS_ST_CONFIG_H__
+#define __ST_OBJECTS_ST_CONFIG_H__
+
+/**
+ * Build-time configuration.  Every value below can be overridden on the
+ * compiler command line (e.g. "-DST_MALLOC_DEBUG=0").
+ */
+
+/* Width in bits of "st_size_t" (16, 32 or 64).  This bounds the heap size and
+   the number of elements in an array or dictionary */
+#ifndef ST_SIZE_BITS
+#define ST_SIZE_BITS 16
+#endif
+
+/* Enables extra consistency checks in st_malloc (e.g. LIFO mark/rewind order) */
+#ifndef ST_MALLOC_DEBUG
+#ifdef NDEBUG
+#define ST_MALLOC_DEBUG 0
+#else
+#define ST_MALLOC_DEBUG 1
+#endif
+#endif
+
+/* Keeps usage statistics (peak, allocation counts, padding, ...) in every
+   st_malloc instance.  Release builds pay nothing when it is disabled */
+#ifndef ST_MALLOC_STATS
+#define ST_MALLOC_STATS ST_MALLOC_DEBUG
+#endif
+
+/* Number of size classes (multiples of the pointer size) that st_malloc keeps
+   free lists for so that removed links and objects can be reused.  0
+   disables the free lists */
+#ifndef ST_MALLOC_FREE_LISTS
+#define ST_MALLOC_FREE_LISTS 4
+#endif
+
+/* Encodes every object in a single NaN-boxed 64-bit word instead of a type
+   and a value.  Doubles are stored directly, int and bool values and string
+   or container pointers are tagged NaNs and longs are boxed.  It needs
+   64-bit pointers with no more than 48 significant bits */
+#ifndef ST_OBJECT_NAN_BOX
+#define ST_OBJECT_NAN_BOX 0
+#endif
+
+/* Builds the SSE2 and AVX2 kernels of st_typed_array next to the scalar
+   ones, the best one supported by the CPU is picked at run time.  Needs an
+   x86 target and GCC or Clang */
+#ifndef ST_TYPED_ARRAY_SIMD
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define ST_TYPED_ARRAY_SIMD 1
+#else
+#define ST_TYPED_ARRAY_SIMD 0
+#endif
+#endif
+
+/* Number of objects in a block of an unrolled st_array (at most 255).  A
+   block is three words plus one pointer per object (two for dicts), with 8
+   it is 44 bytes (76 for a dict) on 32-bit and 88 bytes (152 for a dict) on
+   64-bit targets.  Blocks are only pointer aligned, so a block spans two or
+   three cache lines on 64-bit; 5 fits an array block in 64 bytes there */
+#ifndef ST_ARRAY_BLOCK_SLOTS
+#define ST_ARRAY_BLOCK_SLOTS 8
+#endif
+
+/* Matches the control bytes of an st_index group with SSE2 (part of every
+   x86-64 target), the portable loop is used everywhere else */
+#ifndef ST_INDEX_SSE2
+#if defined(__SSE2__)
+#define ST_INDEX_SSE2 1
+#else
+#define ST_INDEX_SSE2 0
+#endif
+#endif
+
+/* A dict builds a hash index over its links once it grows past this many
+   keys (see "st_array_set_index_threshold"), below it a linear scan is
+   faster and costs no memory (see "st_bench st_dict_threshold").  0 never
+   builds one */
+#ifndef ST_DICT_INDEX_THRESHOLD
+#define ST_DICT_INDEX_THRESHOLD 8
+#endif
+
+#endif // __ST_OBJECTS_ST_CONFIG_H__
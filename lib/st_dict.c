@@ -30,14 +30,34 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 st_dict_t *st_dict_new(st_malloc_t *malloc)
 {
     st_dict_t *dict = st_malloc_struct(malloc, sizeof(st_dict_t));
-    dict->malloc = malloc;
-    st_dict_init(dict);
-    return dict;
+    if (dict != NULL) {
+        dict->malloc = malloc;
+        st_dict_init(dict);
+    }
+    return (dict != NULL && dict->array != NULL)?dict:NULL;
+}
+
+st_dict_t *st_dict_new_unrolled(st_malloc_t *malloc)
+{
+    st_dict_t *dict = st_malloc_struct(malloc, sizeof(st_dict_t));
+    if (dict != NULL) {
+        dict->malloc = malloc;
+        dict->array = st_array_new_unrolled(malloc, TRUE);
+    }
+    return (dict != NULL && dict->array != NULL)?dict:NULL;
 }
 
 void st_dict_init(st_dict_t *this)
 {
     this->array = st_array_new(this->malloc);
+    if (this->array != NULL) {
+        st_array_set_index_threshold(this->array, ST_DICT_INDEX_THRESHOLD);
+    }
+}
+
+st_bool_t st_dict_use_index(st_dict_t *this)
+{
+    return st_array_use_index(this->array);
 }
 
 st_size_t st_dict_get_size(st_dict_t *this)
@@ -47,9 +67,16 @@ st_size_t st_dict_get_size(st_dict_t *this)
 
 st_bool_t st_dict_set_object(st_dict_t *this, st_object_t *key, st_object_t *object)
 {
-    st_link_t *new_link = st_link_new(this->malloc, object, key);
-    st_dict_remove_object(this, key);
-    return st_array_append_link(this->array, new_link);
+    if (this->array->frozen) {
+        return FALSE;
+    }
+
+    // An existing key keeps its entry and only the object is replaced, so an overwrite can not fail.  A new
+    // one is appended, which indexes a dict that outgrows a linear scan (see "st_array_set_index_threshold")
+    if (st_array_replace_key(this->array, key, object)) {
+        return TRUE;
+    }
+    return st_array_append_entry(this->array, key, object);
 }
 
 st_bool_t st_dict_has_key(st_dict_t *this, st_object_t *key)
@@ -59,34 +86,29 @@ st_bool_t st_dict_has_key(st_dict_t *this, st_object_t *key)
 
 st_object_t *st_dict_get_object(st_dict_t *this, st_object_t *key)
 {
-    uint16_t i;
-    st_link_t *cur_link;
-
-    for(i=0; i<st_array_get_size(this->array); i++)
-    {
-        cur_link = st_array_get_link(this->array, i);
-        if (st_object_compare(key, cur_link->key))
-        {
-            return cur_link->object;
+    st_array_cursor_t cursor;
+    st_object_t *cur_key;
+    st_link_t *link;
+
+    if (this->array->unrolled) {
+        ST_ARRAY_CURSOR_FOREACH(&cursor, this->array) {
+            if ((cur_key = st_array_cursor_get_key(&cursor)) != NULL && st_object_compare(key, cur_key)) {
+                return st_array_cursor_get_object(&cursor);
+            }
         }
+        return NULL;
     }
 
-    return NULL;
+    link = st_array_find_key(this->array, key);
+    return (link != NULL)?link->object:NULL;
 }
 
 st_bool_t st_dict_remove_object(st_dict_t *this, st_object_t *key)
 {
-    uint16_t i;
-    st_link_t *cur_link;
-
-    for(i=0; i<st_array_get_size(this->array); i++)
-    {
-        cur_link = st_array_get_link(this->array, i);
-        if (st_object_compare(key, cur_link->key))
-        {
-            st_array_remove_link(this->array, i);
-            return TRUE;
-        }
-    }
-    return FALSE;
-}
\ No newline at end of file
+    return st_array_recycle_key(this->array, key);
+}
+
+void st_dict_cursor_init(st_array_cursor_t *this, st_dict_t *dict, st_bool_t reverse)
+{
+    st_array_cursor_init(this, dict->array, reverse);
+}
@@ -37,12 +37,42 @@ typedef struct st_dict_s
 } st_dict_t;
 
 st_dict_t *st_dict_new(st_malloc_t *malloc);
+
+/* Creates a dict whose entries are stored in an unrolled array (see "st_array_new_unrolled") */
+st_dict_t *st_dict_new_unrolled(st_malloc_t *malloc);
 void st_dict_init(st_dict_t *this);
 
+/**
+ * Adds a hash index over the keys of a dict (see "st_array_use_index"), the
+ * lookups, sets and removes then probe the index instead of walking the
+ * entries.  The keys must not be modified while they are in the dict.
+ * A dict calls it by itself once a set, append, splice or clone gives it more
+ * than ST_DICT_INDEX_THRESHOLD keys, so it is only needed to index a dict earlier.
+ * @param this Pointer to the dict
+ * @return "TRUE" if the dict is indexed, "FALSE" if the heap is full or the dict is unrolled
+ */
+st_bool_t st_dict_use_index(st_dict_t *this);
+
 st_size_t st_dict_get_size(st_dict_t *this);
 st_bool_t st_dict_set_object(st_dict_t *this, st_object_t *key, st_object_t *object);
 st_bool_t st_dict_has_key(st_dict_t *this, st_object_t *key);
 st_object_t *st_dict_get_object(st_dict_t *this, st_object_t *key);
+
+/* Removes a key and hands its link back to the free lists (links added to the
+   array of a dict directly must come from "st_link_new" on the dict's heap) */
 st_bool_t st_dict_remove_object(st_dict_t *this, st_object_t *key);
 
+/* Walks the key/value links of a dict, e.g. ST_DICT_FOREACH(dict, link) { ... link->key ... }
+   (not for unrolled dicts, walk those with ST_ARRAY_CURSOR_FOREACH on the array) */
+#define ST_DICT_FOREACH(dict, link) ST_ARRAY_FOREACH((dict)->array, link)
+
+/**
+ * Places a cursor on the first entry of a dict (the last one if "reverse").
+ * "st_array_cursor_remove" removes entries, inserting is only meant for arrays.
+ * @param this Pointer to the cursor
+ * @param dict Pointer to the dict
+ * @param reverse "TRUE" to walk from the last entry to the first one
+ */
+void st_dict_cursor_init(st_array_cursor_t *this, st_dict_t *dict, st_bool_t reverse);
+
 #endif // __ST_OBJECTS_ST_DICT_H__
@@ -0,0 +1,424 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <string.h>
+#include "st_image.h"
+
+#define ST_IMAGE_ALIGN 8
+
+typedef struct st_image_writer_s
+{
+    st_byte_t *image;
+    uint64_t size;
+    uint64_t offset;
+    st_bool_t overflow;
+} st_image_writer_t;
+
+/* Reserves an aligned region of the image, without an image only the size is tracked */
+static st_image_ref_t _st_image_reserve(st_image_writer_t *writer, uint64_t size)
+{
+    uint64_t offset = (writer->offset + ST_IMAGE_ALIGN - 1) & ~(uint64_t)(ST_IMAGE_ALIGN - 1);
+
+    if (writer->overflow || offset + size > writer->size) {
+        writer->overflow = TRUE;
+        return 0;
+    }
+
+    writer->offset = offset + size;
+    return (st_image_ref_t)offset;
+}
+
+static st_image_ref_t _st_image_node(st_image_writer_t *writer, st_object_type_t type, uint32_t length,
+                                       uint64_t payload)
+{
+    st_image_ref_t ref = _st_image_reserve(writer, sizeof(st_image_node_t) + payload);
+    st_image_node_t node;
+
+    if (ref != 0 && writer->image != NULL) {
+        node.type = (uint32_t)type;
+        node.length = length;
+        memcpy(writer->image + ref, &node, sizeof(node));
+    }
+    return ref;
+}
+
+static void _st_image_write(st_image_writer_t *writer, uint64_t offset, const void *data, size_t size)
+{
+    if (!writer->overflow && writer->image != NULL) {
+        memcpy(writer->image + offset, data, size);
+    }
+}
+
+/* Writes the bytes of a string or blob, borrowed bytes are not NUL terminated so the NUL is added */
+static st_image_ref_t _st_image_bytes(st_image_writer_t *writer, st_object_type_t type, const void *data,
+                                        size_t length)
+{
+    st_image_ref_t ref = _st_image_node(writer, type, (uint32_t)length, length + 1);
+    char terminator = '\0';
+
+    _st_image_write(writer, ref + sizeof(st_image_node_t), data, length);
+    _st_image_write(writer, ref + sizeof(st_image_node_t) + length, &terminator, 1);
+    return ref;
+}
+
+static st_image_ref_t _st_image_object(st_image_writer_t *writer, st_object_t *object);
+
+/* Writes the table of a container followed by the nodes it references */
+static st_image_ref_t _st_image_container(st_image_writer_t *writer, st_object_type_t type, st_array_t *array)
+{
+    uint32_t slots = (type == ST_OBJECT_TYPE_DICT)?2:1;
+    st_image_ref_t ref = _st_image_node(writer, type, (uint32_t)array->size,
+                                          (uint64_t)array->size * slots * sizeof(st_image_ref_t));
+    uint64_t table = ref + sizeof(st_image_node_t);
+    st_image_ref_t child;
+    st_array_cursor_t cursor;
+
+    for (st_array_cursor_init(&cursor, array, FALSE); !st_array_cursor_at_end(&cursor) && !writer->overflow;
+         st_array_cursor_next(&cursor))
+    {
+        if (slots == 2) {
+            child = _st_image_object(writer, st_array_cursor_get_key(&cursor));
+            _st_image_write(writer, table, &child, sizeof(child));
+            table += sizeof(child);
+        }
+        child = _st_image_object(writer, st_array_cursor_get_object(&cursor));
+        _st_image_write(writer, table, &child, sizeof(child));
+        table += sizeof(child);
+    }
+    return ref;
+}
+
+/* Writes the element type followed by the packed elements */
+static st_image_ref_t _st_image_typed_array(st_image_writer_t *writer, st_typed_array_t *array)
+{
+    uint64_t length = (uint64_t)array->size * st_typed_array_get_element_size(array);
+    st_image_ref_t ref = _st_image_node(writer, ST_OBJECT_TYPE_TYPED_ARRAY, (uint32_t)array->size,
+                                          sizeof(uint32_t) * 2 + length);
+    uint32_t header[2] = { (uint32_t)array->type, 0 };
+
+    _st_image_write(writer, ref + sizeof(st_image_node_t), header, sizeof(header));
+    if (length > 0) {
+        _st_image_write(writer, ref + sizeof(st_image_node_t) + sizeof(header), array->data, (size_t)length);
+    }
+    return ref;
+}
+
+static st_image_ref_t _st_image_object(st_image_writer_t *writer, st_object_t *object)
+{
+    st_image_ref_t ref;
+    st_long_t value;
+    st_float_t real;
+    size_t length;
+
+    if (object == NULL) {
+        return 0;
+    }
+
+    switch(st_object_get_type(object)) {
+        case ST_OBJECT_TYPE_BOOL:
+            return _st_image_node(writer, st_object_get_type(object), st_object_get_bool(object), 0);
+        case ST_OBJECT_TYPE_INT:
+            return _st_image_node(writer, st_object_get_type(object), (uint32_t)st_object_get_int(object), 0);
+        case ST_OBJECT_TYPE_LONG:
+            value = st_object_get_long(object);
+            ref = _st_image_node(writer, st_object_get_type(object), 0, sizeof(value));
+            _st_image_write(writer, ref + sizeof(st_image_node_t), &value, sizeof(value));
+            return ref;
+        case ST_OBJECT_TYPE_FLOAT:
+            real = st_object_get_float(object);
+            ref = _st_image_node(writer, st_object_get_type(object), 0, sizeof(real));
+            _st_image_write(writer, ref + sizeof(st_image_node_t), &real, sizeof(real));
+            return ref;
+        case ST_OBJECT_TYPE_STR:
+            length = st_object_get_string_length(object);
+            return _st_image_bytes(writer, st_object_get_type(object), st_object_get_string(object), length);
+        case ST_OBJECT_TYPE_BLOB:
+            length = st_object_get_blob_length(object);
+            return _st_image_bytes(writer, st_object_get_type(object), st_object_get_blob(object), length);
+        case ST_OBJECT_TYPE_ARRAY:
+            return _st_image_container(writer, st_object_get_type(object), st_object_get_array(object));
+        case ST_OBJECT_TYPE_DICT:
+            return _st_image_container(writer, st_object_get_type(object), st_object_get_dict(object)->array);
+        case ST_OBJECT_TYPE_TYPED_ARRAY:
+            return _st_image_typed_array(writer, st_object_get_typed_array(object));
+        default:
+            return 0;
+    }
+}
+
+static st_size_t _st_image_run(st_object_t *object, st_byte_t *image, uint64_t size)
+{
+    st_image_writer_t writer = { image, size, 0, FALSE };
+    st_image_header_t header;
+
+    if (size > UINT32_MAX) {
+        writer.size = UINT32_MAX;
+    }
+
+    _st_image_reserve(&writer, sizeof(header));
+    header.magic = ST_IMAGE_MAGIC;
+    header.root = _st_image_object(&writer, object);
+    header.size = (uint32_t)writer.offset;
+    header.reserved = 0;
+
+    if (writer.overflow || writer.offset > ST_SIZE_MAX) {
+        return 0;
+    }
+
+    _st_image_write(&writer, 0, &header, sizeof(header));
+    return ST_SIZE(writer.offset);
+}
+
+st_size_t st_object_image_size(st_object_t *object)
+{
+    return _st_image_run(object, NULL, UINT32_MAX);
+}
+
+st_size_t st_object_write_image(st_object_t *object, st_byte_t *image, st_size_t size)
+{
+    return _st_image_run(object, image, size);
+}
+
+st_bool_t st_image_valid(const st_byte_t *image, st_size_t size)
+{
+    const st_image_header_t *header = (const st_image_header_t *)image;
+
+    return ST_BOOL(size >= sizeof(st_image_header_t) && header->magic == ST_IMAGE_MAGIC &&
+                   header->size <= size && header->size >= sizeof(st_image_header_t) &&
+                   st_image_get_type(image, header->root) != ST_IMAGE_TYPE_INVALID);
+}
+
+/* Reader */
+
+/* Returns the size of an element of a typed array in an image, 0 for an unknown element type */
+static uint64_t _st_image_element_size(uint32_t type)
+{
+    switch(type) {
+        case ST_TYPED_ARRAY_INT32:
+            return sizeof(int32_t);
+        case ST_TYPED_ARRAY_INT64:
+            return sizeof(int64_t);
+        case ST_TYPED_ARRAY_FLOAT64:
+            return sizeof(double);
+        case ST_TYPED_ARRAY_UINT8:
+            return sizeof(uint8_t);
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Returns the node at "ref" if it and its payload are inside of the size
+ * recorded in the header (and a string or blob is NUL terminated), otherwise
+ * NULL.  Every accessor goes through it, so a corrupted or truncated image
+ * is never read past its end.
+ */
+static const st_image_node_t *_st_image_get_node(const st_byte_t *image, st_image_ref_t ref)
+{
+    uint64_t size = ((const st_image_header_t *)image)->size;
+    uint64_t payload = (uint64_t)ref + sizeof(st_image_node_t), end;
+    const st_image_node_t *node = (const st_image_node_t *)(image + ref);
+    const uint32_t *header;
+
+    if (ref < sizeof(st_image_header_t) || ref % ST_IMAGE_ALIGN != 0 || payload > size) {
+        return NULL;
+    }
+
+    switch(node->type) {
+        case ST_OBJECT_TYPE_BOOL:
+        case ST_OBJECT_TYPE_INT:
+            end = payload;
+            break;
+        case ST_OBJECT_TYPE_LONG:
+        case ST_OBJECT_TYPE_FLOAT:
+            end = payload + sizeof(uint64_t);
+            break;
+        case ST_OBJECT_TYPE_STR:
+        case ST_OBJECT_TYPE_BLOB:
+            end = payload + node->length + 1;
+            if (end > size || image[end - 1] != '\0') {
+                return NULL;
+            }
+            break;
+        case ST_OBJECT_TYPE_ARRAY:
+            end = payload + (uint64_t)node->length * sizeof(st_image_ref_t);
+            break;
+        case ST_OBJECT_TYPE_DICT:
+            end = payload + (uint64_t)node->length * 2 * sizeof(st_image_ref_t);
+            break;
+        case ST_OBJECT_TYPE_TYPED_ARRAY:
+            header = (const uint32_t *)(node + 1);
+            if (payload + sizeof(uint32_t) * 2 > size || _st_image_element_size(header[0]) == 0) {
+                return NULL;
+            }
+            end = payload + sizeof(uint32_t) * 2 + node->length * _st_image_element_size(header[0]);
+            break;
+        default:
+            return NULL;
+    }
+    return (end <= size)?node:NULL;
+}
+
+static const st_image_ref_t *_st_image_table(const st_image_node_t *node)
+{
+    return (const st_image_ref_t *)(node + 1);
+}
+
+st_image_ref_t st_image_root(const st_byte_t *image)
+{
+    return ((const st_image_header_t *)image)->root;
+}
+
+st_object_type_t st_image_get_type(const st_byte_t *image, st_image_ref_t ref)
+{
+    const st_image_node_t *node = _st_image_get_node(image, ref);
+    return (node != NULL)?(st_object_type_t)node->type:ST_IMAGE_TYPE_INVALID;
+}
+
+st_bool_t st_image_get_bool(const st_byte_t *image, st_image_ref_t ref)
+{
+    const st_image_node_t *node = _st_image_get_node(image, ref);
+    return (node != NULL && node->type == ST_OBJECT_TYPE_BOOL)?ST_BOOL(node->length):FALSE;
+}
+
+st_int_t st_image_get_int(const st_byte_t *image, st_image_ref_t ref)
+{
+    const st_image_node_t *node = _st_image_get_node(image, ref);
+    return (node != NULL && node->type == ST_OBJECT_TYPE_INT)?(st_int_t)node->length:0;
+}
+
+st_long_t st_image_get_long(const st_byte_t *image, st_image_ref_t ref)
+{
+    const st_image_node_t *node = _st_image_get_node(image, ref);
+    return (node != NULL && node->type == ST_OBJECT_TYPE_LONG)?*(const st_long_t *)(node + 1):0;
+}
+
+st_float_t st_image_get_float(const st_byte_t *image, st_image_ref_t ref)
+{
+    const st_image_node_t *node = _st_image_get_node(image, ref);
+    return (node != NULL && node->type == ST_OBJECT_TYPE_FLOAT)?*(const st_float_t *)(node + 1):0;
+}
+
+const char *st_image_get_string(const st_byte_t *image, st_image_ref_t ref)
+{
+    const st_image_node_t *node = _st_image_get_node(image, ref);
+    return (node != NULL && node->type == ST_OBJECT_TYPE_STR)?(const char *)(node + 1):NULL;
+}
+
+const st_byte_t *st_image_get_blob(const st_byte_t *image, st_image_ref_t ref)
+{
+    const st_image_node_t *node = _st_image_get_node(image, ref);
+    return (node != NULL && node->type == ST_OBJECT_TYPE_BLOB)?(const st_byte_t *)(node + 1):NULL;
+}
+
+const void *st_image_get_typed_array(const st_byte_t *image, st_image_ref_t ref, st_typed_array_type_t *type)
+{
+    const st_image_node_t *node = _st_image_get_node(image, ref);
+    const uint32_t *header;
+
+    if (node == NULL || node->type != ST_OBJECT_TYPE_TYPED_ARRAY) {
+        return NULL;
+    }
+
+    header = (const uint32_t *)(node + 1);
+    if (type != NULL) {
+        *type = (st_typed_array_type_t)header[0];
+    }
+    return header + 2;
+}
+
+st_size_t st_image_get_size(const st_byte_t *image, st_image_ref_t ref)
+{
+    const st_image_node_t *node = _st_image_get_node(image, ref);
+
+    if (node == NULL) {
+        return 0;
+    }
+
+    switch(node->type) {
+        case ST_OBJECT_TYPE_STR:
+        case ST_OBJECT_TYPE_BLOB:
+        case ST_OBJECT_TYPE_ARRAY:
+        case ST_OBJECT_TYPE_DICT:
+        case ST_OBJECT_TYPE_TYPED_ARRAY:
+            return ST_SIZE(node->length);
+        default:
+            return 0;
+    }
+}
+
+st_image_ref_t st_image_array_get(const st_byte_t *image, st_image_ref_t ref, st_size_t index)
+{
+    const st_image_node_t *node = _st_image_get_node(image, ref);
+
+    if (node == NULL || node->type != ST_OBJECT_TYPE_ARRAY || index >= node->length) {
+        return 0;
+    }
+    return _st_image_table(node)[index];
+}
+
+st_image_ref_t st_image_dict_key(const st_byte_t *image, st_image_ref_t ref, st_size_t index)
+{
+    const st_image_node_t *node = _st_image_get_node(image, ref);
+
+    if (node == NULL || node->type != ST_OBJECT_TYPE_DICT || index >= node->length) {
+        return 0;
+    }
+    return _st_image_table(node)[index*2];
+}
+
+st_image_ref_t st_image_dict_value(const st_byte_t *image, st_image_ref_t ref, st_size_t index)
+{
+    const st_image_node_t *node = _st_image_get_node(image, ref);
+
+    if (node == NULL || node->type != ST_OBJECT_TYPE_DICT || index >= node->length) {
+        return 0;
+    }
+    return _st_image_table(node)[index*2 + 1];
+}
+
+st_image_ref_t st_image_dict_get_n(const st_byte_t *image, st_image_ref_t ref, const char *key, st_size_t length)
+{
+    st_size_t i, size = st_image_get_size(image, ref);
+    st_image_ref_t cur_ref;
+    const char *cur_key;
+
+    // Keys are compared by length first like "st_object_compare", so an embedded NUL does not end them
+    for (i=0; i<size; i++) {
+        cur_ref = st_image_dict_key(image, ref, i);
+        cur_key = st_image_get_string(image, cur_ref);
+        if (cur_key != NULL && st_image_get_size(image, cur_ref) == length && memcmp(cur_key, key, length) == 0) {
+            return st_image_dict_value(image, ref, i);
+        }
+    }
+    return 0;
+}
+
+st_image_ref_t st_image_dict_get(const st_byte_t *image, st_image_ref_t ref, const char *key)
+{
+    return st_image_dict_get_n(image, ref, key, ST_SIZE(strlen(key)));
+}
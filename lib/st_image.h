@@ -0,0 +1,148 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef __ST_OBJECTS_ST_IMAGE_H__
+#define __ST_OBJECTS_ST_IMAGE_H__
+
+#include "st_dict.h"
+#include "st_typed_array.h"
+
+/**
+ * An image is a read-only, position independent copy of an object graph.
+ * Every reference inside of it is an offset from the start of the image, so
+ * the image can be memcpy'd, written to disk, mmap'd or placed in shared
+ * memory and read in place without any fixups.
+ *
+ * Layout (all nodes are 8 byte aligned, offsets are uint32_t):
+ *   header: magic, image size, root offset
+ *   node:   type, length, payload
+ *     bool/int:    value stored in "length"
+ *     long/float:  8 byte payload
+ *     string/blob: "length" bytes followed by a NUL
+ *     array:       "length" element offsets
+ *     dict:        "length" (key offset, value offset) pairs
+ *     typed array: element type, reserved, "length" packed elements
+ *
+ * The image must be 8 byte aligned when it is read.
+ */
+
+#define ST_IMAGE_MAGIC 0x5a465453u
+
+typedef uint32_t st_image_ref_t;
+
+/* Returned by "st_image_get_type" for a reference that is not a valid node */
+#define ST_IMAGE_TYPE_INVALID ((st_object_type_t)-1)
+
+typedef struct st_image_header_s
+{
+    uint32_t magic;
+    uint32_t size;
+    st_image_ref_t root;
+    uint32_t reserved;
+} st_image_header_t;
+
+typedef struct st_image_node_s
+{
+    uint32_t type;
+    uint32_t length;
+} st_image_node_t;
+
+/**
+ * Returns the number of bytes "st_object_write_image" needs for an object
+ * @param object Pointer to the object to write
+ * @return Size of the image in bytes (or 0 if it exceeds 4GB)
+ */
+st_size_t st_object_image_size(st_object_t *object);
+
+/**
+ * Writes the image of an object graph
+ * @param object Pointer to the object to write
+ * @param image Pointer to an 8 byte aligned buffer for the image
+ * @param size The size of the buffer
+ * @return Size of the image in bytes (or 0 if it did not fit)
+ */
+st_size_t st_object_write_image(st_object_t *object, st_byte_t *image, st_size_t size);
+
+/**
+ * Checks the header and the root node of a received image.  The accessors
+ * check every node they read against the size recorded in the header, so
+ * once an image passed this check a corrupted offset makes them return 0 (or
+ * NULL) instead of reading past the end of the image.
+ * @param image Pointer to the image
+ * @param size The number of bytes available at "image"
+ * @return "TRUE" if the header is valid and the image fits in "size"
+ */
+st_bool_t st_image_valid(const st_byte_t *image, st_size_t size);
+
+st_image_ref_t st_image_root(const st_byte_t *image);
+st_object_type_t st_image_get_type(const st_byte_t *image, st_image_ref_t ref);
+
+st_bool_t st_image_get_bool(const st_byte_t *image, st_image_ref_t ref);
+st_int_t st_image_get_int(const st_byte_t *image, st_image_ref_t ref);
+st_long_t st_image_get_long(const st_byte_t *image, st_image_ref_t ref);
+st_float_t st_image_get_float(const st_byte_t *image, st_image_ref_t ref);
+const char *st_image_get_string(const st_byte_t *image, st_image_ref_t ref);
+const st_byte_t *st_image_get_blob(const st_byte_t *image, st_image_ref_t ref);
+
+/**
+ * Returns the packed elements of a typed array in an image, they can be read in
+ * place (the image keeps them 8 byte aligned)
+ * @param image Pointer to the image
+ * @param ref Reference to the typed array
+ * @param type Receives the element type (can be NULL)
+ * @return Pointer to the elements (or NULL if "ref" is not a typed array)
+ */
+const void *st_image_get_typed_array(const st_byte_t *image, st_image_ref_t ref, st_typed_array_type_t *type);
+
+/* Number of bytes of a string or blob, elements of an array or typed array or pairs of a dict */
+st_size_t st_image_get_size(const st_byte_t *image, st_image_ref_t ref);
+
+/* Container accessors, all of them are O(1) and return 0 when out of range */
+st_image_ref_t st_image_array_get(const st_byte_t *image, st_image_ref_t ref, st_size_t index);
+st_image_ref_t st_image_dict_key(const st_byte_t *image, st_image_ref_t ref, st_size_t index);
+st_image_ref_t st_image_dict_value(const st_byte_t *image, st_image_ref_t ref, st_size_t index);
+
+/**
+ * Looks up the value of a string key in a dict of an image
+ * @param image Pointer to the image
+ * @param ref Reference to the dict
+ * @param key The key to look for
+ * @return Reference to the value (or 0 if the key is not present)
+ */
+st_image_ref_t st_image_dict_get(const st_byte_t *image, st_image_ref_t ref, const char *key);
+
+/**
+ * Same as "st_image_dict_get" for a key of "length" bytes, which can hold NULs
+ * @param image Pointer to the image
+ * @param ref Reference to the dict
+ * @param key The bytes of the key
+ * @param length The number of bytes of the key
+ * @return Reference to the value (or 0 if the key is not present)
+ */
+st_image_ref_t st_image_dict_get_n(const st_byte_t *image, st_image_ref_t ref, const char *key, st_size_t length);
+
+#endif // __ST_OBJECTS_ST_IMAGE_H__
@@ -0,0 +1,318 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <string.h>
+#include "st_index.h"
+
+#if ST_INDEX_SSE2
+#include <emmintrin.h>
+#endif
+
+#define ST_INDEX_EMPTY ((uint8_t)0x80)
+#define ST_INDEX_DELETED ((uint8_t)0xfe)
+
+/* The low 7 bits of the hash go to the control byte, the rest picks the group */
+#define ST_INDEX_H1(hash) ((hash) >> 7)
+#define ST_INDEX_H2(hash) ((uint8_t)((hash) & 0x7f))
+
+/* The index is rehashed once it is 7/8 full */
+#define ST_INDEX_MAX_COUNT(capacity) ST_SIZE((capacity) - (capacity) / 8)
+
+/* Returns a bit for every control byte of the group that equals "byte" */
+static uint32_t _st_index_match(const uint8_t *group, uint8_t byte)
+{
+#if ST_INDEX_SSE2
+    __m128i bytes = _mm_load_si128((const __m128i *)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)byte)));
+#else
+    uint32_t bits = 0;
+    int i;
+
+    for (i = 0; i < ST_INDEX_GROUP_SIZE; i++) {
+        bits |= (uint32_t)(group[i] == byte) << i;
+    }
+    return bits;
+#endif
+}
+
+/* Returns a bit for every empty or deleted slot of the group (their high bit is set) */
+static uint32_t _st_index_match_free(const uint8_t *group)
+{
+#if ST_INDEX_SSE2
+    return (uint32_t)_mm_movemask_epi8(_mm_load_si128((const __m128i *)group));
+#else
+    uint32_t bits = 0;
+    int i;
+
+    for (i = 0; i < ST_INDEX_GROUP_SIZE; i++) {
+        bits |= (uint32_t)(group[i] >> 7) << i;
+    }
+    return bits;
+#endif
+}
+
+static int _st_index_first_bit(uint32_t bits)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(bits);
+#else
+    int i = 0;
+
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+/* Allocates the buffers for "capacity" slots (a power of two of at least a group) */
+static st_bool_t _st_index_alloc(st_index_t *this, st_size_t capacity)
+{
+    uint8_t *control;
+    st_link_t **slots;
+
+    if (capacity > ST_SIZE_MAX / sizeof(st_link_t *) ||
+        (control = st_malloc_aligned(this->malloc, capacity, ST_INDEX_GROUP_SIZE)) == NULL ||
+        (slots = st_malloc_struct(this->malloc, ST_SIZE(capacity * sizeof(st_link_t *)))) == NULL)
+    {
+        return FALSE;
+    }
+
+    memset(control, ST_INDEX_EMPTY, capacity);
+    this->control = control;
+    this->slots = slots;
+    this->capacity = capacity;
+    this->growth_left = ST_SIZE(ST_INDEX_MAX_COUNT(capacity) - this->count);
+    return TRUE;
+}
+
+st_size_t st_index_get_capacity(st_size_t count)
+{
+    st_size_t capacity = ST_INDEX_GROUP_SIZE;
+
+    while (ST_INDEX_MAX_COUNT(capacity) < count) {
+        if (capacity > ST_SIZE_MAX / 2) {
+            return 0;
+        }
+        capacity = ST_SIZE(capacity * 2);
+    }
+    return capacity;
+}
+
+/* Returns the first free slot of the probe sequence of "hash", there must be one */
+static st_size_t _st_index_find_free(st_index_t *this, uint32_t hash)
+{
+    st_size_t mask = ST_SIZE(this->capacity / ST_INDEX_GROUP_SIZE - 1);
+    st_size_t group = ST_SIZE(ST_INDEX_H1(hash) & mask), step = 0;
+    uint32_t bits;
+
+    while ((bits = _st_index_match_free(this->control + group * ST_INDEX_GROUP_SIZE)) == 0) {
+        step++;
+        group = ST_SIZE((group + step) & mask);
+    }
+    return ST_SIZE(group * ST_INDEX_GROUP_SIZE + _st_index_first_bit(bits));
+}
+
+/* Puts a link in the first free slot of its probe sequence, there must be one */
+static void _st_index_place(st_index_t *this, st_link_t *link, uint32_t hash)
+{
+    st_size_t slot = _st_index_find_free(this, hash);
+
+    if (this->control[slot] == ST_INDEX_EMPTY) {
+        this->growth_left--;
+    }
+    this->control[slot] = ST_INDEX_H2(hash);
+    this->slots[slot] = link;
+    this->count++;
+}
+
+/* Moves the links to new buffers, which also drops the deleted slots */
+static st_bool_t _st_index_rehash(st_index_t *this, st_size_t capacity)
+{
+    uint8_t *control = this->control;
+    st_link_t **slots = this->slots;
+    st_size_t old_capacity = this->capacity, count = this->count, i;
+
+    this->count = 0;
+    if (!_st_index_alloc(this, capacity)) {
+        this->count = count;
+        return FALSE;
+    }
+
+    for (i = 0; i < old_capacity; i++) {
+        if (control[i] < ST_INDEX_EMPTY) {
+            _st_index_place(this, slots[i], st_object_hash(slots[i]->key));
+        }
+    }
+    return TRUE;
+}
+
+/*
+ * Drops the deleted slots without new buffers.  The links still to be moved
+ * are marked deleted and the others empty, then every marked link either stays
+ * in its group, moves to an empty slot or swaps with another marked link.
+ */
+static void _st_index_drop_deleted(st_index_t *this)
+{
+    st_size_t i, slot;
+    st_link_t *link;
+    uint32_t hash;
+
+    for (i = 0; i < this->capacity; i++) {
+        this->control[i] = (this->control[i] < ST_INDEX_EMPTY)?ST_INDEX_DELETED:ST_INDEX_EMPTY;
+    }
+
+    for (i = 0; i < this->capacity; i++) {
+        while (this->control[i] == ST_INDEX_DELETED) {
+            hash = st_object_hash(this->slots[i]->key);
+            slot = _st_index_find_free(this, hash);
+            if (slot / ST_INDEX_GROUP_SIZE == i / ST_INDEX_GROUP_SIZE) {
+                this->control[i] = ST_INDEX_H2(hash);
+            }
+            else if (this->control[slot] == ST_INDEX_EMPTY) {
+                this->control[slot] = ST_INDEX_H2(hash);
+                this->slots[slot] = this->slots[i];
+                this->control[i] = ST_INDEX_EMPTY;
+            }
+            else {
+                // The slot holds a link still to be moved, which is handled next
+                link = this->slots[slot];
+                this->control[slot] = ST_INDEX_H2(hash);
+                this->slots[slot] = this->slots[i];
+                this->slots[i] = link;
+            }
+        }
+    }
+    this->growth_left = ST_SIZE(ST_INDEX_MAX_COUNT(this->capacity) - this->count);
+}
+
+st_index_t *st_index_new(st_malloc_t *malloc, st_size_t count)
+{
+    st_index_t *index = st_malloc_struct(malloc, sizeof(st_index_t));
+    st_size_t capacity = st_index_get_capacity(count);
+
+    if (index == NULL || capacity == 0) {
+        return NULL;
+    }
+
+    index->malloc = malloc;
+    index->count = 0;
+    return _st_index_alloc(index, capacity)?index:NULL;
+}
+
+st_bool_t st_index_reserve(st_index_t *this, st_size_t count)
+{
+    st_size_t capacity;
+
+    if (count <= this->growth_left) {
+        return TRUE;
+    }
+    if (count > ST_SIZE_MAX - this->count) {
+        return FALSE;
+    }
+
+    // Deleted slots are dropped in place when they make up most of the free room
+    capacity = st_index_get_capacity(ST_SIZE(this->count + count));
+    if (capacity == 0) {
+        return FALSE;
+    }
+    if (capacity < this->capacity) {
+        capacity = this->capacity;
+    }
+    else if (capacity == this->capacity && this->count + count > ST_INDEX_MAX_COUNT(capacity) / 2) {
+        capacity = (capacity > ST_SIZE_MAX / 2)?capacity:ST_SIZE(capacity * 2);
+    }
+    if (capacity == this->capacity) {
+        _st_index_drop_deleted(this);
+        return TRUE;
+    }
+    return _st_index_rehash(this, capacity);
+}
+
+st_bool_t st_index_insert(st_index_t *this, st_link_t *link)
+{
+    if (!st_index_reserve(this, 1)) {
+        return FALSE;
+    }
+    _st_index_place(this, link, st_object_hash(link->key));
+    return TRUE;
+}
+
+/* Probes for the slot of "link" (or of a link with an equal key if "link" is NULL), -1 if there is none */
+static long _st_index_lookup(st_index_t *this, st_object_t *key, st_link_t *link)
+{
+    uint32_t hash = st_object_hash(key), bits;
+    st_size_t mask = ST_SIZE(this->capacity / ST_INDEX_GROUP_SIZE - 1);
+    st_size_t group = ST_SIZE(ST_INDEX_H1(hash) & mask), step, slot;
+    const uint8_t *control;
+
+    for (step = 0; step <= mask; step++) {
+        control = this->control + group * ST_INDEX_GROUP_SIZE;
+        for (bits = _st_index_match(control, ST_INDEX_H2(hash)); bits != 0; bits &= bits - 1) {
+            slot = ST_SIZE(group * ST_INDEX_GROUP_SIZE + _st_index_first_bit(bits));
+            if ((link != NULL)?this->slots[slot] == link:st_object_compare(key, this->slots[slot]->key)) {
+                return (long)slot;
+            }
+        }
+
+        // A key is never placed past a group that still has an empty slot
+        if (_st_index_match(control, ST_INDEX_EMPTY) != 0) {
+            break;
+        }
+        group = ST_SIZE((group + step + 1) & mask);
+    }
+    return -1;
+}
+
+st_bool_t st_index_remove(st_index_t *this, st_link_t *link)
+{
+    long slot = _st_index_lookup(this, link->key, link);
+    const uint8_t *group;
+
+    if (slot < 0) {
+        return FALSE;
+    }
+
+    // The slot can be emptied if no probe went past its group, otherwise it must stay a tombstone
+    group = this->control + (slot & ~(long)(ST_INDEX_GROUP_SIZE - 1));
+    if (_st_index_match(group, ST_INDEX_EMPTY) != 0) {
+        this->control[slot] = ST_INDEX_EMPTY;
+        this->growth_left++;
+    }
+    else {
+        this->control[slot] = ST_INDEX_DELETED;
+    }
+    this->count--;
+    return TRUE;
+}
+
+st_link_t *st_index_find(st_index_t *this, st_object_t *key)
+{
+    long slot = _st_index_lookup(this, key, NULL);
+    return (slot >= 0)?this->slots[slot]:NULL;
+}
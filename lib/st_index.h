@@ -0,0 +1,106 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef __ST_OBJECTS_ST_INDEX_H__
+#define __ST_OBJECTS_ST_INDEX_H__
+
+#include "st_link.h"
+
+/* Number of slots whose control bytes are matched at once */
+#define ST_INDEX_GROUP_SIZE 16
+
+/**
+ * An open addressing hash index over the keyed links of an array, used by
+ * st_dict to find a key without walking the links.  It follows the layout of
+ * a SwissTable: every slot has a control byte that is empty, deleted or holds
+ * 7 bits of the hash of the key, and the control bytes of a group of 16 slots
+ * are compared with the hash at once (with SSE2 where it is available), so
+ * the keys themselves are only compared on a probable match.  Groups are
+ * probed quadratically and the index grows by rehashing into new buffers
+ * allocated from its heap once it is 7/8 full, the old ones are left to the
+ * heap.  The keys are hashed with "st_object_hash" and must not be modified
+ * while they are indexed.
+ */
+typedef struct st_index_s
+{
+    st_malloc_t *malloc;
+    uint8_t *control;
+    st_link_t **slots;
+    st_size_t capacity;
+    st_size_t count;
+    st_size_t growth_left;
+} st_index_t;
+
+/**
+ * Creates an empty index
+ * @param malloc Pointer to the st_malloc instance
+ * @param count The number of links to make room for
+ * @return Pointer to the index (or NULL)
+ */
+st_index_t *st_index_new(st_malloc_t *malloc, st_size_t count);
+
+/**
+ * Returns the number of slots an index allocates for "count" links, a power
+ * of two of at least a group (every slot takes a control byte and a pointer)
+ * @param count The number of links
+ * @return The number of slots (or 0 if it does not fit a st_size_t)
+ */
+st_size_t st_index_get_capacity(st_size_t count);
+
+/**
+ * Makes room for "count" more links, so that inserting them can not fail
+ * @param this Pointer to the index
+ * @param count The number of links
+ * @return "TRUE" if there is room, "FALSE" if the heap is full
+ */
+st_bool_t st_index_reserve(st_index_t *this, st_size_t count);
+
+/**
+ * Adds a link by its key (a link whose key is already indexed must be removed first)
+ * @param this Pointer to the index
+ * @param link Pointer to the link, its key must not be NULL
+ * @return "TRUE" if the link was added, "FALSE" if the heap is full
+ */
+st_bool_t st_index_insert(st_index_t *this, st_link_t *link);
+
+/**
+ * Removes a link that was added to the index
+ * @param this Pointer to the index
+ * @param link Pointer to the link
+ * @return "TRUE" if the link was removed, "FALSE" if it was not in the index
+ */
+st_bool_t st_index_remove(st_index_t *this, st_link_t *link);
+
+/**
+ * Finds the link of a key
+ * @param this Pointer to the index
+ * @param key Pointer to the key (compared with "st_object_compare")
+ * @return Pointer to the link (or NULL)
+ */
+st_link_t *st_index_find(st_index_t *this, st_object_t *key);
+
+#endif // __ST_OBJECTS_ST_INDEX_H__
@@ -0,0 +1,185 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <string.h>
+#include "st_intern.h"
+
+#define ST_INTERN_MIN_CAPACITY 8
+
+/* Returns the slot holding "value", or the empty slot where it belongs */
+static st_object_t **_st_intern_slot(st_intern_t *this, const char *value, st_size_t length, uint32_t hash)
+{
+    st_size_t mask = ST_SIZE(this->capacity - 1);
+    st_size_t i = ST_SIZE(hash & mask);
+    st_object_t *object;
+
+    while ((object = this->slots[i]) != NULL) {
+        if (st_object_get_string_hash(object) == hash && st_object_get_string_length(object) == length &&
+            memcmp(st_object_get_string(object), value, length) == 0)
+        {
+            break;
+        }
+        i = ST_SIZE((i + 1) & mask);
+    }
+    return &this->slots[i];
+}
+
+static st_object_t **_st_intern_alloc_slots(st_malloc_t *malloc, st_size_t capacity)
+{
+    st_object_t **slots = st_malloc_struct(malloc, ST_SIZE(capacity * sizeof(st_object_t *)));
+    if (slots != NULL) {
+        memset(slots, 0, capacity * sizeof(st_object_t *));
+    }
+    return slots;
+}
+
+static st_bool_t _st_intern_grow(st_intern_t *this)
+{
+    st_object_t **old_slots = this->slots;
+    st_size_t old_capacity = this->capacity, i;
+    st_object_t *object;
+
+    if (this->capacity > ST_SIZE_MAX / 2 / sizeof(st_object_t *) ||
+        (this->slots = _st_intern_alloc_slots(this->malloc, ST_SIZE(old_capacity * 2))) == NULL)
+    {
+        this->slots = old_slots;
+        return FALSE;
+    }
+
+    this->capacity = ST_SIZE(old_capacity * 2);
+    for (i=0; i<old_capacity; i++) {
+        if ((object = old_slots[i]) != NULL) {
+            *_st_intern_slot(this, st_object_get_string(object), st_object_get_string_length(object),
+                             st_object_get_string_hash(object)) = object;
+        }
+    }
+    return TRUE;
+}
+
+st_intern_t *st_intern_new(st_malloc_t *malloc, st_size_t capacity, st_intern_t *parent)
+{
+    st_intern_t *intern = st_malloc_struct(malloc, sizeof(st_intern_t));
+    st_size_t size = ST_INTERN_MIN_CAPACITY;
+    st_object_t **slots;
+
+    while (size < capacity && size <= ST_SIZE_MAX / 2 / sizeof(st_object_t *)) {
+        size = ST_SIZE(size * 2);
+    }
+
+    slots = (intern != NULL)?_st_intern_alloc_slots(malloc, size):NULL;
+    if (slots == NULL) {
+        return NULL;
+    }
+
+    st_intern_init(intern, malloc, slots, size, parent);
+    return intern;
+}
+
+void st_intern_init(st_intern_t *this, st_malloc_t *malloc, st_object_t **slots, st_size_t capacity,
+                    st_intern_t *parent)
+{
+    this->malloc = malloc;
+    this->slots = slots;
+    this->capacity = capacity;
+    this->count = 0;
+    this->parent = parent;
+    memset(slots, 0, capacity * sizeof(st_object_t *));
+}
+
+static st_object_t *_st_intern_find(st_intern_t *this, const char *value, st_size_t length, uint32_t hash)
+{
+    st_object_t *object;
+
+    for (; this != NULL; this = this->parent) {
+        object = *_st_intern_slot(this, value, length, hash);
+        if (object != NULL) {
+            return object;
+        }
+    }
+    return NULL;
+}
+
+st_object_t *st_intern_find(st_intern_t *this, const char *value)
+{
+    size_t length = strlen(value);
+
+    if (length > ST_SIZE_MAX) {
+        return NULL;
+    }
+    return _st_intern_find(this, value, ST_SIZE(length), st_object_hash_string(value, ST_SIZE(length)));
+}
+
+st_object_t *st_intern_string(st_intern_t *this, const char *value)
+{
+    size_t length = strlen(value);
+    return (length <= ST_SIZE_MAX)?st_intern_string_n(this, value, ST_SIZE(length)):NULL;
+}
+
+st_object_t *st_intern_string_n(st_intern_t *this, const char *value, st_size_t length)
+{
+    uint32_t hash = st_object_hash_string(value, length);
+    st_object_t *object = _st_intern_find(this->parent, value, length, hash);
+    st_object_t **slot;
+
+    if (object != NULL) {
+        return object;
+    }
+
+    slot = _st_intern_slot(this, value, length, hash);
+    if (*slot != NULL) {
+        return *slot;
+    }
+
+    // Keep at least a quarter of the slots empty so that probes stay short
+    if ((this->count + 1) * 4 > this->capacity * 3) {
+        if (!_st_intern_grow(this)) {
+            return NULL;
+        }
+        slot = _st_intern_slot(this, value, length, hash);
+    }
+
+    object = st_object_new_string_n(this->malloc, value, length);
+    if (object == NULL) {
+        return NULL;
+    }
+
+    *slot = object;
+    this->count++;
+    return object;
+}
+
+st_bool_t st_intern_seed(st_intern_t *this, const char *const *values, st_size_t count)
+{
+    st_size_t i;
+
+    for (i=0; i<count; i++) {
+        if (st_intern_string(this, values[i]) == NULL) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
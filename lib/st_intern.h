@@ -0,0 +1,108 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef __ST_OBJECTS_ST_INTERN_H__
+#define __ST_OBJECTS_ST_INTERN_H__
+
+#include "st_object.h"
+
+/**
+ * An intern table maps a string to one canonical (interned) string object.
+ * Keys built through it are matched by pointer in "st_object_compare" (and
+ * by value against keys of other tables) and do not copy the string again.
+ * A table allocates from the heap it was created with, so it lives until
+ * that heap is freed or rewound.  A table can have a
+ * parent (e.g. a table pre-seeded at startup in a heap that is never freed)
+ * that is searched first, so the seeded keys survive "st_malloc_free" of the
+ * per-packet heap.
+ */
+typedef struct st_intern_s
+{
+    st_malloc_t *malloc;
+    st_object_t **slots;
+    st_size_t capacity;
+    st_size_t count;
+    struct st_intern_s *parent;
+} st_intern_t;
+
+/**
+ * Creates an intern table in a heap
+ * @param malloc Pointer to the st_malloc instance for the table and its strings
+ * @param capacity The initial number of slots (rounded up to a power of two)
+ * @param parent Pointer to a table that is searched first (or NULL)
+ * @return Pointer to the table (or NULL)
+ */
+st_intern_t *st_intern_new(st_malloc_t *malloc, st_size_t capacity, st_intern_t *parent);
+
+/**
+ * Initializes an intern table in caller provided storage (e.g. a static table
+ * seeded at startup).  The table grows out of "slots" by allocating from
+ * "malloc" when it is 3/4 full.
+ * @param this Pointer to the table
+ * @param malloc Pointer to the st_malloc instance for the strings
+ * @param slots Storage for "capacity" slots
+ * @param capacity The number of slots, must be a power of two
+ * @param parent Pointer to a table that is searched first (or NULL)
+ */
+void st_intern_init(st_intern_t *this, st_malloc_t *malloc, st_object_t **slots, st_size_t capacity,
+                    st_intern_t *parent);
+
+/**
+ * Returns the canonical object for a string, creating it if needed
+ * @param this Pointer to the table
+ * @param value The string
+ * @return Pointer to the interned object (or NULL if it could not be created)
+ */
+st_object_t *st_intern_string(st_intern_t *this, const char *value);
+
+/**
+ * Returns the canonical object for bytes that do not need to be NUL terminated
+ * @param this Pointer to the table
+ * @param value Pointer to the bytes
+ * @param length The number of bytes
+ * @return Pointer to the interned object (or NULL if it could not be created)
+ */
+st_object_t *st_intern_string_n(st_intern_t *this, const char *value, st_size_t length);
+
+/**
+ * Returns the canonical object for a string without creating it
+ * @param this Pointer to the table
+ * @param value The string
+ * @return Pointer to the interned object (or NULL if the string is not interned)
+ */
+st_object_t *st_intern_find(st_intern_t *this, const char *value);
+
+/**
+ * Interns a list of strings
+ * @param this Pointer to the table
+ * @param values The strings
+ * @param count The number of strings
+ * @return "TRUE" if all of the strings were interned
+ */
+st_bool_t st_intern_seed(st_intern_t *this, const char *const *values, st_size_t count);
+
+#endif // __ST_OBJECTS_ST_INTERN_H__
@@ -30,10 +30,17 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 st_link_t *st_link_new(st_malloc_t *malloc, st_object_t *object, st_object_t *key)
 {
     st_link_t *link = st_malloc_struct(malloc, sizeof(st_link_t));
-    st_link_init(link, object, key);
+    if (link != NULL) {
+        st_link_init(link, object, key);
+    }
     return link;
 }
 
+void st_link_free(st_malloc_t *malloc, st_link_t *this)
+{
+    st_malloc_recycle(malloc, this, sizeof(st_link_t));
+}
+
 void st_link_init(st_link_t *this, st_object_t *object, st_object_t *key)
 {
     this->prev = NULL;
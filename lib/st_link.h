@@ -41,4 +41,11 @@ typedef struct st_link_s
 st_link_t *st_link_new(st_malloc_t *malloc, st_object_t *object, st_object_t *key);
 void st_link_init(st_link_t *this, st_object_t *object, st_object_t *key);
 
+/**
+ * Hands a link allocated with "st_link_new" back to the free lists of "malloc"
+ * @param malloc Pointer to the st_malloc instance the link was allocated from
+ * @param this Pointer to the link (must no longer be referenced)
+ */
+void st_link_free(st_malloc_t *malloc, st_link_t *this);
+
 #endif // __ST_OBJECTS_ST_LINK_H__
@@ -25,26 +25,181 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  
 */
 
+#include <string.h>
 #include "st_malloc.h"
 
-static void _st_malloc_align(st_malloc_t *this, st_size_t size)
+#if ST_MALLOC_STATS
+#define ST_MALLOC_STAT(this, field, value) ((this)->stats.field += (value))
+#else
+#define ST_MALLOC_STAT(this, field, value) ((void)0)
+#endif
+
+/* "align" must be a power of two */
+static void _st_malloc_align(st_malloc_t *this, st_size_t align)
+{
+    st_ptr_t mask = (st_ptr_t)align - 1;
+    this->ptr = (st_byte_t *)(((st_ptr_t)this->ptr + mask) & ~mask);
+}
+
+static void _st_malloc_set_chunk(st_malloc_t *this, st_malloc_chunk_t *chunk)
+{
+    this->chunk = chunk;
+    this->heap = chunk->heap;
+    this->size = chunk->size;
+    this->ptr = chunk->heap;
+    this->top = chunk->heap + chunk->size;
+    this->ptr_high = this->ptr;
+    this->top_low = this->top;
+}
+
+/* Records how far the cursors reached before they move back */
+static void _st_malloc_note_touched(st_malloc_t *this)
 {
-    while((st_ptr_t)this->ptr%size != 0)
-    {
-        this->ptr++;
+    if (this->ptr > this->ptr_high) {
+        this->ptr_high = this->ptr;
     }
+    if (this->top < this->top_low) {
+        this->top_low = this->top;
+    }
+}
+
+static st_malloc_chunk_t *_st_malloc_new_chunk(st_byte_t *block, st_size_t size)
+{
+    st_malloc_chunk_t *chunk = (st_malloc_chunk_t *)block;
+    chunk->next = NULL;
+    chunk->heap = block + sizeof(st_malloc_chunk_t);
+    chunk->size = ST_SIZE(size - sizeof(st_malloc_chunk_t));
+    return chunk;
 }
 
-static void *_st_malloc(st_malloc_t *this, st_size_t size)
+static st_bool_t _st_malloc_grow(st_malloc_t *this, st_byte_t *used, st_size_t size, st_size_t align)
 {
-    void *location = this->ptr;
+    st_malloc_provider_t *provider = this->provider;
+    st_malloc_chunk_t *chunk = this->chunk->next;
+    st_size_t needed, block_size;
+    st_byte_t *block;
+
+    if (size > ST_SIZE_MAX - sizeof(st_malloc_chunk_t) - align) {
+        return FALSE;
+    }
+    needed = ST_SIZE(size + align - 1);
+
+    // Reuse the next cached block if it is large enough, otherwise insert a new one in front of it
+    if (chunk == NULL || chunk->size < needed) {
+        block_size = ST_SIZE(needed + sizeof(st_malloc_chunk_t));
+        if (block_size < provider->chunk_size) {
+            block_size = provider->chunk_size;
+        }
+
+        block = provider->alloc(provider->context, block_size);
+        if (block == NULL) {
+            return FALSE;
+        }
+
+        chunk = _st_malloc_new_chunk(block, block_size);
+        chunk->next = this->chunk->next;
+        this->chunk->next = chunk;
+    }
+
+    // Temporary allocations at the top of the old block stay valid until they are freed
+    this->chunk_used = ST_SIZE(this->chunk_used + (used - this->heap));
+    this->chunk_temp = ST_SIZE(this->chunk_temp + (this->heap + this->size - this->top));
+    _st_malloc_set_chunk(this, chunk);
+    return TRUE;
+}
+
+/**
+ * Bumps the pointer by "size" if it fits below the temporary region.  The
+ * remaining space is compared instead of the end pointer so that a large
+ * "size" can not wrap the address space.
+ */
+static st_bool_t _st_malloc_bump(st_malloc_t *this, st_size_t size)
+{
+    st_ptr_t end = (st_ptr_t)this->top;
+
+    if ((st_ptr_t)this->ptr > end || size > end - (st_ptr_t)this->ptr) {
+        return FALSE;
+    }
+
     this->ptr += size;
-    return (st_malloc_did_overflow(this))?NULL:location;
+    return TRUE;
+}
+
+#if ST_MALLOC_FREE_LISTS
+/**
+ * Pops a block that can hold "size" bytes.  Free list "i" holds blocks of at
+ * least (i+1) pointers, so the request is rounded up to a whole pointer.
+ */
+static void *_st_malloc_reuse(st_malloc_t *this, st_size_t size)
+{
+    st_size_t index = ST_SIZE((size + sizeof(st_ptr_t) - 1) / sizeof(st_ptr_t));
+    void *block;
+
+    if (index == 0 || index > ST_MALLOC_FREE_LISTS || this->free_lists[--index] == NULL) {
+        return NULL;
+    }
+
+    block = this->free_lists[index];
+    this->free_lists[index] = *(void **)block;
+    ST_MALLOC_STAT(this, reuse_count, 1);
+    return block;
+}
+
+static void _st_malloc_clear_free_lists(st_malloc_t *this)
+{
+    memset(this->free_lists, 0, sizeof(this->free_lists));
+}
+#else
+#define _st_malloc_reuse(this, size) NULL
+#define _st_malloc_clear_free_lists(this) ((void)0)
+#endif
+
+static void _st_malloc_update_peak(st_malloc_t *this)
+{
+#if ST_MALLOC_STATS
+    if (st_malloc_used_bytes(this) > this->stats.peak_bytes) {
+        this->stats.peak_bytes = st_malloc_used_bytes(this);
+    }
+#endif
+}
+
+static void *_st_malloc(st_malloc_t *this, st_size_t size, st_size_t align)
+{
+    st_byte_t *start = this->ptr;
+    st_byte_t *location;
+
+    if (this->overflow) {
+        ST_MALLOC_STAT(this, overflow_count, 1);
+        return NULL;
+    }
+
+    location = this->ptr;
+    _st_malloc_align(this, align);
+    ST_MALLOC_STAT(this, padding_bytes, this->ptr - location);
+    location = this->ptr;
+
+    if (!_st_malloc_bump(this, size)) {
+        if (this->chunk == NULL || this->provider->alloc == NULL ||
+            !_st_malloc_grow(this, location, size, align)) {
+            this->ptr = start;
+            this->overflow = TRUE;
+            ST_MALLOC_STAT(this, overflow_count, 1);
+            return NULL;
+        }
+
+        _st_malloc_align(this, align);
+        ST_MALLOC_STAT(this, padding_bytes, this->ptr - this->heap);
+        location = this->ptr;
+        _st_malloc_bump(this, size);
+    }
+
+    _st_malloc_update_peak(this);
+    return location;
 }
 
 st_bool_t st_malloc_did_overflow(st_malloc_t *this)
 {
-    return ST_BOOL((st_ptr_t)this->ptr > ((st_ptr_t)this->heap + this->size));
+    return this->overflow;
 }
 
 void st_malloc_init(st_malloc_t *this, st_byte_t *heap, st_size_t size)
@@ -52,31 +207,235 @@ void st_malloc_init(st_malloc_t *this, st_byte_t *heap, st_size_t size)
     this->heap = heap;
     this->size = size;
     this->ptr = heap;
+    this->top = heap + size;
+    this->provider = NULL;
+    this->first = NULL;
+    this->chunk = NULL;
+    this->chunk_used = 0;
+    this->chunk_temp = 0;
+    this->overflow = FALSE;
+    this->ptr_high = this->ptr;
+    this->top_low = this->top;
+#if ST_MALLOC_DEBUG
+    this->mark_depth = 0;
+#endif
+#if ST_MALLOC_STATS
+    memset(&this->stats, 0, sizeof(this->stats));
+#endif
+    _st_malloc_clear_free_lists(this);
+}
+
+void st_malloc_init_chunked(st_malloc_t *this, st_byte_t *heap, st_size_t size,
+                            st_malloc_provider_t *provider)
+{
+    st_malloc_init(this, heap, size);
+    this->provider = provider;
+    this->first = _st_malloc_new_chunk(heap, size);
+    _st_malloc_set_chunk(this, this->first);
 }
 
 void *st_malloc_bytes(st_malloc_t *this, st_size_t size)
 {
-    return _st_malloc(this, size);
+    ST_MALLOC_STAT(this, bytes_count, 1);
+    return _st_malloc(this, size, 1);
 }
 
 void *st_malloc_var(st_malloc_t *this, st_size_t size)
 {
-    _st_malloc_align(this, size);
-    return _st_malloc(this, size);
+    // The largest power of two dividing the size (i.e. its natural alignment)
+    st_size_t align = ST_SIZE(size & (~size + 1));
+    // Recycled blocks are only guaranteed to be pointer aligned
+    void *block = (align <= sizeof(st_ptr_t))?_st_malloc_reuse(this, size):NULL;
+    ST_MALLOC_STAT(this, var_count, 1);
+    return (block != NULL)?block:_st_malloc(this, size, (align != 0)?align:1);
 }
 
 void *st_malloc_struct(st_malloc_t *this, st_size_t size)
 {
-    _st_malloc_align(this, sizeof(st_ptr_t));
-    return _st_malloc(this, size);
+    void *block = _st_malloc_reuse(this, size);
+    ST_MALLOC_STAT(this, struct_count, 1);
+    return (block != NULL)?block:_st_malloc(this, size, sizeof(st_ptr_t));
+}
+
+void *st_malloc_aligned(st_malloc_t *this, st_size_t size, st_size_t align)
+{
+    if (align == 0 || (align & (align - 1)) != 0) {
+        return NULL;
+    }
+    ST_MALLOC_STAT(this, aligned_count, 1);
+    return _st_malloc(this, size, align);
 }
 
 void st_malloc_free(st_malloc_t *this)
 {
+    if (this->provider != NULL && this->provider->reset != NULL) {
+        this->provider->reset(this->provider->context, this);
+    }
+    if (this->first != NULL) {
+        _st_malloc_set_chunk(this, this->first);
+        this->chunk_used = 0;
+    }
     this->ptr = this->heap;
+    this->top = this->heap + this->size;
+    this->chunk_temp = 0;
+    this->overflow = FALSE;
+    this->ptr_high = this->ptr;
+    this->top_low = this->top;
+#if ST_MALLOC_DEBUG
+    this->mark_depth = 0;
+#endif
+    _st_malloc_clear_free_lists(this);
+    ST_MALLOC_STAT(this, free_count, 1);
+}
+
+void st_malloc_recycle(st_malloc_t *this, void *block, st_size_t size)
+{
+#if ST_MALLOC_FREE_LISTS
+    // Round down so that the block can hold every request of its size class
+    st_size_t index = ST_SIZE(size / sizeof(st_ptr_t));
+
+    if (block == NULL || index == 0 || index > ST_MALLOC_FREE_LISTS || (st_ptr_t)block % sizeof(st_ptr_t) != 0) {
+        return;
+    }
+
+    *(void **)block = this->free_lists[index - 1];
+    this->free_lists[index - 1] = block;
+#endif
+}
+
+void *st_malloc_temp(st_malloc_t *this, st_size_t size, st_size_t align)
+{
+    st_ptr_t top = (st_ptr_t)this->top;
+
+    if (align == 0 || (align & (align - 1)) != 0 || this->overflow) {
+        return NULL;
+    }
+
+    // The two cursors must not cross
+    if (size > top - (st_ptr_t)this->ptr ||
+        ((top - size) & ~((st_ptr_t)align - 1)) < (st_ptr_t)this->ptr) {
+        ST_MALLOC_STAT(this, overflow_count, 1);
+        return NULL;
+    }
+
+    this->top = (st_byte_t *)((top - size) & ~((st_ptr_t)align - 1));
+    ST_MALLOC_STAT(this, temp_count, 1);
+    ST_MALLOC_STAT(this, padding_bytes, top - size - (st_ptr_t)this->top);
+    _st_malloc_update_peak(this);
+    return this->top;
+}
+
+void st_malloc_temp_free(st_malloc_t *this)
+{
+    _st_malloc_note_touched(this);
+    this->top = this->heap + this->size;
+    this->chunk_temp = 0;
+}
+
+st_size_t st_malloc_temp_used_bytes(st_malloc_t *this)
+{
+    return ST_SIZE(this->chunk_temp + ((st_ptr_t)this->heap + this->size - (st_ptr_t)this->top));
+}
+
+void st_malloc_trim(st_malloc_t *this)
+{
+    st_malloc_chunk_t *chunk, *next;
+
+    if (this->chunk == NULL) {
+        return;
+    }
+
+    chunk = this->chunk->next;
+    this->chunk->next = NULL;
+
+    while (chunk != NULL) {
+        next = chunk->next;
+        if (this->provider->release != NULL) {
+            this->provider->release(this->provider->context, chunk);
+        }
+        chunk = next;
+    }
+}
+
+void st_malloc_mark(st_malloc_t *this, st_malloc_mark_t *mark)
+{
+    mark->ptr = this->ptr;
+    mark->top = this->top;
+    mark->chunk = this->chunk;
+    mark->chunk_used = this->chunk_used;
+    mark->chunk_temp = this->chunk_temp;
+    mark->overflow = this->overflow;
+#if ST_MALLOC_DEBUG
+    mark->depth = ++this->mark_depth;
+#endif
+}
+
+st_bool_t st_malloc_rewind(st_malloc_t *this, st_malloc_mark_t *mark)
+{
+    if (mark->chunk_used > this->chunk_used ||
+        (mark->chunk == this->chunk && mark->ptr > this->ptr)) {
+        return FALSE;
+    }
+
+#if ST_MALLOC_DEBUG
+    // A mark is only valid while it (or a mark nested in it) is outstanding
+    if (mark->depth == 0 || mark->depth > this->mark_depth) {
+        return FALSE;
+    }
+    this->mark_depth = ST_SIZE(mark->depth - 1);
+#endif
+
+    _st_malloc_note_touched(this);
+    if (mark->chunk != this->chunk) {
+        _st_malloc_set_chunk(this, mark->chunk);
+        this->chunk_used = mark->chunk_used;
+        // The earlier block was filled before the heap moved on
+        this->ptr_high = this->top_low = this->heap + this->size;
+    }
+    this->ptr = mark->ptr;
+    this->top = mark->top;
+    this->chunk_temp = mark->chunk_temp;
+    this->overflow = mark->overflow;
+    _st_malloc_clear_free_lists(this);
+    return TRUE;
+}
+
+void st_malloc_touched(st_malloc_t *this, st_byte_t **used_end, st_byte_t **temp_start)
+{
+    _st_malloc_note_touched(this);
+    *used_end = this->ptr_high;
+    *temp_start = this->top_low;
 }
 
 st_size_t st_malloc_used_bytes(st_malloc_t *this)
 {
-    return ST_SIZE((st_ptr_t)this->ptr - (st_ptr_t)this->heap);
+    return ST_SIZE(this->chunk_used + ((st_ptr_t)this->ptr - (st_ptr_t)this->heap) +
+                   st_malloc_temp_used_bytes(this));
+}
+
+void st_malloc_stats_dump(st_malloc_t *this, int (*print)(const char *format, ...))
+{
+#if ST_MALLOC_STATS
+    st_malloc_stats_t *stats = &this->stats;
+    st_malloc_chunk_t *chunk;
+    st_size_t size = this->size;
+
+    // A chunked heap is as large as all of its chunks, not only the current one
+    if (this->first != NULL) {
+        for (size = 0, chunk = this->first; chunk != NULL; chunk = chunk->next) {
+            size = ST_SIZE(size + chunk->size);
+        }
+    }
+
+    print("st_malloc %p: %lu of %lu bytes used, peak %lu\n", (void *)this,
+          (unsigned long)st_malloc_used_bytes(this), (unsigned long)size,
+          (unsigned long)stats->peak_bytes);
+    print("  allocations: bytes %lu, var %lu, struct %lu, aligned %lu, temp %lu\n",
+          (unsigned long)stats->bytes_count, (unsigned long)stats->var_count,
+          (unsigned long)stats->struct_count, (unsigned long)stats->aligned_count,
+          (unsigned long)stats->temp_count);
+    print("  padding %lu bytes, overflows %lu, frees %lu, reused blocks %lu\n",
+          (unsigned long)stats->padding_bytes, (unsigned long)stats->overflow_count,
+          (unsigned long)stats->free_count, (unsigned long)stats->reuse_count);
+#endif
 }
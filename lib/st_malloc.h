@@ -30,15 +30,102 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "st_types.h"
 
+struct st_malloc_s;
+
+/**
+ * Supplies additional blocks to a chunked st_malloc instance.  "alloc" must
+ * return a pointer aligned block of at least "size" bytes (or NULL) and can
+ * be backed by a static pool, malloc, mmap, etc.  "release" is optional and
+ * is only called by "st_malloc_trim".  "reset" is optional and is called by
+ * "st_malloc_free" before the heap is reset (e.g. to give pages back to the
+ * operating system).
+ */
+typedef struct st_malloc_provider_s
+{
+    void *(*alloc)(void *context, st_size_t size);
+    void (*release)(void *context, void *block);
+    void (*reset)(void *context, struct st_malloc_s *malloc);
+    void *context;
+    st_size_t chunk_size;
+} st_malloc_provider_t;
+
+typedef struct st_malloc_chunk_s
+{
+    struct st_malloc_chunk_s *next;
+    st_byte_t *heap;
+    st_size_t size;
+} st_malloc_chunk_t;
+
+/**
+ * Usage statistics, only present when ST_MALLOC_STATS is enabled.  They are
+ * kept across "st_malloc_free" so the peak can be used to size the heap.
+ */
+typedef struct st_malloc_stats_s
+{
+    st_size_t peak_bytes;
+    uint32_t bytes_count;
+    uint32_t var_count;
+    uint32_t struct_count;
+    uint32_t aligned_count;
+    uint32_t temp_count;
+    uint32_t reuse_count;
+    uint32_t padding_bytes;
+    uint32_t overflow_count;
+    uint32_t free_count;
+} st_malloc_stats_t;
+
 typedef struct st_malloc_s
 {
     st_byte_t *heap;
     st_byte_t *ptr;
+    st_byte_t *top;
     st_size_t size;
+    st_malloc_provider_t *provider;
+    st_malloc_chunk_t *first;
+    st_malloc_chunk_t *chunk;
+    st_size_t chunk_used;
+    st_size_t chunk_temp;
+    st_bool_t overflow;
+    st_byte_t *ptr_high;
+    st_byte_t *top_low;
+#if ST_MALLOC_FREE_LISTS
+    void *free_lists[ST_MALLOC_FREE_LISTS];
+#endif
+#if ST_MALLOC_DEBUG
+    st_size_t mark_depth;
+#endif
+#if ST_MALLOC_STATS
+    st_malloc_stats_t stats;
+#endif
 } st_malloc_t;
 
+typedef struct st_malloc_mark_s
+{
+    st_byte_t *ptr;
+    st_byte_t *top;
+    st_malloc_chunk_t *chunk;
+    st_size_t chunk_used;
+    st_size_t chunk_temp;
+    st_bool_t overflow;
+#if ST_MALLOC_DEBUG
+    st_size_t depth;
+#endif
+} st_malloc_mark_t;
+
 void st_malloc_init(st_malloc_t *this, st_byte_t *heap, st_size_t size);
 
+/**
+ * Initializes a chunked heap.  "heap" is used as the first block and further
+ * blocks are requested from "provider" whenever the current one is full.  The
+ * bump allocation within a block stays O(1).
+ * @param this Pointer to the st_malloc instance
+ * @param heap Pointer aligned buffer used as the first block
+ * @param size The size of "heap" (must be larger than "st_malloc_chunk_t")
+ * @param provider Pointer to the block provider (must outlive the instance)
+ */
+void st_malloc_init_chunked(st_malloc_t *this, st_byte_t *heap, st_size_t size,
+                            st_malloc_provider_t *provider);
+
 /**
  * Allocates an array of bytes
  * @param this Pointer to the st_malloc instance
@@ -48,7 +135,8 @@ void st_malloc_init(st_malloc_t *this, st_byte_t *heap, st_size_t size);
 void *st_malloc_bytes(st_malloc_t *this, st_size_t size);
 
 /**
- * Allocates a variable aligned to the size of the variable.
+ * Allocates a variable aligned to the size of the variable.  Sizes that are
+ * not a power of two are aligned to the largest power of two dividing them.
  * @param this Pointer to the st_malloc instance
  * @param size The size of the variable to be allocated
  * @return Pointer to the variable (or NULL)
@@ -64,23 +152,118 @@ void *st_malloc_var(st_malloc_t *this, st_size_t size);
 void *st_malloc_struct(st_malloc_t *this, st_size_t size);
 
 /**
- * Returns "TRUE" if the buffer has overflowed
+ * Allocates a block aligned to "align" (e.g. 64 for a cache line or 32 for AVX)
+ * @param this Pointer to the st_malloc instance
+ * @param size The size of the block to be allocated
+ * @param align The alignment of the block, must be a power of two
+ * @return Pointer to the block (or NULL, also if "align" is not a power of two)
+ */
+void *st_malloc_aligned(st_malloc_t *this, st_size_t size, st_size_t align);
+
+/**
+ * Allocates a temporary block from the top of the heap.  Temporary blocks
+ * grow down towards the regular allocations and can be released on their own
+ * with "st_malloc_temp_free" without disturbing the objects below them.  In
+ * a chunked heap they are taken from the current block only.
+ * @param this Pointer to the st_malloc instance
+ * @param size The size of the block to be allocated
+ * @param align The alignment of the block, must be a power of two
+ * @return Pointer to the block (or NULL if it would meet the regular allocations)
+ */
+void *st_malloc_temp(st_malloc_t *this, st_size_t size, st_size_t align);
+
+/**
+ * Frees all of the temporary blocks
+ * @param this Pointer to the st_malloc instance
+ */
+void st_malloc_temp_free(st_malloc_t *this);
+
+/**
+ * Returns the number of bytes used by temporary blocks (including the ones
+ * left at the top of earlier blocks of a chunked heap)
+ * @param this Pointer to the st_malloc instance
+ * @return Number of bytes used by temporary blocks
+ */
+st_size_t st_malloc_temp_used_bytes(st_malloc_t *this);
+
+/**
+ * Hands a block back so that "st_malloc_struct" (or "st_malloc_var" for
+ * variables that need no more than pointer alignment) can reuse it for a
+ * request of the same size class.  Blocks that are too small or too large for the free lists
+ * are ignored.  The block must have been allocated from this instance with
+ * pointer alignment and must no longer be referenced.
+ * @param this Pointer to the st_malloc instance
+ * @param block Pointer to the block
+ * @param size The size the block was allocated with
+ */
+void st_malloc_recycle(st_malloc_t *this, void *block, st_size_t size);
+
+/**
+ * Returns "TRUE" if the buffer has overflowed.  The overflow is sticky, every
+ * following allocation fails until the heap is freed (or rewound to a mark
+ * taken before the overflow).
  * @param this Pointer to the st_malloc instance
  * @return "TRUE" if the buffer has overflowed
  */
 st_bool_t st_malloc_did_overflow(st_malloc_t *this);
 
 /**
- * Frees the ENTIRE heap
+ * Frees the ENTIRE heap (and empties the free lists).  A chunked heap returns
+ * to its first block and keeps the other blocks cached for reuse.
  * @param this Pointer to the st_malloc instance
  */
 void st_malloc_free(st_malloc_t *this);
 
 /**
- * Returns the number of bytes used in the heap
+ * Hands the cached blocks following the current one back to the provider
+ * @param this Pointer to the st_malloc instance
+ */
+void st_malloc_trim(st_malloc_t *this);
+
+/**
+ * Records the current position of the heap (both the regular and the
+ * temporary cursor) so that everything allocated after it can later be
+ * released with "st_malloc_rewind".  Marks can be
+ * nested but must be rewound in LIFO order.
+ * @param this Pointer to the st_malloc instance
+ * @param mark Pointer to the mark to be filled in
+ */
+void st_malloc_mark(st_malloc_t *this, st_malloc_mark_t *mark);
+
+/**
+ * Frees everything allocated since "mark" was taken.  Rewinding a mark also
+ * discards any marks nested inside of it and empties the free lists.
+ * @param this Pointer to the st_malloc instance
+ * @param mark Pointer to a mark taken with "st_malloc_mark"
+ * @return "TRUE" if the heap was rewound, "FALSE" if the mark is no longer
+ *         valid (it was already rewound or freed)
+ */
+st_bool_t st_malloc_rewind(st_malloc_t *this, st_malloc_mark_t *mark);
+
+/**
+ * Returns the extent of the current block touched since the last free (or
+ * since the block was entered), including allocations that were already
+ * rewound or freed as temporary blocks.  Providers use it to release the
+ * pages behind a spike.
+ * @param this Pointer to the st_malloc instance
+ * @param used_end Filled in with the highest end of the regular allocations
+ * @param temp_start Filled in with the lowest start of the temporary blocks
+ */
+void st_malloc_touched(st_malloc_t *this, st_byte_t **used_end, st_byte_t **temp_start);
+
+/**
+ * Returns the number of bytes used in the heap (across all blocks, including
+ * temporary ones)
  * @param this Pointer to the st_malloc instance
  * @return Number of bytes used by the heap
  */
 st_size_t st_malloc_used_bytes(st_malloc_t *this);
 
+/**
+ * Prints the usage statistics (does nothing unless ST_MALLOC_STATS is enabled)
+ * @param this Pointer to the st_malloc instance
+ * @param print A printf compatible function
+ */
+void st_malloc_stats_dump(st_malloc_t *this, int (*print)(const char *format, ...));
+
 #endif // __ST_OBJECTS_ST_MALLOC_H__
@@ -0,0 +1,110 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include "st_malloc_mmap.h"
+
+#define ST_MALLOC_MMAP_HUGE_PAGE (2*1024*1024)
+
+/**
+ * Releases the pages in [start, end).  The end is rounded up, the rest of its
+ * page is either unused or lies past the end of the heap inside the mapping.
+ */
+static void _st_malloc_mmap_release(st_ptr_t start, st_ptr_t end, st_ptr_t page)
+{
+    start = (start + page - 1) & ~(page - 1);
+    end = (end + page - 1) & ~(page - 1);
+    if (end > start) {
+        madvise((void *)start, end - start, MADV_DONTNEED);
+    }
+}
+
+static void _st_malloc_mmap_reset(void *context, st_malloc_t *malloc)
+{
+    st_malloc_mmap_t *this = context;
+    st_ptr_t page = (st_ptr_t)sysconf(_SC_PAGESIZE);
+    st_ptr_t threshold = (st_ptr_t)malloc->heap + this->release_threshold;
+    st_byte_t *used_end, *temp_start;
+    st_ptr_t temp;
+
+    if (this->release_threshold >= malloc->size) {
+        return;
+    }
+
+    // The allocator knows how far both cursors reached, also for spikes that were rewound
+    st_malloc_touched(malloc, &used_end, &temp_start);
+
+    // The page holding the start of the temporary blocks is entirely free as well
+    temp = (st_ptr_t)temp_start & ~(page - 1);
+    _st_malloc_mmap_release(threshold, (st_ptr_t)used_end, page);
+    _st_malloc_mmap_release(temp > threshold ? temp : threshold, (st_ptr_t)malloc->heap + malloc->size, page);
+}
+
+st_bool_t st_malloc_mmap_init(st_malloc_mmap_t *this, st_size_t size, st_size_t release_threshold,
+                              st_bool_t huge_pages)
+{
+    st_ptr_t heap;
+
+    // Reserve extra room so the heap can start on a huge page boundary
+    this->mapping_size = (size_t)size + (huge_pages ? ST_MALLOC_MMAP_HUGE_PAGE : 0);
+    this->mapping = mmap(NULL, this->mapping_size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if (this->mapping == MAP_FAILED) {
+        this->mapping = NULL;
+        return FALSE;
+    }
+
+    heap = (st_ptr_t)this->mapping;
+    if (huge_pages) {
+        heap = (heap + ST_MALLOC_MMAP_HUGE_PAGE - 1) & ~(st_ptr_t)(ST_MALLOC_MMAP_HUGE_PAGE - 1);
+#ifdef MADV_HUGEPAGE
+        madvise((void *)heap, size, MADV_HUGEPAGE);
+#endif
+    }
+
+    this->release_threshold = release_threshold;
+
+    this->provider.alloc = NULL;
+    this->provider.release = NULL;
+    this->provider.reset = _st_malloc_mmap_reset;
+    this->provider.context = this;
+    this->provider.chunk_size = 0;
+
+    st_malloc_init(&this->malloc, (st_byte_t *)heap, size);
+    this->malloc.provider = &this->provider;
+    return TRUE;
+}
+
+void st_malloc_mmap_destroy(st_malloc_mmap_t *this)
+{
+    if (this->mapping != NULL) {
+        munmap(this->mapping, this->mapping_size);
+        this->mapping = NULL;
+    }
+}
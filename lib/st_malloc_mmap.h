@@ -0,0 +1,68 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef __ST_OBJECTS_ST_MALLOC_MMAP_H__
+#define __ST_OBJECTS_ST_MALLOC_MMAP_H__
+
+#include "st_malloc.h"
+
+/**
+ * A large heap backed by virtual memory reserved with mmap (POSIX only).
+ * Pages are only committed when they are first touched.  When the heap is
+ * freed the pages above "release_threshold" that were touched since the last
+ * free (by regular or temporary allocations, even if they were already
+ * rewound) are given back with madvise(MADV_DONTNEED) so the RSS drops after
+ * a spike.  "malloc" is a regular st_malloc instance and is used with all of the
+ * usual methods.
+ */
+typedef struct st_malloc_mmap_s
+{
+    st_malloc_t malloc;
+    st_malloc_provider_t provider;
+    void *mapping;
+    size_t mapping_size;
+    st_size_t release_threshold;
+} st_malloc_mmap_t;
+
+/**
+ * Reserves the heap
+ * @param this Pointer to the st_malloc_mmap instance
+ * @param size The size of the heap to reserve
+ * @param release_threshold Used bytes above which pages are released on free
+ * @param huge_pages "TRUE" to request transparent huge pages for the heap
+ * @return "TRUE" if the memory could be reserved
+ */
+st_bool_t st_malloc_mmap_init(st_malloc_mmap_t *this, st_size_t size, st_size_t release_threshold,
+                              st_bool_t huge_pages);
+
+/**
+ * Unmaps the heap.  Every object allocated from it becomes invalid.
+ * @param this Pointer to the st_malloc_mmap instance
+ */
+void st_malloc_mmap_destroy(st_malloc_mmap_t *this);
+
+#endif // __ST_OBJECTS_ST_MALLOC_MMAP_H__
@@ -0,0 +1,110 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include "st_malloc_shared.h"
+
+static void *_st_malloc_shared_provide(void *context, st_size_t size)
+{
+    return st_malloc_shared_struct((st_malloc_shared_t *)context, size);
+}
+
+void st_malloc_shared_init(st_malloc_shared_t *this, st_byte_t *heap, st_size_t size, st_size_t chunk_size)
+{
+    this->heap = heap;
+    this->size = size;
+    atomic_init(&this->offset, 0);
+    atomic_init(&this->overflow, FALSE);
+    this->provider.alloc = _st_malloc_shared_provide;
+    this->provider.release = NULL;
+    this->provider.reset = NULL;
+    this->provider.context = this;
+    this->provider.chunk_size = chunk_size;
+}
+
+void *st_malloc_shared_aligned(st_malloc_shared_t *this, st_size_t size, st_size_t align)
+{
+    st_ptr_t mask = (st_ptr_t)align - 1;
+    st_size_t offset = atomic_load_explicit(&this->offset, memory_order_relaxed);
+    st_ptr_t start;
+
+    if (align == 0 || (align & (align - 1)) != 0) {
+        return NULL;
+    }
+
+    // Retry until no other thread moved the offset between the load and the swap.  The aligned start is
+    // only narrowed to a st_size_t once it is known to be inside of the heap, it could wrap around before
+    do {
+        start = (((st_ptr_t)this->heap + offset + mask) & ~mask) - (st_ptr_t)this->heap;
+        if (start > this->size || size > this->size - start) {
+            atomic_store_explicit(&this->overflow, TRUE, memory_order_relaxed);
+            return NULL;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&this->offset, &offset, ST_SIZE(start + size),
+                                                    memory_order_relaxed, memory_order_relaxed));
+
+    return this->heap + start;
+}
+
+void *st_malloc_shared_bytes(st_malloc_shared_t *this, st_size_t size)
+{
+    return st_malloc_shared_aligned(this, size, 1);
+}
+
+void *st_malloc_shared_struct(st_malloc_shared_t *this, st_size_t size)
+{
+    return st_malloc_shared_aligned(this, size, sizeof(st_ptr_t));
+}
+
+st_bool_t st_malloc_shared_init_local(st_malloc_shared_t *this, st_malloc_t *local)
+{
+    st_size_t size = this->provider.chunk_size;
+    st_byte_t *block = st_malloc_shared_struct(this, size);
+
+    if (block == NULL) {
+        st_malloc_init(local, NULL, 0);
+        return FALSE;
+    }
+
+    st_malloc_init_chunked(local, block, size, &this->provider);
+    return TRUE;
+}
+
+st_bool_t st_malloc_shared_did_overflow(st_malloc_shared_t *this)
+{
+    return ST_BOOL(atomic_load_explicit(&this->overflow, memory_order_relaxed));
+}
+
+void st_malloc_shared_free(st_malloc_shared_t *this)
+{
+    atomic_store(&this->offset, 0);
+    atomic_store(&this->overflow, FALSE);
+}
+
+st_size_t st_malloc_shared_used_bytes(st_malloc_shared_t *this)
+{
+    return atomic_load_explicit(&this->offset, memory_order_relaxed);
+}
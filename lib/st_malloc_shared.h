@@ -0,0 +1,116 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef __ST_OBJECTS_ST_MALLOC_SHARED_H__
+#define __ST_OBJECTS_ST_MALLOC_SHARED_H__
+
+#include <stdatomic.h>
+#include "st_malloc.h"
+
+/**
+ * A heap that can be allocated from by several threads at once.  The offset
+ * into the heap is bumped with a compare-and-swap so no lock is taken.
+ *
+ * Threads that build many objects should use a local st_malloc instance
+ * created with "st_malloc_shared_init_local".  It carves blocks from the
+ * shared heap and then allocates from them without any atomics.
+ */
+typedef struct st_malloc_shared_s
+{
+    st_byte_t *heap;
+    st_size_t size;
+    _Atomic st_size_t offset;
+    atomic_bool overflow;
+    st_malloc_provider_t provider;
+} st_malloc_shared_t;
+
+/**
+ * Initializes the shared heap
+ * @param this Pointer to the st_malloc_shared instance
+ * @param heap Pointer to the buffer used as the heap
+ * @param size The size of the heap
+ * @param chunk_size The size of the blocks handed to local instances
+ */
+void st_malloc_shared_init(st_malloc_shared_t *this, st_byte_t *heap, st_size_t size, st_size_t chunk_size);
+
+/**
+ * Allocates an aligned block.  Safe to call from any thread.
+ * @param this Pointer to the st_malloc_shared instance
+ * @param size The size of the block to be allocated
+ * @param align The alignment of the block, must be a power of two
+ * @return Pointer to the block (or NULL)
+ */
+void *st_malloc_shared_aligned(st_malloc_shared_t *this, st_size_t size, st_size_t align);
+
+/**
+ * Allocates an array of bytes.  Safe to call from any thread.
+ * @param this Pointer to the st_malloc_shared instance
+ * @param size The size of the bytes array to be allocated
+ * @return Pointer to the byte array (or NULL)
+ */
+void *st_malloc_shared_bytes(st_malloc_shared_t *this, st_size_t size);
+
+/**
+ * Allocates a structure aligned to the size of "uintptr_t".  Safe to call from any thread.
+ * @param this Pointer to the st_malloc_shared instance
+ * @param size The size of the structure to be allocated
+ * @return Pointer to the structure (or NULL)
+ */
+void *st_malloc_shared_struct(st_malloc_shared_t *this, st_size_t size);
+
+/**
+ * Initializes a thread-local st_malloc instance whose blocks are carved from
+ * the shared heap.  The local instance must only be used by one thread and is
+ * invalid after "st_malloc_shared_free" until it is initialized again.
+ * @param this Pointer to the st_malloc_shared instance
+ * @param local Pointer to the st_malloc instance to initialize
+ * @return "TRUE" if the first block could be carved from the shared heap
+ */
+st_bool_t st_malloc_shared_init_local(st_malloc_shared_t *this, st_malloc_t *local);
+
+/**
+ * Returns "TRUE" if an allocation did not fit in the heap
+ * @param this Pointer to the st_malloc_shared instance
+ * @return "TRUE" if the heap has overflowed
+ */
+st_bool_t st_malloc_shared_did_overflow(st_malloc_shared_t *this);
+
+/**
+ * Frees the ENTIRE heap including the blocks of every local instance.  Must
+ * not be called while other threads are allocating.
+ * @param this Pointer to the st_malloc_shared instance
+ */
+void st_malloc_shared_free(st_malloc_shared_t *this);
+
+/**
+ * Returns the number of bytes used in the heap
+ * @param this Pointer to the st_malloc_shared instance
+ * @return Number of bytes used by the heap
+ */
+st_size_t st_malloc_shared_used_bytes(st_malloc_shared_t *this);
+
+#endif // __ST_OBJECTS_ST_MALLOC_SHARED_H__
@@ -25,57 +25,297 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 */
 
-#include "st_object.h"
+#include "st_dict.h"
+#include "st_typed_array.h"
 #include <string.h>
 
+static st_bool_t _st_object_compare_containers(st_object_t *object1, st_object_t *object2, st_object_type_t type);
+
 st_object_t *st_object_new(st_malloc_t *malloc, st_object_type_t type, void *value)
 {
-    st_object_t *object = st_malloc_struct(malloc, sizeof(st_object_t));
-    st_object_set(object, type, value);
+    st_object_t *object;
+
+#if ST_OBJECT_NAN_BOX
+    // A long does not fit the NaN payload and is boxed
+    if (type == ST_OBJECT_TYPE_LONG) {
+        st_long_t *boxed = st_malloc_var(malloc, sizeof(st_long_t));
+        if (boxed == NULL) {
+            return NULL;
+        }
+        *boxed = *(st_long_t *)value;
+        value = boxed;
+    }
+#endif
+
+    object = st_malloc_struct(malloc, sizeof(st_object_t));
+    if (object != NULL) {
+        st_object_set(object, type, value);
+    }
     return object;
 }
 
+#if ST_OBJECT_NAN_BOX
+
+/**
+ * Every value that is not a double is a negative quiet NaN.  Bits 48-50 hold
+ * the tag and bits 0-47 the payload.  NaN doubles are stored as the positive
+ * canonical NaN, so all eight tags are free: the type plus one for dicts to
+ * bools, floats are never tagged so blobs take their tag, and typed arrays
+ * take tag 0.
+ */
+#define ST_NAN_BOX_TAG(type) ((uint64_t)(((type) == ST_OBJECT_TYPE_TYPED_ARRAY)?0xfff8: \
+                                         0xfff9 + (((type) == ST_OBJECT_TYPE_BLOB)?ST_OBJECT_TYPE_FLOAT:(type))))
+#define ST_NAN_BOX_FIRST_TAG ST_NAN_BOX_TAG(ST_OBJECT_TYPE_TYPED_ARRAY)
+#define ST_NAN_BOX_PAYLOAD ((UINT64_C(1) << 48) - 1)
+#define ST_NAN_BOX_CANONICAL_NAN UINT64_C(0x7ff8000000000000)
+
+#define ST_NAN_BOX_IS(bits, type) (((bits) >> 48) == ST_NAN_BOX_TAG(type))
+#define ST_NAN_BOX_POINTER(bits) ((void *)(uintptr_t)((bits) & ST_NAN_BOX_PAYLOAD))
+
+void st_object_set(st_object_t *this, st_object_type_t type, void *value)
+{
+    st_float_t real;
+
+    switch(type) {
+        case ST_OBJECT_TYPE_BOOL:
+            this->bits = (ST_NAN_BOX_TAG(type) << 48) | (*(st_bool_t *)value != 0);
+            break;
+        case ST_OBJECT_TYPE_INT:
+            this->bits = (ST_NAN_BOX_TAG(type) << 48) | (uint32_t)*(st_int_t *)value;
+            break;
+        case ST_OBJECT_TYPE_FLOAT:
+            real = *(st_float_t *)value;
+            if (real != real) {
+                this->bits = ST_NAN_BOX_CANONICAL_NAN;
+            }
+            else {
+                memcpy(&this->bits, &real, sizeof(real));
+            }
+            break;
+        default:
+            this->bits = (ST_NAN_BOX_TAG(type) << 48) | ((uint64_t)(uintptr_t)value & ST_NAN_BOX_PAYLOAD);
+            break;
+    }
+}
+
+st_object_type_t st_object_get_type(st_object_t *this)
+{
+    uint64_t tag = this->bits >> 48;
+
+    switch(tag) {
+        case ST_NAN_BOX_TAG(ST_OBJECT_TYPE_TYPED_ARRAY):
+            return ST_OBJECT_TYPE_TYPED_ARRAY;
+        case ST_NAN_BOX_TAG(ST_OBJECT_TYPE_BLOB):
+            return ST_OBJECT_TYPE_BLOB;
+        default:
+            return (tag > ST_NAN_BOX_FIRST_TAG)?(st_object_type_t)(tag - ST_NAN_BOX_TAG(0)):ST_OBJECT_TYPE_FLOAT;
+    }
+}
+
+/* Returns the record of a string or blob */
+static st_object_string_t *_st_object_record(st_object_t *this)
+{
+    return (ST_NAN_BOX_IS(this->bits, ST_OBJECT_TYPE_STR) || ST_NAN_BOX_IS(this->bits, ST_OBJECT_TYPE_BLOB))?
+           ST_NAN_BOX_POINTER(this->bits):NULL;
+}
+
+static void _st_object_set_record(st_object_t *this, st_object_string_t *record)
+{
+    this->bits = (this->bits & ~ST_NAN_BOX_PAYLOAD) | (uint64_t)(uintptr_t)record;
+}
+
+#else
+
 void st_object_set(st_object_t *this, st_object_type_t type, void *value)
 {
     this->type = type;
-    this->value = value;
+
+    switch(type) {
+        case ST_OBJECT_TYPE_BOOL:
+            this->value.boolean = *(st_bool_t *)value;
+            break;
+        case ST_OBJECT_TYPE_INT:
+            this->value.integer = *(st_int_t *)value;
+            break;
+        case ST_OBJECT_TYPE_LONG:
+            this->value.long_integer = *(st_long_t *)value;
+            break;
+        case ST_OBJECT_TYPE_FLOAT:
+            this->value.real = *(st_float_t *)value;
+            break;
+        default:
+            this->value.pointer = value;
+            break;
+    }
+}
+
+st_object_type_t st_object_get_type(st_object_t *this)
+{
+    return this->type;
+}
+
+/* Returns the record of a string or blob */
+static st_object_string_t *_st_object_record(st_object_t *this)
+{
+    return (this->type == ST_OBJECT_TYPE_STR || this->type == ST_OBJECT_TYPE_BLOB)?this->value.pointer:NULL;
+}
+
+static void _st_object_set_record(st_object_t *this, st_object_string_t *record)
+{
+    this->value.pointer = record;
+}
+
+#endif
+
+static st_object_string_t *_st_object_string(st_object_t *this)
+{
+    return (st_object_get_type(this) == ST_OBJECT_TYPE_STR)?_st_object_record(this):NULL;
+}
+
+static st_object_string_t *_st_object_blob(st_object_t *this)
+{
+    return (st_object_get_type(this) == ST_OBJECT_TYPE_BLOB)?_st_object_record(this):NULL;
+}
+
+/* Rejects on the cached length and hash before comparing the bytes */
+static st_bool_t _st_object_compare_strings(st_object_t *object1, st_object_t *object2)
+{
+    st_object_string_t *string1 = _st_object_record(object1);
+    st_object_string_t *string2 = _st_object_record(object2);
+
+    return ST_BOOL(string1->length == string2->length && string1->hash == string2->hash &&
+                   memcmp(string1->data, string2->data, string1->length) == 0);
+}
+
+/* FNV-1a */
+uint32_t st_object_hash_string(const char *value, st_size_t length)
+{
+    uint32_t hash = 2166136261u;
+    st_size_t i;
+
+    for (i=0; i<length; i++) {
+        hash = (hash ^ (uint8_t)value[i]) * 16777619u;
+    }
+    return hash;
+}
+
+st_string_t st_object_get_string(st_object_t *this)
+{
+    st_object_string_t *string = _st_object_string(this);
+    return (string != NULL)?string->data:NULL;
+}
+
+st_size_t st_object_get_string_length(st_object_t *this)
+{
+    st_object_string_t *string = _st_object_string(this);
+    return (string != NULL)?string->length:0;
+}
+
+uint32_t st_object_get_string_hash(st_object_t *this)
+{
+    st_object_string_t *string = _st_object_string(this);
+    return (string != NULL)?string->hash:0;
+}
+
+const st_byte_t *st_object_get_blob(st_object_t *this)
+{
+    st_object_string_t *blob = _st_object_blob(this);
+    return (blob != NULL)?(const st_byte_t *)blob->data:NULL;
+}
+
+st_size_t st_object_get_blob_length(st_object_t *this)
+{
+    st_object_string_t *blob = _st_object_blob(this);
+    return (blob != NULL)?blob->length:0;
+}
+
+st_bool_t st_object_is_borrowed(st_object_t *this)
+{
+    st_object_string_t *record = _st_object_record(this);
+    return ST_BOOL(record != NULL && record->data != (st_string_t)(record + 1));
+}
+
+/* Creates a string or blob, owned bytes follow the record in the same allocation */
+static st_object_t *_st_object_new_record(st_malloc_t *malloc, st_object_type_t type, const void *value,
+                                          st_size_t length, st_bool_t borrow)
+{
+    st_object_string_t *record;
+    st_size_t size = sizeof(st_object_string_t);
+
+    if (!borrow) {
+        if (length > ST_SIZE_MAX - sizeof(st_object_string_t) - 1) {
+            return NULL;
+        }
+        size = ST_SIZE(size + length + 1);
+    }
+
+    record = st_malloc_struct(malloc, size);
+    if (record == NULL) {
+        return NULL;
+    }
+
+    record->length = length;
+    record->hash = st_object_hash_string(value, length);
+    if (borrow) {
+        record->data = (st_string_t)value;
+    }
+    else {
+        record->data = (st_string_t)(record + 1);
+        memcpy(record->data, value, length);
+        record->data[length] = '\0';
+    }
+    return st_object_new(malloc, type, record);
 }
 
 st_object_t *st_object_new_bool(st_malloc_t *malloc, st_bool_t value)
 {
-    st_bool_t *temp_value = st_malloc_var(malloc, sizeof(st_bool_t));
-    *temp_value = value;
-    return st_object_new(malloc, ST_OBJECT_TYPE_BOOL, temp_value);
+    return st_object_new(malloc, ST_OBJECT_TYPE_BOOL, &value);
 }
 
 st_object_t *st_object_new_int(st_malloc_t *malloc, st_int_t value)
 {
-    st_int_t *temp_value = st_malloc_var(malloc, sizeof(st_int_t));
-    *temp_value = value;
-    return st_object_new(malloc, ST_OBJECT_TYPE_INT, temp_value);
+    return st_object_new(malloc, ST_OBJECT_TYPE_INT, &value);
 }
 
 st_object_t *st_object_new_long(st_malloc_t *malloc, st_long_t value)
 {
-    st_long_t *temp_value = st_malloc_var(malloc, sizeof(st_long_t));
-    *temp_value = value;
-    return st_object_new(malloc, ST_OBJECT_TYPE_LONG, temp_value);
+    return st_object_new(malloc, ST_OBJECT_TYPE_LONG, &value);
 }
 
 st_object_t *st_object_new_float(st_malloc_t *malloc, st_float_t value)
 {
-    st_float_t *temp_value = st_malloc_var(malloc, sizeof(st_float_t));
-    *temp_value = value;
-    return st_object_new(malloc, ST_OBJECT_TYPE_FLOAT, temp_value);
+    return st_object_new(malloc, ST_OBJECT_TYPE_FLOAT, &value);
 }
 
 st_object_t *st_object_new_string(st_malloc_t *malloc, st_string_t value)
 {
     size_t length = strlen(value);
-    st_string_t temp_value = st_malloc_bytes(malloc, ST_SIZE(length+1));
-    strcpy(temp_value, value);
-    temp_value[length] = '\0';
-    return st_object_new(malloc, ST_OBJECT_TYPE_STR, temp_value);
+
+    // The string record (and the terminator) must be addressable by st_size_t
+    if (length > (size_t)(ST_SIZE_MAX - sizeof(st_object_string_t) - 1)) {
+        return NULL;
+    }
+    return st_object_new_string_n(malloc, value, ST_SIZE(length));
+}
+
+st_object_t *st_object_new_string_n(st_malloc_t *malloc, const char *value, st_size_t length)
+{
+    return _st_object_new_record(malloc, ST_OBJECT_TYPE_STR, value, length, FALSE);
+}
+
+st_object_t *st_object_new_string_ref(st_malloc_t *malloc, const char *value, st_size_t length)
+{
+    return _st_object_new_record(malloc, ST_OBJECT_TYPE_STR, value, length, TRUE);
+}
+
+st_object_t *st_object_new_blob(st_malloc_t *malloc, const void *value, st_size_t length)
+{
+    return _st_object_new_record(malloc, ST_OBJECT_TYPE_BLOB, value, length, FALSE);
+}
+
+st_object_t *st_object_new_blob_ref(st_malloc_t *malloc, const void *value, st_size_t length)
+{
+    return _st_object_new_record(malloc, ST_OBJECT_TYPE_BLOB, value, length, TRUE);
 }
 
 st_object_t *st_object_new_array(st_malloc_t *malloc, struct st_array_s *value)
@@ -88,39 +328,123 @@ st_object_t *st_object_new_dict(st_malloc_t *malloc, struct st_dict_s *value)
     return st_object_new(malloc, ST_OBJECT_TYPE_DICT, value);
 }
 
+st_object_t *st_object_new_typed_array(st_malloc_t *malloc, struct st_typed_array_s *value)
+{
+    return st_object_new(malloc, ST_OBJECT_TYPE_TYPED_ARRAY, value);
+}
+
+#if ST_OBJECT_NAN_BOX
+
 st_bool_t st_object_get_bool(st_object_t *this)
 {
-    return (this->type == ST_OBJECT_TYPE_BOOL)?*((st_bool_t *)this->value):(st_bool_t)0;
+    return ST_BOOL(ST_NAN_BOX_IS(this->bits, ST_OBJECT_TYPE_BOOL) & this->bits);
 }
 
 st_int_t st_object_get_int(st_object_t *this)
 {
-    return (this->type == ST_OBJECT_TYPE_INT)?*((st_int_t *)this->value):0;
+    return ST_NAN_BOX_IS(this->bits, ST_OBJECT_TYPE_INT)?(st_int_t)(uint32_t)this->bits:0;
 }
 
 st_long_t st_object_get_long(st_object_t *this)
 {
-    return (this->type == ST_OBJECT_TYPE_LONG)?*((st_long_t *)this->value):0;
+    return ST_NAN_BOX_IS(this->bits, ST_OBJECT_TYPE_LONG)?*(st_long_t *)ST_NAN_BOX_POINTER(this->bits):0;
 }
 
 st_float_t st_object_get_float(st_object_t *this)
 {
-    return (this->type == ST_OBJECT_TYPE_FLOAT)?*((st_float_t *)this->value):0;
+    st_float_t real;
+
+    if ((this->bits >> 48) >= ST_NAN_BOX_FIRST_TAG) {
+        return 0;
+    }
+    memcpy(&real, &this->bits, sizeof(real));
+    return real;
 }
 
-st_string_t st_object_get_string(st_object_t *this)
+struct st_array_s *st_object_get_array(st_object_t *this)
+{
+    return ST_NAN_BOX_IS(this->bits, ST_OBJECT_TYPE_ARRAY)?ST_NAN_BOX_POINTER(this->bits):NULL;
+}
+
+struct st_dict_s *st_object_get_dict(st_object_t *this)
+{
+    return ST_NAN_BOX_IS(this->bits, ST_OBJECT_TYPE_DICT)?ST_NAN_BOX_POINTER(this->bits):NULL;
+}
+
+struct st_typed_array_s *st_object_get_typed_array(st_object_t *this)
 {
-    return (this->type == ST_OBJECT_TYPE_STR)?((st_string_t)this->value):NULL;
+    return ST_NAN_BOX_IS(this->bits, ST_OBJECT_TYPE_TYPED_ARRAY)?ST_NAN_BOX_POINTER(this->bits):NULL;
+}
+
+st_bool_t st_object_compare(st_object_t *object1, st_object_t *object2)
+{
+    st_object_type_t type;
+
+    // Equal words are equal values, except for NaN which is never equal to itself
+    if (object1 == object2 || object1->bits == object2->bits)
+    {
+        return ST_BOOL(object1 == object2 || object1->bits != ST_NAN_BOX_CANONICAL_NAN);
+    }
+
+    type = st_object_get_type(object1);
+    if (type != st_object_get_type(object2))
+    {
+        return FALSE;
+    }
+
+    // Otherwise only values that are not held in the word itself can match
+    switch(type) {
+        case ST_OBJECT_TYPE_STR:
+        case ST_OBJECT_TYPE_BLOB:
+            return _st_object_compare_strings(object1, object2);
+        case ST_OBJECT_TYPE_LONG:
+            return ST_BOOL(st_object_get_long(object1) == st_object_get_long(object2));
+        case ST_OBJECT_TYPE_FLOAT:
+            return ST_BOOL(st_object_get_float(object1) == st_object_get_float(object2));
+        case ST_OBJECT_TYPE_ARRAY:
+        case ST_OBJECT_TYPE_DICT:
+        case ST_OBJECT_TYPE_TYPED_ARRAY:
+            return _st_object_compare_containers(object1, object2, type);
+        default:
+            return FALSE;
+    }
+}
+
+#else
+
+st_bool_t st_object_get_bool(st_object_t *this)
+{
+    return (this->type == ST_OBJECT_TYPE_BOOL)?this->value.boolean:(st_bool_t)0;
+}
+
+st_int_t st_object_get_int(st_object_t *this)
+{
+    return (this->type == ST_OBJECT_TYPE_INT)?this->value.integer:0;
+}
+
+st_long_t st_object_get_long(st_object_t *this)
+{
+    return (this->type == ST_OBJECT_TYPE_LONG)?this->value.long_integer:0;
+}
+
+st_float_t st_object_get_float(st_object_t *this)
+{
+    return (this->type == ST_OBJECT_TYPE_FLOAT)?this->value.real:0;
 }
 
 struct st_array_s *st_object_get_array(st_object_t *this)
 {
-    return (this->type == ST_OBJECT_TYPE_ARRAY)?((struct st_array_s *)this->value):NULL;
+    return (this->type == ST_OBJECT_TYPE_ARRAY)?((struct st_array_s *)this->value.pointer):NULL;
 }
 
 struct st_dict_s *st_object_get_dict(st_object_t *this)
 {
-    return (this->type == ST_OBJECT_TYPE_DICT)?((struct st_dict_s *)this->value):NULL;
+    return (this->type == ST_OBJECT_TYPE_DICT)?((struct st_dict_s *)this->value.pointer):NULL;
+}
+
+struct st_typed_array_s *st_object_get_typed_array(st_object_t *this)
+{
+    return (this->type == ST_OBJECT_TYPE_TYPED_ARRAY)?((struct st_typed_array_s *)this->value.pointer):NULL;
 }
 
 st_bool_t st_object_compare(st_object_t *object1, st_object_t *object2)
@@ -137,7 +461,8 @@ st_bool_t st_object_compare(st_object_t *object1, st_object_t *object2)
 
     switch(object1->type) {
         case ST_OBJECT_TYPE_STR:
-            return ST_BOOL(strcmp(object1->value, object2->value) == 0);
+        case ST_OBJECT_TYPE_BLOB:
+            return _st_object_compare_strings(object1, object2);
         case ST_OBJECT_TYPE_BOOL:
             return ST_BOOL(st_object_get_bool(object1) == st_object_get_bool(object2));
         case ST_OBJECT_TYPE_INT:
@@ -148,8 +473,483 @@ st_bool_t st_object_compare(st_object_t *object1, st_object_t *object2)
             return ST_BOOL(st_object_get_float(object1) == st_object_get_float(object2));
         case ST_OBJECT_TYPE_ARRAY:
         case ST_OBJECT_TYPE_DICT:
-            return ST_BOOL(object1->value == object2->value);
+        case ST_OBJECT_TYPE_TYPED_ARRAY:
+            return _st_object_compare_containers(object1, object2, object1->type);
+        default:
+            return FALSE;
+    }
+}
+
+#endif
+
+/* Structural comparison and hashing */
+
+static st_bool_t _st_object_compare_values(st_object_t *object1, st_object_t *object2)
+{
+    return (object1 == NULL || object2 == NULL)?ST_BOOL(object1 == object2):st_object_compare(object1, object2);
+}
+
+/* Elements are compared in order, the sizes are already known to match (cursors walk every storage mode) */
+static st_bool_t _st_object_compare_arrays(struct st_array_s *array1, struct st_array_s *array2)
+{
+    st_array_cursor_t cursor1, cursor2;
+
+    for (st_array_cursor_init(&cursor1, array1, FALSE), st_array_cursor_init(&cursor2, array2, FALSE);
+         !st_array_cursor_at_end(&cursor1); st_array_cursor_next(&cursor1), st_array_cursor_next(&cursor2))
+    {
+        if (!_st_object_compare_values(st_array_cursor_get_object(&cursor1), st_array_cursor_get_object(&cursor2))) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/* Every entry of the first dict must be in the second, the sizes are already known to match */
+static st_bool_t _st_object_compare_dicts(struct st_array_s *array1, struct st_array_s *array2)
+{
+    st_array_cursor_t cursor1, cursor2;
+    st_object_t *key;
+    st_link_t *link2;
+
+    ST_ARRAY_CURSOR_FOREACH(&cursor1, array1) {
+        key = st_array_cursor_get_key(&cursor1);
+        if (array2->index != NULL && key != NULL) {
+            link2 = st_index_find(array2->index, key);
+            if (link2 == NULL || !_st_object_compare_values(st_array_cursor_get_object(&cursor1), link2->object)) {
+                return FALSE;
+            }
+            continue;
+        }
+
+        for (st_array_cursor_init(&cursor2, array2, FALSE);
+             !st_array_cursor_at_end(&cursor2) && !_st_object_compare_values(key, st_array_cursor_get_key(&cursor2));
+             st_array_cursor_next(&cursor2));
+
+        if (st_array_cursor_at_end(&cursor2) ||
+            !_st_object_compare_values(st_array_cursor_get_object(&cursor1), st_array_cursor_get_object(&cursor2)))
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static st_bool_t _st_object_compare_typed_arrays(st_typed_array_t *array1, st_typed_array_t *array2)
+{
+    return ST_BOOL(array1->type == array2->type && array1->size == array2->size &&
+                   (array1->size == 0 ||
+                    memcmp(array1->data, array2->data, array1->size * st_typed_array_get_element_size(array1)) == 0));
+}
+
+static st_bool_t _st_object_compare_containers(st_object_t *object1, st_object_t *object2, st_object_type_t type)
+{
+    struct st_array_s *array1, *array2;
+
+    if (type == ST_OBJECT_TYPE_TYPED_ARRAY) {
+        return _st_object_compare_typed_arrays(st_object_get_typed_array(object1), st_object_get_typed_array(object2));
+    }
+
+    array1 = (type == ST_OBJECT_TYPE_DICT)?st_object_get_dict(object1)->array:st_object_get_array(object1);
+    array2 = (type == ST_OBJECT_TYPE_DICT)?st_object_get_dict(object2)->array:st_object_get_array(object2);
+
+    // Frozen containers reject on their cached hashes before walking the links
+    if (array1 == array2) {
+        return TRUE;
+    }
+    if (array1->size != array2->size || (array1->frozen && array2->frozen && array1->hash != array2->hash)) {
+        return FALSE;
+    }
+    return (type == ST_OBJECT_TYPE_DICT)?_st_object_compare_dicts(array1, array2):
+                                         _st_object_compare_arrays(array1, array2);
+}
+
+/* Murmur3 finalizer, spreads every bit of a value over the hash */
+static uint32_t _st_object_hash_word(st_object_type_t type, uint32_t value)
+{
+    uint32_t hash = value ^ ((uint32_t)type * 0x9e3779b9u);
+
+    hash = (hash ^ (hash >> 16)) * 0x85ebca6bu;
+    hash = (hash ^ (hash >> 13)) * 0xc2b2ae35u;
+    return hash ^ (hash >> 16);
+}
+
+static uint32_t _st_object_hash_long(st_object_type_t type, uint64_t value)
+{
+    return _st_object_hash_word(type, (uint32_t)value ^ _st_object_hash_word(type, (uint32_t)(value >> 32)));
+}
+
+/**
+ * The elements of a container.  Typed arrays stay mutable inside a frozen
+ * container, so only their element type goes into the container's hash (which
+ * is cached once it is frozen).
+ */
+static uint32_t _st_object_hash_value(st_object_t *this)
+{
+    if (this != NULL && st_object_get_type(this) == ST_OBJECT_TYPE_TYPED_ARRAY) {
+        return _st_object_hash_word(ST_OBJECT_TYPE_TYPED_ARRAY, (uint32_t)st_object_get_typed_array(this)->type);
+    }
+    return (this != NULL)?st_object_hash(this):0;
+}
+
+/* Arrays are hashed in order, dicts add up the hashes of their entries so the order does not matter */
+static uint32_t _st_object_hash_links(st_object_type_t type, struct st_array_s *array)
+{
+    uint32_t hash = 2166136261u;
+    st_array_cursor_t cursor;
+
+    if (array->frozen) {
+        return array->hash;
+    }
+
+    ST_ARRAY_CURSOR_FOREACH(&cursor, array) {
+        if (type == ST_OBJECT_TYPE_DICT) {
+            hash += _st_object_hash_word(type, _st_object_hash_value(st_array_cursor_get_key(&cursor)) * 31 +
+                                               _st_object_hash_value(st_array_cursor_get_object(&cursor)));
+        }
+        else {
+            hash = (hash ^ _st_object_hash_value(st_array_cursor_get_object(&cursor))) * 16777619u;
+        }
+    }
+    return _st_object_hash_word(type, hash ^ (uint32_t)array->size);
+}
+
+uint32_t st_object_hash(st_object_t *this)
+{
+    st_object_type_t type = st_object_get_type(this);
+    st_typed_array_t *typed_array;
+    st_float_t real;
+    uint64_t bits;
+
+    switch(type) {
+        case ST_OBJECT_TYPE_BOOL:
+            return _st_object_hash_word(type, st_object_get_bool(this) != 0);
+        case ST_OBJECT_TYPE_INT:
+            return _st_object_hash_word(type, (uint32_t)st_object_get_int(this));
+        case ST_OBJECT_TYPE_LONG:
+            return _st_object_hash_long(type, (uint64_t)st_object_get_long(this));
+        case ST_OBJECT_TYPE_FLOAT:
+            // 0.0 and -0.0 are equal and must hash the same
+            real = st_object_get_float(this);
+            real = (real == 0)?0:real;
+            memcpy(&bits, &real, sizeof(bits));
+            return _st_object_hash_long(type, bits);
+        case ST_OBJECT_TYPE_STR:
+        case ST_OBJECT_TYPE_BLOB:
+            return _st_object_hash_word(type, _st_object_record(this)->hash);
+        case ST_OBJECT_TYPE_TYPED_ARRAY:
+            typed_array = st_object_get_typed_array(this);
+            return _st_object_hash_word(type, st_object_hash_string((const char *)typed_array->data,
+                                        ST_SIZE(typed_array->size * st_typed_array_get_element_size(typed_array))) ^
+                                        (uint32_t)typed_array->type);
+        case ST_OBJECT_TYPE_ARRAY:
+            return _st_object_hash_links(type, st_object_get_array(this));
+        case ST_OBJECT_TYPE_DICT:
+            return _st_object_hash_links(type, st_object_get_dict(this)->array);
+        default:
+            return 0;
+    }
+}
+
+void st_object_set_frozen(st_object_t *this)
+{
+    st_object_type_t type = st_object_get_type(this);
+    struct st_array_s *array;
+    st_array_cursor_t cursor;
+    st_object_t *key, *object;
+
+    if (type != ST_OBJECT_TYPE_ARRAY && type != ST_OBJECT_TYPE_DICT) {
+        return;
+    }
+
+    array = (type == ST_OBJECT_TYPE_DICT)?st_object_get_dict(this)->array:st_object_get_array(this);
+    if (array->frozen) {
+        return;
+    }
+
+    // The nested containers cache their hashes first so that this one is computed in a single pass
+    ST_ARRAY_CURSOR_FOREACH(&cursor, array) {
+        if ((key = st_array_cursor_get_key(&cursor)) != NULL) {
+            st_object_set_frozen(key);
+        }
+        if ((object = st_array_cursor_get_object(&cursor)) != NULL) {
+            st_object_set_frozen(object);
+        }
+    }
+
+    array->hash = _st_object_hash_links(type, array);
+    array->frozen = TRUE;
+}
+
+st_bool_t st_object_is_frozen(st_object_t *this)
+{
+    switch(st_object_get_type(this)) {
+        case ST_OBJECT_TYPE_ARRAY:
+            return st_object_get_array(this)->frozen;
+        case ST_OBJECT_TYPE_DICT:
+            return st_object_get_dict(this)->array->frozen;
+        default:
+            return FALSE;
+    }
+}
+
+/* Total order */
+
+#define ST_OBJECT_ORDER(a, b) (((a) > (b)) - ((a) < (b)))
+
+/* Rank of a type in the total order, all of the numbers share one rank */
+static int _st_object_order_rank(st_object_type_t type)
+{
+    switch(type) {
+        case ST_OBJECT_TYPE_BOOL:
+            return 0;
+        case ST_OBJECT_TYPE_INT:
+        case ST_OBJECT_TYPE_LONG:
+        case ST_OBJECT_TYPE_FLOAT:
+            return 1;
+        case ST_OBJECT_TYPE_STR:
+            return 2;
+        case ST_OBJECT_TYPE_BLOB:
+            return 3;
+        case ST_OBJECT_TYPE_TYPED_ARRAY:
+            return 4;
+        case ST_OBJECT_TYPE_ARRAY:
+            return 5;
+        default:
+            return 6;
+    }
+}
+
+/* NaN is greater than every other double and equal to itself */
+static int _st_object_order_reals(st_float_t real1, st_float_t real2)
+{
+    if (real1 != real1 || real2 != real2) {
+        return (real1 != real1) - (real2 != real2);
+    }
+    return ST_OBJECT_ORDER(real1, real2);
+}
+
+/* Orders a long against a double without rounding the long */
+static int _st_object_order_long_real(st_long_t value, st_float_t real)
+{
+    if (real != real || real >= 9223372036854775808.0) {
+        return -1;
+    }
+    if (real < -9223372036854775808.0) {
+        return 1;
+    }
+    if ((st_float_t)value != real) {
+        return ST_OBJECT_ORDER((st_float_t)value, real);
+    }
+    return ST_OBJECT_ORDER(value, (st_long_t)real);
+}
+
+static st_long_t _st_object_order_long(st_object_t *this)
+{
+    return (st_object_get_type(this) == ST_OBJECT_TYPE_INT)?st_object_get_int(this):st_object_get_long(this);
+}
+
+/* Numbers are ordered by value, equal values by type (int, long, float) */
+static int _st_object_order_numbers(st_object_t *object1, st_object_t *object2)
+{
+    st_object_type_t type1 = st_object_get_type(object1), type2 = st_object_get_type(object2);
+    int order;
+
+    if (type1 == ST_OBJECT_TYPE_FLOAT && type2 == ST_OBJECT_TYPE_FLOAT) {
+        order = _st_object_order_reals(st_object_get_float(object1), st_object_get_float(object2));
+    }
+    else if (type1 == ST_OBJECT_TYPE_FLOAT) {
+        order = -_st_object_order_long_real(_st_object_order_long(object2), st_object_get_float(object1));
+    }
+    else if (type2 == ST_OBJECT_TYPE_FLOAT) {
+        order = _st_object_order_long_real(_st_object_order_long(object1), st_object_get_float(object2));
+    }
+    else {
+        order = ST_OBJECT_ORDER(_st_object_order_long(object1), _st_object_order_long(object2));
+    }
+    return (order != 0)?order:ST_OBJECT_ORDER(type1, type2);
+}
+
+static int _st_object_order_bytes(st_object_string_t *record1, st_object_string_t *record2)
+{
+    st_size_t length = (record1->length < record2->length)?record1->length:record2->length;
+    int order = (length > 0)?memcmp(record1->data, record2->data, length):0;
+
+    return (order != 0)?ST_OBJECT_ORDER(order, 0):ST_OBJECT_ORDER(record1->length, record2->length);
+}
+
+/**
+ * Typed arrays compare their bytes, so floats that are equal by value but not
+ * bit for bit (0.0 and -0.0, NaNs with different payloads) are ordered by
+ * their bits to keep the order 0 exactly when the arrays compare equal.
+ */
+static int _st_object_order_typed_arrays(st_typed_array_t *array1, st_typed_array_t *array2)
+{
+    st_size_t i;
+    uint64_t bits1, bits2;
+    int order = ST_OBJECT_ORDER(array1->type, array2->type);
+
+    for (i=0; order == 0 && i < array1->size && i < array2->size; i++) {
+        if (array1->type == ST_TYPED_ARRAY_INT64) {
+            order = ST_OBJECT_ORDER(st_typed_array_get_long(array1, i), st_typed_array_get_long(array2, i));
+        }
+        else {
+            order = _st_object_order_reals(st_typed_array_get_float(array1, i), st_typed_array_get_float(array2, i));
+        }
+        if (order == 0 && array1->type == ST_TYPED_ARRAY_FLOAT64) {
+            memcpy(&bits1, array1->data + i * sizeof(uint64_t), sizeof(bits1));
+            memcpy(&bits2, array2->data + i * sizeof(uint64_t), sizeof(bits2));
+            order = ST_OBJECT_ORDER(bits1, bits2);
+        }
+    }
+    return (order != 0)?order:ST_OBJECT_ORDER(array1->size, array2->size);
+}
+
+/* Arrays are ordered element by element */
+static int _st_object_order_arrays(struct st_array_s *array1, struct st_array_s *array2)
+{
+    st_array_cursor_t cursor1, cursor2;
+    int order = 0;
+
+    for (st_array_cursor_init(&cursor1, array1, FALSE), st_array_cursor_init(&cursor2, array2, FALSE);
+         order == 0 && !st_array_cursor_at_end(&cursor1) && !st_array_cursor_at_end(&cursor2);
+         st_array_cursor_next(&cursor1), st_array_cursor_next(&cursor2))
+    {
+        order = st_object_order(st_array_cursor_get_object(&cursor1), st_array_cursor_get_object(&cursor2));
+    }
+    return (order != 0)?order:ST_OBJECT_ORDER(array1->size, array2->size);
+}
+
+/**
+ * Dicts have no order of their own, they are ordered by size and hash.  Two
+ * unequal dicts with the same hash are ordered by address, which is only
+ * stable while they live.
+ */
+static int _st_object_order_dicts(st_object_t *object1, st_object_t *object2)
+{
+    struct st_dict_s *dict1 = st_object_get_dict(object1), *dict2 = st_object_get_dict(object2);
+    int order = ST_OBJECT_ORDER(dict1->array->size, dict2->array->size);
+
+    if (order == 0) {
+        order = ST_OBJECT_ORDER(st_object_hash(object1), st_object_hash(object2));
+    }
+    if (order == 0 && !st_object_compare(object1, object2)) {
+        order = ST_OBJECT_ORDER((uintptr_t)dict1, (uintptr_t)dict2);
+    }
+    return order;
+}
+
+int st_object_order(st_object_t *object1, st_object_t *object2)
+{
+    st_object_type_t type;
+    int order;
+
+    if (object1 == object2 || object1 == NULL || object2 == NULL) {
+        return (object1 == object2)?0:((object1 == NULL)?-1:1);
+    }
+
+    type = st_object_get_type(object1);
+    order = ST_OBJECT_ORDER(_st_object_order_rank(type), _st_object_order_rank(st_object_get_type(object2)));
+    if (order != 0) {
+        return order;
+    }
+
+    switch(type) {
+        case ST_OBJECT_TYPE_BOOL:
+            return ST_OBJECT_ORDER(st_object_get_bool(object1) != 0, st_object_get_bool(object2) != 0);
+        case ST_OBJECT_TYPE_INT:
+        case ST_OBJECT_TYPE_LONG:
+        case ST_OBJECT_TYPE_FLOAT:
+            return _st_object_order_numbers(object1, object2);
+        case ST_OBJECT_TYPE_STR:
+        case ST_OBJECT_TYPE_BLOB:
+            return _st_object_order_bytes(_st_object_record(object1), _st_object_record(object2));
+        case ST_OBJECT_TYPE_TYPED_ARRAY:
+            return _st_object_order_typed_arrays(st_object_get_typed_array(object1),
+                                                 st_object_get_typed_array(object2));
+        case ST_OBJECT_TYPE_ARRAY:
+            return _st_object_order_arrays(st_object_get_array(object1), st_object_get_array(object2));
+        case ST_OBJECT_TYPE_DICT:
+            return _st_object_order_dicts(object1, object2);
         default:
+            return 0;
+    }
+}
+
+st_size_t st_object_lower_bound(st_object_t **objects, st_size_t count, st_object_t *key, st_object_order_t order)
+{
+    st_size_t low = 0, high = count, middle;
+
+    order = (order != NULL)?order:st_object_order;
+    while (low < high) {
+        middle = ST_SIZE(low + (high - low) / 2);
+        if (order(objects[middle], key) < 0) {
+            low = ST_SIZE(middle + 1);
+        }
+        else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/* Copies the bytes of the borrowed strings and blobs in the links of an array */
+static st_bool_t _st_object_materialize_links(st_malloc_t *malloc, struct st_array_s *array)
+{
+    st_array_cursor_t cursor;
+    st_object_t *key, *object;
+
+    ST_ARRAY_CURSOR_FOREACH(&cursor, array) {
+        key = st_array_cursor_get_key(&cursor);
+        object = st_array_cursor_get_object(&cursor);
+        if ((key != NULL && !st_object_materialize(malloc, key)) ||
+            (object != NULL && !st_object_materialize(malloc, object)))
+        {
             return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+st_bool_t st_object_materialize(st_malloc_t *malloc, st_object_t *this)
+{
+    st_object_string_t *record, *owned;
+
+    switch(st_object_get_type(this)) {
+        case ST_OBJECT_TYPE_STR:
+        case ST_OBJECT_TYPE_BLOB:
+            if (!st_object_is_borrowed(this)) {
+                return TRUE;
+            }
+
+            record = _st_object_record(this);
+            if (record->length > ST_SIZE_MAX - sizeof(st_object_string_t) - 1 ||
+                (owned = st_malloc_struct(malloc, ST_SIZE(sizeof(st_object_string_t) + record->length + 1))) == NULL)
+            {
+                return FALSE;
+            }
+
+            owned->data = (st_string_t)(owned + 1);
+            owned->length = record->length;
+            owned->hash = record->hash;
+            memcpy(owned->data, record->data, record->length);
+            owned->data[record->length] = '\0';
+            _st_object_set_record(this, owned);
+            return TRUE;
+        case ST_OBJECT_TYPE_ARRAY:
+            return _st_object_materialize_links(malloc, st_object_get_array(this));
+        case ST_OBJECT_TYPE_DICT:
+            return _st_object_materialize_links(malloc, st_object_get_dict(this)->array);
+        default:
+            return TRUE;
+    }
+}
+
+void st_object_free(st_malloc_t *malloc, st_object_t *this)
+{
+#if ST_OBJECT_NAN_BOX
+    if (ST_NAN_BOX_IS(this->bits, ST_OBJECT_TYPE_LONG)) {
+        st_malloc_recycle(malloc, ST_NAN_BOX_POINTER(this->bits), sizeof(st_long_t));
     }
+#endif
+    st_malloc_recycle(malloc, this, sizeof(st_object_t));
 }
@@ -38,34 +38,211 @@ typedef enum
     ST_OBJECT_TYPE_INT,
     ST_OBJECT_TYPE_LONG,
     ST_OBJECT_TYPE_BOOL,
-    ST_OBJECT_TYPE_FLOAT
+    ST_OBJECT_TYPE_FLOAT,
+    ST_OBJECT_TYPE_BLOB,
+    ST_OBJECT_TYPE_TYPED_ARRAY
 } st_object_type_t;
 
+/**
+ * A string or blob object references this record.  The length and the hash
+ * are cached so that comparisons can reject without touching the bytes.
+ * Owned bytes follow the record and are NUL terminated, borrowed bytes live
+ * in an external buffer.
+ */
+typedef struct st_object_string_s
+{
+    st_string_t data;
+    st_size_t length;
+    uint32_t hash;
+} st_object_string_t;
+
+#if ST_OBJECT_NAN_BOX
+
+#if UINTPTR_MAX != UINT64_MAX
+#error "ST_OBJECT_NAN_BOX requires 64-bit pointers"
+#endif
+
+/**
+ * A double, or a quiet NaN whose top 16 bits tag the type and whose lower 48
+ * bits hold an int, a bool or a pointer (see st_object.c)
+ */
+typedef struct st_object_s
+{
+    uint64_t bits;
+} st_object_t;
+
+#else
+
+/**
+ * Scalars are stored inline, only strings and containers are referenced
+ */
+typedef union st_object_value_u
+{
+    void *pointer;
+    st_bool_t boolean;
+    st_int_t integer;
+    st_long_t long_integer;
+    st_float_t real;
+} st_object_value_t;
+
 typedef struct st_object_s
 {
     st_object_type_t type;
-    void *value;
+    st_object_value_t value;
 } st_object_t;
 
+#endif
+
+/**
+ * Creates an object.  For a scalar type "value" points to the scalar, which is
+ * copied into the object, otherwise it is the string record (see
+ * "st_object_new_string_n") or the container itself.
+ * With ST_OBJECT_NAN_BOX a long is copied into its own allocation by
+ * "st_object_new" but kept by reference by "st_object_set".
+ * @param malloc Pointer to the st_malloc instance
+ * @param type The type of the object
+ * @param value Pointer to the value
+ * @return Pointer to the object (or NULL)
+ */
 st_object_t *st_object_new(st_malloc_t *malloc, st_object_type_t type, void *value);
 void st_object_set(st_object_t *this, st_object_type_t type, void *value);
 
+st_object_type_t st_object_get_type(st_object_t *this);
+
 st_object_t *st_object_new_bool(st_malloc_t *malloc, st_bool_t value);
 st_object_t *st_object_new_int(st_malloc_t *malloc, st_int_t value);
 st_object_t *st_object_new_long(st_malloc_t *malloc, st_long_t value);
 st_object_t *st_object_new_float(st_malloc_t *malloc, st_float_t value);
 st_object_t *st_object_new_string(st_malloc_t *malloc, st_string_t value);
+
+/**
+ * Creates a string object from bytes that do not need to be NUL terminated
+ * @param malloc Pointer to the st_malloc instance
+ * @param value Pointer to the bytes
+ * @param length The number of bytes
+ * @return Pointer to the object (or NULL)
+ */
+st_object_t *st_object_new_string_n(st_malloc_t *malloc, const char *value, st_size_t length);
+
+/**
+ * Creates a string object that borrows bytes from an external buffer (e.g. a
+ * packet in an RX buffer) without copying them.  "st_object_get_string" then
+ * returns the borrowed pointer, which is not NUL terminated, and the buffer
+ * must outlive the object or be copied with "st_object_materialize".
+ * @param malloc Pointer to the st_malloc instance
+ * @param value Pointer to the bytes
+ * @param length The number of bytes
+ * @return Pointer to the object (or NULL)
+ */
+st_object_t *st_object_new_string_ref(st_malloc_t *malloc, const char *value, st_size_t length);
+
+/* Binary blobs, "st_object_new_blob" copies the bytes and "_ref" borrows them */
+st_object_t *st_object_new_blob(st_malloc_t *malloc, const void *value, st_size_t length);
+st_object_t *st_object_new_blob_ref(st_malloc_t *malloc, const void *value, st_size_t length);
 st_object_t *st_object_new_array(st_malloc_t *malloc, struct st_array_s *value);
 st_object_t *st_object_new_dict(st_malloc_t *malloc, struct st_dict_s *value);
+st_object_t *st_object_new_typed_array(st_malloc_t *malloc, struct st_typed_array_s *value);
 
 st_bool_t st_object_get_bool(st_object_t *this);
 st_int_t st_object_get_int(st_object_t *this);
 st_long_t st_object_get_long(st_object_t *this);
 st_float_t st_object_get_float(st_object_t *this);
 st_string_t st_object_get_string(st_object_t *this);
+st_size_t st_object_get_string_length(st_object_t *this);
+uint32_t st_object_get_string_hash(st_object_t *this);
+const st_byte_t *st_object_get_blob(st_object_t *this);
+st_size_t st_object_get_blob_length(st_object_t *this);
+
+/* Returns "TRUE" if the object is a string or blob borrowing an external buffer */
+st_bool_t st_object_is_borrowed(st_object_t *this);
+
+/**
+ * Copies the bytes of a borrowed string or blob into "malloc" so that the
+ * external buffer can be released.  Arrays and dicts are materialized with
+ * all of their keys and values.  The objects themselves are not moved.
+ * @param malloc Pointer to the st_malloc instance
+ * @param this Pointer to the object
+ * @return "TRUE" if nothing is borrowed any more, "FALSE" if a copy did not fit
+ */
+st_bool_t st_object_materialize(st_malloc_t *malloc, st_object_t *this);
 struct st_array_s *st_object_get_array(st_object_t *this);
 struct st_dict_s *st_object_get_dict(st_object_t *this);
+struct st_typed_array_s *st_object_get_typed_array(st_object_t *this);
 
+/**
+ * Compares two objects by value.  Arrays are equal if their elements are equal
+ * in order, dicts if they hold equal keys with equal values in any order and
+ * typed arrays if their elements are bitwise equal.  The same container is
+ * always equal to itself and frozen containers reject on their cached hashes.
+ * @param object1 Pointer to the first object
+ * @param object2 Pointer to the second object
+ * @return "TRUE" if the objects are equal
+ */
 st_bool_t st_object_compare(st_object_t *object1, st_object_t *object2);
 
+/**
+ * Orders two objects, e.g. to sort them.  It is a total order across all of
+ * the types: NULL < bools < numbers < strings < blobs < typed arrays < arrays
+ * < dicts.  Ints, longs and floats are ordered by value (NaN last) and equal
+ * values by type, strings and blobs byte by byte, arrays and typed arrays
+ * element by element (float elements that are equal by value but not bit for
+ * bit, such as 0.0 and -0.0, by their bits) and dicts by size and hash.  It
+ * returns 0 exactly when "st_object_compare" returns "TRUE", except for a NaN
+ * float object which is ordered equal to itself.
+ * @param object1 Pointer to the first object (can be NULL)
+ * @param object2 Pointer to the second object (can be NULL)
+ * @return A negative value, 0 or a positive value if "object1" orders before,
+ *         equal to or after "object2"
+ */
+int st_object_order(st_object_t *object1, st_object_t *object2);
+
+typedef int (*st_object_order_t)(st_object_t *object1, st_object_t *object2);
+
+/**
+ * Binary search in a sorted array of object pointers (e.g. collected from an
+ * st_array or dict once so that later lookups are O(log n))
+ * @param objects Pointer to the objects, sorted by "order"
+ * @param count The number of objects
+ * @param key Pointer to the object to look for
+ * @param order The order the objects are sorted by (NULL for "st_object_order")
+ * @return Index of the first object that does not order before "key" ("count" if there is none)
+ */
+st_size_t st_object_lower_bound(st_object_t **objects, st_size_t count, st_object_t *key, st_object_order_t order);
+
+/**
+ * Returns the structural hash of an object.  Equal objects have equal hashes
+ * and the hash does not depend on addresses, so it is the same across heaps,
+ * clones and runs.  The hash of a dict does not depend on the order of its
+ * entries.  Unless they are frozen, containers are hashed with all of their
+ * elements on every call.  A typed array inside a container only adds its
+ * element type to the container's hash, as it can still be modified once the
+ * container is frozen.
+ * @param this Pointer to the object
+ * @return The hash
+ */
+uint32_t st_object_hash(st_object_t *this);
+
+/**
+ * Freezes an array or dict and every array and dict it holds.  Their hashes
+ * are computed once and cached, and they refuse to be modified afterwards
+ * (the st_array and st_dict methods that would modify them return "FALSE").
+ * Scalars, strings and blobs are already immutable, typed arrays are not
+ * frozen and are left out of the cached hash.
+ * @param this Pointer to the object (ignored if it is not an array or dict)
+ */
+void st_object_set_frozen(st_object_t *this);
+st_bool_t st_object_is_frozen(st_object_t *this);
+
+/* The hash cached by string objects (32-bit FNV-1a) */
+uint32_t st_object_hash_string(const char *value, st_size_t length);
+
+/**
+ * Hands an object created with "st_object_new" (and the boxed long of an
+ * ST_OBJECT_NAN_BOX long) back to the free lists of "malloc".  The value of
+ * a string, array or dict object is not freed.
+ * @param malloc Pointer to the st_malloc instance the object was allocated from
+ * @param this Pointer to the object (must no longer be referenced)
+ */
+void st_object_free(st_malloc_t *malloc, st_object_t *this);
+
 #endif // __ST_OBJECTS_ST_OBJECT_H__
@@ -0,0 +1,1241 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stdatomic.h>
+#include <string.h>
+#include "st_typed_array.h"
+
+#if ST_TYPED_ARRAY_SIMD
+#include <immintrin.h>
+#define ST_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#define ST_TYPED_ARRAY_MIN_CAPACITY 8
+
+static const st_size_t _st_typed_array_element_sizes[] = {
+    sizeof(int32_t), sizeof(int64_t), sizeof(double), sizeof(uint8_t)
+};
+
+/* The kernels that exist for more than one instruction set */
+typedef struct st_typed_array_kernels_s
+{
+    st_typed_array_isa_t isa;
+    st_float_t (*sum_f64)(const double *values, st_size_t count);
+    st_long_t (*sum_i32)(const int32_t *values, st_size_t count);
+    st_long_t (*sum_u8)(const uint8_t *values, st_size_t count);
+    st_long_t (*sum_i64)(const int64_t *values, st_size_t count);
+    double (*min_f64)(const double *values, st_size_t count);
+    double (*max_f64)(const double *values, st_size_t count);
+    int32_t (*min_i32)(const int32_t *values, st_size_t count);
+    int32_t (*max_i32)(const int32_t *values, st_size_t count);
+    int64_t (*min_i64)(const int64_t *values, st_size_t count);
+    int64_t (*max_i64)(const int64_t *values, st_size_t count);
+    uint8_t (*min_u8)(const uint8_t *values, st_size_t count);
+    uint8_t (*max_u8)(const uint8_t *values, st_size_t count);
+    st_float_t (*dot_f64)(const double *values1, const double *values2, st_size_t count);
+    st_float_t (*dot_i32)(const int32_t *values1, const int32_t *values2, st_size_t count);
+    st_float_t (*dot_u8)(const uint8_t *values1, const uint8_t *values2, st_size_t count);
+    void (*scale_f64)(double *values, st_size_t count, double factor);
+    void (*scale_i32)(int32_t *values, st_size_t count, double factor);
+} st_typed_array_kernels_t;
+
+/* Scalar kernels, the min and max kernels expect at least one element */
+
+static st_float_t _st_sum_f64_scalar(const double *values, st_size_t count)
+{
+    st_float_t sum = 0;
+    st_size_t i;
+
+    for (i=0; i<count; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+static st_long_t _st_sum_i32_scalar(const int32_t *values, st_size_t count)
+{
+    st_long_t sum = 0;
+    st_size_t i;
+
+    for (i=0; i<count; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+static st_long_t _st_sum_u8_scalar(const uint8_t *values, st_size_t count)
+{
+    st_long_t sum = 0;
+    st_size_t i;
+
+    for (i=0; i<count; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+/* The 64-bit sums wrap around (like the SIMD kernels) instead of overflowing a signed integer */
+static st_long_t _st_sum_i64_scalar(const int64_t *values, st_size_t count)
+{
+    uint64_t sum = 0;
+    st_size_t i;
+
+    for (i=0; i<count; i++) {
+        sum += (uint64_t)values[i];
+    }
+    return (st_long_t)sum;
+}
+
+static double _st_min_f64_scalar(const double *values, st_size_t count)
+{
+    double min = values[0];
+    st_size_t i;
+
+    for (i=1; i<count; i++) {
+        min = (values[i] < min)?values[i]:min;
+    }
+    return min;
+}
+
+static double _st_max_f64_scalar(const double *values, st_size_t count)
+{
+    double max = values[0];
+    st_size_t i;
+
+    for (i=1; i<count; i++) {
+        max = (values[i] > max)?values[i]:max;
+    }
+    return max;
+}
+
+static int32_t _st_min_i32_scalar(const int32_t *values, st_size_t count)
+{
+    int32_t min = values[0];
+    st_size_t i;
+
+    for (i=1; i<count; i++) {
+        min = (values[i] < min)?values[i]:min;
+    }
+    return min;
+}
+
+static int32_t _st_max_i32_scalar(const int32_t *values, st_size_t count)
+{
+    int32_t max = values[0];
+    st_size_t i;
+
+    for (i=1; i<count; i++) {
+        max = (values[i] > max)?values[i]:max;
+    }
+    return max;
+}
+
+static int64_t _st_min_i64_scalar(const int64_t *values, st_size_t count)
+{
+    int64_t min = values[0];
+    st_size_t i;
+
+    for (i=1; i<count; i++) {
+        min = (values[i] < min)?values[i]:min;
+    }
+    return min;
+}
+
+static int64_t _st_max_i64_scalar(const int64_t *values, st_size_t count)
+{
+    int64_t max = values[0];
+    st_size_t i;
+
+    for (i=1; i<count; i++) {
+        max = (values[i] > max)?values[i]:max;
+    }
+    return max;
+}
+
+static uint8_t _st_min_u8_scalar(const uint8_t *values, st_size_t count)
+{
+    uint8_t min = values[0];
+    st_size_t i;
+
+    for (i=1; i<count; i++) {
+        min = (values[i] < min)?values[i]:min;
+    }
+    return min;
+}
+
+static uint8_t _st_max_u8_scalar(const uint8_t *values, st_size_t count)
+{
+    uint8_t max = values[0];
+    st_size_t i;
+
+    for (i=1; i<count; i++) {
+        max = (values[i] > max)?values[i]:max;
+    }
+    return max;
+}
+
+static st_float_t _st_dot_f64_scalar(const double *values1, const double *values2, st_size_t count)
+{
+    st_float_t sum = 0;
+    st_size_t i;
+
+    for (i=0; i<count; i++) {
+        sum += values1[i] * values2[i];
+    }
+    return sum;
+}
+
+static st_float_t _st_dot_i32_scalar(const int32_t *values1, const int32_t *values2, st_size_t count)
+{
+    st_float_t sum = 0;
+    st_size_t i;
+
+    for (i=0; i<count; i++) {
+        sum += (double)values1[i] * (double)values2[i];
+    }
+    return sum;
+}
+
+static st_float_t _st_dot_u8_scalar(const uint8_t *values1, const uint8_t *values2, st_size_t count)
+{
+    uint64_t sum = 0;
+    st_size_t i;
+
+    for (i=0; i<count; i++) {
+        sum += (uint32_t)values1[i] * values2[i];
+    }
+    return (st_float_t)sum;
+}
+
+static void _st_scale_f64_scalar(double *values, st_size_t count, double factor)
+{
+    st_size_t i;
+
+    for (i=0; i<count; i++) {
+        values[i] *= factor;
+    }
+}
+
+static void _st_scale_i32_scalar(int32_t *values, st_size_t count, double factor)
+{
+    st_size_t i;
+
+    for (i=0; i<count; i++) {
+        values[i] = (int32_t)(values[i] * factor);
+    }
+}
+
+static const st_typed_array_kernels_t _st_kernels_scalar = {
+    ST_TYPED_ARRAY_ISA_SCALAR,
+    _st_sum_f64_scalar, _st_sum_i32_scalar, _st_sum_u8_scalar, _st_sum_i64_scalar,
+    _st_min_f64_scalar, _st_max_f64_scalar, _st_min_i32_scalar, _st_max_i32_scalar,
+    _st_min_i64_scalar, _st_max_i64_scalar, _st_min_u8_scalar, _st_max_u8_scalar,
+    _st_dot_f64_scalar, _st_dot_i32_scalar, _st_dot_u8_scalar, _st_scale_f64_scalar, _st_scale_i32_scalar
+};
+
+#if ST_TYPED_ARRAY_SIMD
+
+/* SSE2 kernels, 2 doubles or 4 ints per register */
+
+ST_TARGET("sse2") static st_float_t _st_sum_f64_sse2(const double *values, st_size_t count)
+{
+    __m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+    double lanes[2], sum;
+    st_size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        sum0 = _mm_add_pd(sum0, _mm_loadu_pd(values + i));
+        sum1 = _mm_add_pd(sum1, _mm_loadu_pd(values + i + 2));
+    }
+    _mm_storeu_pd(lanes, _mm_add_pd(sum0, sum1));
+
+    for (sum = lanes[0] + lanes[1]; i < count; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+ST_TARGET("sse2") static st_long_t _st_sum_i32_sse2(const int32_t *values, st_size_t count)
+{
+    __m128i sum = _mm_setzero_si128(), value, sign;
+    int64_t lanes[2];
+    st_long_t total;
+    st_size_t i = 0;
+
+    // Sign extend to 64 bits so that the sum can not overflow
+    for (; i + 4 <= count; i += 4) {
+        value = _mm_loadu_si128((const __m128i *)(values + i));
+        sign = _mm_srai_epi32(value, 31);
+        sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(value, sign));
+        sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(value, sign));
+    }
+    _mm_storeu_si128((__m128i *)lanes, sum);
+
+    for (total = lanes[0] + lanes[1]; i < count; i++) {
+        total += values[i];
+    }
+    return total;
+}
+
+ST_TARGET("sse2") static st_long_t _st_sum_u8_sse2(const uint8_t *values, st_size_t count)
+{
+    __m128i sum = _mm_setzero_si128(), zero = _mm_setzero_si128();
+    int64_t lanes[2];
+    st_long_t total;
+    st_size_t i = 0;
+
+    // The sum of absolute differences against zero adds 8 bytes into each 64-bit lane
+    for (; i + 16 <= count; i += 16) {
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_loadu_si128((const __m128i *)(values + i)), zero));
+    }
+    _mm_storeu_si128((__m128i *)lanes, sum);
+
+    for (total = lanes[0] + lanes[1]; i < count; i++) {
+        total += values[i];
+    }
+    return total;
+}
+
+ST_TARGET("sse2") static st_long_t _st_sum_i64_sse2(const int64_t *values, st_size_t count)
+{
+    __m128i sum0 = _mm_setzero_si128(), sum1 = _mm_setzero_si128();
+    uint64_t lanes[2], total;
+    st_size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        sum0 = _mm_add_epi64(sum0, _mm_loadu_si128((const __m128i *)(values + i)));
+        sum1 = _mm_add_epi64(sum1, _mm_loadu_si128((const __m128i *)(values + i + 2)));
+    }
+    _mm_storeu_si128((__m128i *)lanes, _mm_add_epi64(sum0, sum1));
+
+    for (total = lanes[0] + lanes[1]; i < count; i++) {
+        total += (uint64_t)values[i];
+    }
+    return (st_long_t)total;
+}
+
+ST_TARGET("sse2") static double _st_min_f64_sse2(const double *values, st_size_t count)
+{
+    __m128d min = _mm_set1_pd(values[0]);
+    double lanes[2], result;
+    st_size_t i = 0;
+
+    for (; i + 2 <= count; i += 2) {
+        min = _mm_min_pd(min, _mm_loadu_pd(values + i));
+    }
+    _mm_storeu_pd(lanes, min);
+
+    for (result = (lanes[0] < lanes[1])?lanes[0]:lanes[1]; i < count; i++) {
+        result = (values[i] < result)?values[i]:result;
+    }
+    return result;
+}
+
+ST_TARGET("sse2") static double _st_max_f64_sse2(const double *values, st_size_t count)
+{
+    __m128d max = _mm_set1_pd(values[0]);
+    double lanes[2], result;
+    st_size_t i = 0;
+
+    for (; i + 2 <= count; i += 2) {
+        max = _mm_max_pd(max, _mm_loadu_pd(values + i));
+    }
+    _mm_storeu_pd(lanes, max);
+
+    for (result = (lanes[0] > lanes[1])?lanes[0]:lanes[1]; i < count; i++) {
+        result = (values[i] > result)?values[i]:result;
+    }
+    return result;
+}
+
+/* SSE2 has no pminsd/pmaxsd, the lanes are selected with a compare mask */
+ST_TARGET("sse2") static int32_t _st_min_i32_sse2(const int32_t *values, st_size_t count)
+{
+    __m128i min = _mm_set1_epi32(values[0]), value, mask;
+    int32_t lanes[4];
+    st_size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        value = _mm_loadu_si128((const __m128i *)(values + i));
+        mask = _mm_cmplt_epi32(value, min);
+        min = _mm_or_si128(_mm_and_si128(mask, value), _mm_andnot_si128(mask, min));
+    }
+    _mm_storeu_si128((__m128i *)lanes, min);
+    lanes[0] = _st_min_i32_scalar(lanes, 4);
+
+    for (; i < count; i++) {
+        lanes[0] = (values[i] < lanes[0])?values[i]:lanes[0];
+    }
+    return lanes[0];
+}
+
+ST_TARGET("sse2") static int32_t _st_max_i32_sse2(const int32_t *values, st_size_t count)
+{
+    __m128i max = _mm_set1_epi32(values[0]), value, mask;
+    int32_t lanes[4];
+    st_size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        value = _mm_loadu_si128((const __m128i *)(values + i));
+        mask = _mm_cmpgt_epi32(value, max);
+        max = _mm_or_si128(_mm_and_si128(mask, value), _mm_andnot_si128(mask, max));
+    }
+    _mm_storeu_si128((__m128i *)lanes, max);
+    lanes[0] = _st_max_i32_scalar(lanes, 4);
+
+    for (; i < count; i++) {
+        lanes[0] = (values[i] > lanes[0])?values[i]:lanes[0];
+    }
+    return lanes[0];
+}
+
+ST_TARGET("sse2") static uint8_t _st_min_u8_sse2(const uint8_t *values, st_size_t count)
+{
+    __m128i min = _mm_set1_epi8((char)values[0]);
+    uint8_t lanes[16];
+    st_size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        min = _mm_min_epu8(min, _mm_loadu_si128((const __m128i *)(values + i)));
+    }
+    _mm_storeu_si128((__m128i *)lanes, min);
+    lanes[0] = _st_min_u8_scalar(lanes, 16);
+
+    for (; i < count; i++) {
+        lanes[0] = (values[i] < lanes[0])?values[i]:lanes[0];
+    }
+    return lanes[0];
+}
+
+ST_TARGET("sse2") static uint8_t _st_max_u8_sse2(const uint8_t *values, st_size_t count)
+{
+    __m128i max = _mm_set1_epi8((char)values[0]);
+    uint8_t lanes[16];
+    st_size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        max = _mm_max_epu8(max, _mm_loadu_si128((const __m128i *)(values + i)));
+    }
+    _mm_storeu_si128((__m128i *)lanes, max);
+    lanes[0] = _st_max_u8_scalar(lanes, 16);
+
+    for (; i < count; i++) {
+        lanes[0] = (values[i] > lanes[0])?values[i]:lanes[0];
+    }
+    return lanes[0];
+}
+
+ST_TARGET("sse2") static st_float_t _st_dot_f64_sse2(const double *values1, const double *values2, st_size_t count)
+{
+    __m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+    double lanes[2], sum;
+    st_size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        sum0 = _mm_add_pd(sum0, _mm_mul_pd(_mm_loadu_pd(values1 + i), _mm_loadu_pd(values2 + i)));
+        sum1 = _mm_add_pd(sum1, _mm_mul_pd(_mm_loadu_pd(values1 + i + 2), _mm_loadu_pd(values2 + i + 2)));
+    }
+    _mm_storeu_pd(lanes, _mm_add_pd(sum0, sum1));
+
+    for (sum = lanes[0] + lanes[1]; i < count; i++) {
+        sum += values1[i] * values2[i];
+    }
+    return sum;
+}
+
+ST_TARGET("sse2") static st_float_t _st_dot_i32_sse2(const int32_t *values1, const int32_t *values2, st_size_t count)
+{
+    __m128d sum = _mm_setzero_pd();
+    __m128i value1, value2;
+    double lanes[2], total;
+    st_size_t i = 0;
+
+    // Each half of the registers is converted to two doubles
+    for (; i + 4 <= count; i += 4) {
+        value1 = _mm_loadu_si128((const __m128i *)(values1 + i));
+        value2 = _mm_loadu_si128((const __m128i *)(values2 + i));
+        sum = _mm_add_pd(sum, _mm_mul_pd(_mm_cvtepi32_pd(value1), _mm_cvtepi32_pd(value2)));
+        sum = _mm_add_pd(sum, _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(value1, value1)),
+                                         _mm_cvtepi32_pd(_mm_unpackhi_epi64(value2, value2))));
+    }
+    _mm_storeu_pd(lanes, sum);
+
+    for (total = lanes[0] + lanes[1]; i < count; i++) {
+        total += (double)values1[i] * (double)values2[i];
+    }
+    return total;
+}
+
+ST_TARGET("sse2") static st_float_t _st_dot_u8_sse2(const uint8_t *values1, const uint8_t *values2, st_size_t count)
+{
+    __m128i sum = _mm_setzero_si128(), zero = _mm_setzero_si128(), value1, value2, products;
+    uint64_t lanes[2], total;
+    st_size_t i = 0;
+
+    // The bytes are widened to 16 bits and pmaddwd adds pairs of products, four of them fit a 32-bit lane
+    for (; i + 16 <= count; i += 16) {
+        value1 = _mm_loadu_si128((const __m128i *)(values1 + i));
+        value2 = _mm_loadu_si128((const __m128i *)(values2 + i));
+        products = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(value1, zero), _mm_unpacklo_epi8(value2, zero)),
+                                 _mm_madd_epi16(_mm_unpackhi_epi8(value1, zero), _mm_unpackhi_epi8(value2, zero)));
+        sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(products, zero));
+        sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(products, zero));
+    }
+    _mm_storeu_si128((__m128i *)lanes, sum);
+
+    for (total = lanes[0] + lanes[1]; i < count; i++) {
+        total += (uint32_t)values1[i] * values2[i];
+    }
+    return (st_float_t)total;
+}
+
+ST_TARGET("sse2") static void _st_scale_f64_sse2(double *values, st_size_t count, double factor)
+{
+    __m128d scale = _mm_set1_pd(factor);
+    st_size_t i = 0;
+
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(values + i, _mm_mul_pd(_mm_loadu_pd(values + i), scale));
+    }
+    _st_scale_f64_scalar(values + i, ST_SIZE(count - i), factor);
+}
+
+ST_TARGET("sse2") static void _st_scale_i32_sse2(int32_t *values, st_size_t count, double factor)
+{
+    __m128d scale = _mm_set1_pd(factor);
+    __m128i value;
+    st_size_t i = 0;
+
+    for (; i + 2 <= count; i += 2) {
+        value = _mm_loadl_epi64((const __m128i *)(values + i));
+        _mm_storel_epi64((__m128i *)(values + i), _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtepi32_pd(value), scale)));
+    }
+    _st_scale_i32_scalar(values + i, ST_SIZE(count - i), factor);
+}
+
+/* SSE2 has no 64-bit compare (pcmpgtq is SSE4.2), the int64 min and max stay scalar */
+static const st_typed_array_kernels_t _st_kernels_sse2 = {
+    ST_TYPED_ARRAY_ISA_SSE2,
+    _st_sum_f64_sse2, _st_sum_i32_sse2, _st_sum_u8_sse2, _st_sum_i64_sse2,
+    _st_min_f64_sse2, _st_max_f64_sse2, _st_min_i32_sse2, _st_max_i32_sse2,
+    _st_min_i64_scalar, _st_max_i64_scalar, _st_min_u8_sse2, _st_max_u8_sse2,
+    _st_dot_f64_sse2, _st_dot_i32_sse2, _st_dot_u8_sse2, _st_scale_f64_sse2, _st_scale_i32_sse2
+};
+
+/* AVX2 kernels, 4 doubles or 8 ints per register */
+
+ST_TARGET("avx2") static double _st_avx_add_lanes(__m256d value)
+{
+    double lanes[2];
+
+    _mm_storeu_pd(lanes, _mm_add_pd(_mm256_castpd256_pd128(value), _mm256_extractf128_pd(value, 1)));
+    return lanes[0] + lanes[1];
+}
+
+ST_TARGET("avx2") static st_float_t _st_sum_f64_avx2(const double *values, st_size_t count)
+{
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+    double sum;
+    st_size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        sum0 = _mm256_add_pd(sum0, _mm256_loadu_pd(values + i));
+        sum1 = _mm256_add_pd(sum1, _mm256_loadu_pd(values + i + 4));
+    }
+
+    for (sum = _st_avx_add_lanes(_mm256_add_pd(sum0, sum1)); i < count; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+ST_TARGET("avx2") static st_long_t _st_sum_i32_avx2(const int32_t *values, st_size_t count)
+{
+    __m256i sum = _mm256_setzero_si256(), value;
+    int64_t lanes[4];
+    st_long_t total;
+    st_size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        value = _mm256_loadu_si256((const __m256i *)(values + i));
+        sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(value)));
+        sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(value, 1)));
+    }
+    _mm256_storeu_si256((__m256i *)lanes, sum);
+
+    for (total = lanes[0] + lanes[1] + lanes[2] + lanes[3]; i < count; i++) {
+        total += values[i];
+    }
+    return total;
+}
+
+ST_TARGET("avx2") static st_long_t _st_sum_u8_avx2(const uint8_t *values, st_size_t count)
+{
+    __m256i sum = _mm256_setzero_si256(), zero = _mm256_setzero_si256();
+    int64_t lanes[4];
+    st_long_t total;
+    st_size_t i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(_mm256_loadu_si256((const __m256i *)(values + i)), zero));
+    }
+    _mm256_storeu_si256((__m256i *)lanes, sum);
+
+    for (total = lanes[0] + lanes[1] + lanes[2] + lanes[3]; i < count; i++) {
+        total += values[i];
+    }
+    return total;
+}
+
+ST_TARGET("avx2") static st_long_t _st_sum_i64_avx2(const int64_t *values, st_size_t count)
+{
+    __m256i sum0 = _mm256_setzero_si256(), sum1 = _mm256_setzero_si256();
+    uint64_t lanes[4], total;
+    st_size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        sum0 = _mm256_add_epi64(sum0, _mm256_loadu_si256((const __m256i *)(values + i)));
+        sum1 = _mm256_add_epi64(sum1, _mm256_loadu_si256((const __m256i *)(values + i + 4)));
+    }
+    _mm256_storeu_si256((__m256i *)lanes, _mm256_add_epi64(sum0, sum1));
+
+    for (total = lanes[0] + lanes[1] + lanes[2] + lanes[3]; i < count; i++) {
+        total += (uint64_t)values[i];
+    }
+    return (st_long_t)total;
+}
+
+ST_TARGET("avx2") static double _st_min_f64_avx2(const double *values, st_size_t count)
+{
+    __m256d min = _mm256_set1_pd(values[0]);
+    double lanes[4], result;
+    st_size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        min = _mm256_min_pd(min, _mm256_loadu_pd(values + i));
+    }
+    _mm256_storeu_pd(lanes, min);
+
+    for (result = _st_min_f64_scalar(lanes, 4); i < count; i++) {
+        result = (values[i] < result)?values[i]:result;
+    }
+    return result;
+}
+
+ST_TARGET("avx2") static double _st_max_f64_avx2(const double *values, st_size_t count)
+{
+    __m256d max = _mm256_set1_pd(values[0]);
+    double lanes[4], result;
+    st_size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        max = _mm256_max_pd(max, _mm256_loadu_pd(values + i));
+    }
+    _mm256_storeu_pd(lanes, max);
+
+    for (result = _st_max_f64_scalar(lanes, 4); i < count; i++) {
+        result = (values[i] > result)?values[i]:result;
+    }
+    return result;
+}
+
+ST_TARGET("avx2") static int32_t _st_min_i32_avx2(const int32_t *values, st_size_t count)
+{
+    __m256i min = _mm256_set1_epi32(values[0]);
+    int32_t lanes[8], result;
+    st_size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        min = _mm256_min_epi32(min, _mm256_loadu_si256((const __m256i *)(values + i)));
+    }
+    _mm256_storeu_si256((__m256i *)lanes, min);
+
+    for (result = _st_min_i32_scalar(lanes, 8); i < count; i++) {
+        result = (values[i] < result)?values[i]:result;
+    }
+    return result;
+}
+
+ST_TARGET("avx2") static int32_t _st_max_i32_avx2(const int32_t *values, st_size_t count)
+{
+    __m256i max = _mm256_set1_epi32(values[0]);
+    int32_t lanes[8], result;
+    st_size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        max = _mm256_max_epi32(max, _mm256_loadu_si256((const __m256i *)(values + i)));
+    }
+    _mm256_storeu_si256((__m256i *)lanes, max);
+
+    for (result = _st_max_i32_scalar(lanes, 8); i < count; i++) {
+        result = (values[i] > result)?values[i]:result;
+    }
+    return result;
+}
+
+/* AVX2 has no pminsq/pmaxsq, the lanes are selected with a compare mask */
+ST_TARGET("avx2") static int64_t _st_min_i64_avx2(const int64_t *values, st_size_t count)
+{
+    __m256i min = _mm256_set1_epi64x(values[0]), value;
+    int64_t lanes[4], result;
+    st_size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        value = _mm256_loadu_si256((const __m256i *)(values + i));
+        min = _mm256_blendv_epi8(min, value, _mm256_cmpgt_epi64(min, value));
+    }
+    _mm256_storeu_si256((__m256i *)lanes, min);
+
+    for (result = _st_min_i64_scalar(lanes, 4); i < count; i++) {
+        result = (values[i] < result)?values[i]:result;
+    }
+    return result;
+}
+
+ST_TARGET("avx2") static int64_t _st_max_i64_avx2(const int64_t *values, st_size_t count)
+{
+    __m256i max = _mm256_set1_epi64x(values[0]), value;
+    int64_t lanes[4], result;
+    st_size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        value = _mm256_loadu_si256((const __m256i *)(values + i));
+        max = _mm256_blendv_epi8(max, value, _mm256_cmpgt_epi64(value, max));
+    }
+    _mm256_storeu_si256((__m256i *)lanes, max);
+
+    for (result = _st_max_i64_scalar(lanes, 4); i < count; i++) {
+        result = (values[i] > result)?values[i]:result;
+    }
+    return result;
+}
+
+ST_TARGET("avx2") static uint8_t _st_min_u8_avx2(const uint8_t *values, st_size_t count)
+{
+    __m256i min = _mm256_set1_epi8((char)values[0]);
+    uint8_t lanes[32], result;
+    st_size_t i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        min = _mm256_min_epu8(min, _mm256_loadu_si256((const __m256i *)(values + i)));
+    }
+    _mm256_storeu_si256((__m256i *)lanes, min);
+
+    for (result = _st_min_u8_scalar(lanes, 32); i < count; i++) {
+        result = (values[i] < result)?values[i]:result;
+    }
+    return result;
+}
+
+ST_TARGET("avx2") static uint8_t _st_max_u8_avx2(const uint8_t *values, st_size_t count)
+{
+    __m256i max = _mm256_set1_epi8((char)values[0]);
+    uint8_t lanes[32], result;
+    st_size_t i = 0;
+
+    for (; i + 32 <= count; i += 32) {
+        max = _mm256_max_epu8(max, _mm256_loadu_si256((const __m256i *)(values + i)));
+    }
+    _mm256_storeu_si256((__m256i *)lanes, max);
+
+    for (result = _st_max_u8_scalar(lanes, 32); i < count; i++) {
+        result = (values[i] > result)?values[i]:result;
+    }
+    return result;
+}
+
+ST_TARGET("avx2") static st_float_t _st_dot_f64_avx2(const double *values1, const double *values2, st_size_t count)
+{
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+    double sum;
+    st_size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        sum0 = _mm256_add_pd(sum0, _mm256_mul_pd(_mm256_loadu_pd(values1 + i), _mm256_loadu_pd(values2 + i)));
+        sum1 = _mm256_add_pd(sum1, _mm256_mul_pd(_mm256_loadu_pd(values1 + i + 4), _mm256_loadu_pd(values2 + i + 4)));
+    }
+
+    for (sum = _st_avx_add_lanes(_mm256_add_pd(sum0, sum1)); i < count; i++) {
+        sum += values1[i] * values2[i];
+    }
+    return sum;
+}
+
+ST_TARGET("avx2") static st_float_t _st_dot_i32_avx2(const int32_t *values1, const int32_t *values2, st_size_t count)
+{
+    __m256d sum = _mm256_setzero_pd();
+    double total;
+    st_size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        sum = _mm256_add_pd(sum, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *)(values1 + i))),
+                                               _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *)(values2 + i)))));
+    }
+
+    for (total = _st_avx_add_lanes(sum); i < count; i++) {
+        total += (double)values1[i] * (double)values2[i];
+    }
+    return total;
+}
+
+ST_TARGET("avx2") static st_float_t _st_dot_u8_avx2(const uint8_t *values1, const uint8_t *values2, st_size_t count)
+{
+    __m256i sum = _mm256_setzero_si256(), products;
+    uint64_t lanes[4], total;
+    st_size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        products = _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(values1 + i))),
+                                     _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(values2 + i))));
+        sum = _mm256_add_epi64(sum, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(products)));
+        sum = _mm256_add_epi64(sum, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(products, 1)));
+    }
+    _mm256_storeu_si256((__m256i *)lanes, sum);
+
+    for (total = lanes[0] + lanes[1] + lanes[2] + lanes[3]; i < count; i++) {
+        total += (uint32_t)values1[i] * values2[i];
+    }
+    return (st_float_t)total;
+}
+
+ST_TARGET("avx2") static void _st_scale_f64_avx2(double *values, st_size_t count, double factor)
+{
+    __m256d scale = _mm256_set1_pd(factor);
+    st_size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(values + i, _mm256_mul_pd(_mm256_loadu_pd(values + i), scale));
+    }
+    _st_scale_f64_scalar(values + i, ST_SIZE(count - i), factor);
+}
+
+ST_TARGET("avx2") static void _st_scale_i32_avx2(int32_t *values, st_size_t count, double factor)
+{
+    __m256d scale = _mm256_set1_pd(factor);
+    __m128i value;
+    st_size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        value = _mm_loadu_si128((const __m128i *)(values + i));
+        _mm_storeu_si128((__m128i *)(values + i), _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(value), scale)));
+    }
+    _st_scale_i32_scalar(values + i, ST_SIZE(count - i), factor);
+}
+
+static const st_typed_array_kernels_t _st_kernels_avx2 = {
+    ST_TYPED_ARRAY_ISA_AVX2,
+    _st_sum_f64_avx2, _st_sum_i32_avx2, _st_sum_u8_avx2, _st_sum_i64_avx2,
+    _st_min_f64_avx2, _st_max_f64_avx2, _st_min_i32_avx2, _st_max_i32_avx2,
+    _st_min_i64_avx2, _st_max_i64_avx2, _st_min_u8_avx2, _st_max_u8_avx2,
+    _st_dot_f64_avx2, _st_dot_i32_avx2, _st_dot_u8_avx2, _st_scale_f64_avx2, _st_scale_i32_avx2
+};
+
+#endif
+
+/* The kernels in use, shared by every thread (the table carries its instruction set) */
+static _Atomic(const st_typed_array_kernels_t *) _st_kernels = NULL;
+
+/* Returns the kernels of an instruction set, or NULL if the CPU does not support it */
+static const st_typed_array_kernels_t *_st_typed_array_isa_kernels(st_typed_array_isa_t isa)
+{
+    switch(isa) {
+        case ST_TYPED_ARRAY_ISA_SCALAR:
+            return &_st_kernels_scalar;
+#if ST_TYPED_ARRAY_SIMD
+        case ST_TYPED_ARRAY_ISA_SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2")?&_st_kernels_sse2:NULL;
+        case ST_TYPED_ARRAY_ISA_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2")?&_st_kernels_avx2:NULL;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+st_bool_t st_typed_array_use_isa(st_typed_array_isa_t isa)
+{
+    const st_typed_array_kernels_t *kernels = _st_typed_array_isa_kernels(isa);
+
+    if (kernels == NULL) {
+        return FALSE;
+    }
+    atomic_store_explicit(&_st_kernels, kernels, memory_order_release);
+    return TRUE;
+}
+
+/**
+ * Picks the best kernels on first use.  Threads that race here pick the same
+ * table and only the first one is stored, so a selection made meanwhile with
+ * "st_typed_array_use_isa" is not overwritten.
+ */
+static const st_typed_array_kernels_t *_st_typed_array_kernels(void)
+{
+    const st_typed_array_kernels_t *kernels = atomic_load_explicit(&_st_kernels, memory_order_acquire);
+    const st_typed_array_kernels_t *best;
+
+    if (kernels != NULL) {
+        return kernels;
+    }
+
+    if ((best = _st_typed_array_isa_kernels(ST_TYPED_ARRAY_ISA_AVX2)) == NULL &&
+        (best = _st_typed_array_isa_kernels(ST_TYPED_ARRAY_ISA_SSE2)) == NULL) {
+        best = &_st_kernels_scalar;
+    }
+    // On failure "kernels" receives the table another thread stored first
+    if (atomic_compare_exchange_strong_explicit(&_st_kernels, &kernels, best, memory_order_acq_rel,
+                                                memory_order_acquire)) {
+        kernels = best;
+    }
+    return kernels;
+}
+
+st_typed_array_isa_t st_typed_array_get_isa(void)
+{
+    return _st_typed_array_kernels()->isa;
+}
+
+/* Storage */
+
+st_typed_array_t *st_typed_array_new(st_malloc_t *malloc, st_typed_array_type_t type, st_size_t capacity)
+{
+    st_typed_array_t *array;
+
+    if ((unsigned)type >= sizeof(_st_typed_array_element_sizes) / sizeof(_st_typed_array_element_sizes[0])) {
+        return NULL;
+    }
+    if ((array = st_malloc_struct(malloc, sizeof(st_typed_array_t))) == NULL) {
+        return NULL;
+    }
+
+    array->malloc = malloc;
+    array->data = NULL;
+    array->size = 0;
+    array->capacity = 0;
+    array->type = type;
+
+    if (capacity > ST_SIZE_MAX / _st_typed_array_element_sizes[type]) {
+        return NULL;
+    }
+
+    if (capacity > 0) {
+        array->data = st_malloc_aligned(malloc, ST_SIZE(capacity * _st_typed_array_element_sizes[type]),
+                                        ST_TYPED_ARRAY_ALIGN);
+        if (array->data == NULL) {
+            return NULL;
+        }
+        array->capacity = capacity;
+    }
+    return array;
+}
+
+/* Makes room for "count" more elements */
+static st_bool_t _st_typed_array_reserve(st_typed_array_t *this, st_size_t count)
+{
+    st_size_t element = _st_typed_array_element_sizes[this->type];
+    st_size_t max = ST_SIZE(ST_SIZE_MAX / element);
+    st_size_t capacity, extra;
+    st_malloc_t *malloc = this->malloc;
+    st_byte_t *data;
+
+    if (count <= this->capacity - this->size) {
+        return TRUE;
+    }
+    if (count > max - this->size) {
+        return FALSE;
+    }
+
+    capacity = (this->capacity < ST_TYPED_ARRAY_MIN_CAPACITY)?ST_TYPED_ARRAY_MIN_CAPACITY:this->capacity;
+    capacity = (capacity > max / 2)?max:ST_SIZE(capacity * 2);
+    capacity = (capacity < this->size + count)?ST_SIZE(this->size + count):capacity;
+    extra = ST_SIZE((capacity - this->capacity) * element);
+
+    // The last allocation of the heap can be extended in place
+    if (this->data != NULL && this->data + this->capacity * element == malloc->ptr &&
+        !st_malloc_did_overflow(malloc) && (st_ptr_t)(malloc->top - malloc->ptr) >= extra)
+    {
+        st_malloc_bytes(malloc, extra);
+        this->capacity = capacity;
+        return TRUE;
+    }
+
+    data = st_malloc_aligned(malloc, ST_SIZE(capacity * element), ST_TYPED_ARRAY_ALIGN);
+    if (data == NULL) {
+        return FALSE;
+    }
+
+    if (this->size > 0) {
+        memcpy(data, this->data, this->size * element);
+    }
+    this->data = data;
+    this->capacity = capacity;
+    return TRUE;
+}
+
+st_size_t st_typed_array_get_size(st_typed_array_t *this)
+{
+    return this->size;
+}
+
+st_size_t st_typed_array_get_element_size(st_typed_array_t *this)
+{
+    return _st_typed_array_element_sizes[this->type];
+}
+
+void *st_typed_array_get_data(st_typed_array_t *this)
+{
+    return this->data;
+}
+
+st_bool_t st_typed_array_append_long(st_typed_array_t *this, st_long_t value)
+{
+    if (!_st_typed_array_reserve(this, 1)) {
+        return FALSE;
+    }
+
+    switch(this->type) {
+        case ST_TYPED_ARRAY_INT32:
+            ((int32_t *)this->data)[this->size] = (int32_t)value;
+            break;
+        case ST_TYPED_ARRAY_INT64:
+            ((int64_t *)this->data)[this->size] = value;
+            break;
+        case ST_TYPED_ARRAY_FLOAT64:
+            ((double *)this->data)[this->size] = (double)value;
+            break;
+        case ST_TYPED_ARRAY_UINT8:
+            ((uint8_t *)this->data)[this->size] = (uint8_t)value;
+            break;
+    }
+    this->size++;
+    return TRUE;
+}
+
+st_bool_t st_typed_array_append_float(st_typed_array_t *this, st_float_t value)
+{
+    if (this->type != ST_TYPED_ARRAY_FLOAT64) {
+        return st_typed_array_append_long(this, (st_long_t)value);
+    }
+
+    if (!_st_typed_array_reserve(this, 1)) {
+        return FALSE;
+    }
+    ((double *)this->data)[this->size++] = value;
+    return TRUE;
+}
+
+st_bool_t st_typed_array_append_values(st_typed_array_t *this, const void *values, st_size_t count)
+{
+    st_size_t element = _st_typed_array_element_sizes[this->type];
+
+    if (!_st_typed_array_reserve(this, count)) {
+        return FALSE;
+    }
+
+    if (count > 0) {
+        memcpy(this->data + this->size * element, values, count * element);
+    }
+    this->size = ST_SIZE(this->size + count);
+    return TRUE;
+}
+
+st_long_t st_typed_array_get_long(st_typed_array_t *this, st_size_t index)
+{
+    if (index >= this->size) {
+        return 0;
+    }
+
+    switch(this->type) {
+        case ST_TYPED_ARRAY_INT32:
+            return ((int32_t *)this->data)[index];
+        case ST_TYPED_ARRAY_INT64:
+            return ((int64_t *)this->data)[index];
+        case ST_TYPED_ARRAY_FLOAT64:
+            return (st_long_t)((double *)this->data)[index];
+        case ST_TYPED_ARRAY_UINT8:
+            return ((uint8_t *)this->data)[index];
+        default:
+            return 0;
+    }
+}
+
+st_float_t st_typed_array_get_float(st_typed_array_t *this, st_size_t index)
+{
+    if (this->type == ST_TYPED_ARRAY_FLOAT64) {
+        return (index < this->size)?((double *)this->data)[index]:0;
+    }
+    return (st_float_t)st_typed_array_get_long(this, index);
+}
+
+st_typed_array_t *st_typed_array_slice(st_typed_array_t *this, st_size_t start, st_size_t end)
+{
+    st_typed_array_t *slice;
+
+    end = (end > this->size)?this->size:end;
+    start = (start > end)?end:start;
+
+    slice = st_typed_array_new(this->malloc, this->type, ST_SIZE(end - start));
+    if (slice == NULL) {
+        return NULL;
+    }
+
+    st_typed_array_append_values(slice, this->data + start * _st_typed_array_element_sizes[this->type],
+                                 ST_SIZE(end - start));
+    return slice;
+}
+
+st_size_t st_typed_array_lower_bound(st_typed_array_t *this, st_float_t value)
+{
+    st_size_t low = 0, high = this->size, middle;
+
+    while (low < high) {
+        middle = ST_SIZE(low + (high - low) / 2);
+        if (st_typed_array_get_float(this, middle) < value) {
+            low = ST_SIZE(middle + 1);
+        }
+        else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/* Reductions */
+
+st_float_t st_typed_array_sum(st_typed_array_t *this)
+{
+    const st_typed_array_kernels_t *kernels = _st_typed_array_kernels();
+
+    switch(this->type) {
+        case ST_TYPED_ARRAY_INT32:
+            return (st_float_t)kernels->sum_i32((const int32_t *)this->data, this->size);
+        case ST_TYPED_ARRAY_INT64:
+            return (st_float_t)kernels->sum_i64((const int64_t *)this->data, this->size);
+        case ST_TYPED_ARRAY_FLOAT64:
+            return kernels->sum_f64((const double *)this->data, this->size);
+        case ST_TYPED_ARRAY_UINT8:
+            return (st_float_t)kernels->sum_u8(this->data, this->size);
+        default:
+            return 0;
+    }
+}
+
+st_float_t st_typed_array_min(st_typed_array_t *this)
+{
+    const st_typed_array_kernels_t *kernels = _st_typed_array_kernels();
+
+    if (this->size == 0) {
+        return 0;
+    }
+
+    switch(this->type) {
+        case ST_TYPED_ARRAY_INT32:
+            return kernels->min_i32((const int32_t *)this->data, this->size);
+        case ST_TYPED_ARRAY_INT64:
+            return (st_float_t)kernels->min_i64((const int64_t *)this->data, this->size);
+        case ST_TYPED_ARRAY_FLOAT64:
+            return kernels->min_f64((const double *)this->data, this->size);
+        case ST_TYPED_ARRAY_UINT8:
+            return kernels->min_u8(this->data, this->size);
+        default:
+            return 0;
+    }
+}
+
+st_float_t st_typed_array_max(st_typed_array_t *this)
+{
+    const st_typed_array_kernels_t *kernels = _st_typed_array_kernels();
+
+    if (this->size == 0) {
+        return 0;
+    }
+
+    switch(this->type) {
+        case ST_TYPED_ARRAY_INT32:
+            return kernels->max_i32((const int32_t *)this->data, this->size);
+        case ST_TYPED_ARRAY_INT64:
+            return (st_float_t)kernels->max_i64((const int64_t *)this->data, this->size);
+        case ST_TYPED_ARRAY_FLOAT64:
+            return kernels->max_f64((const double *)this->data, this->size);
+        case ST_TYPED_ARRAY_UINT8:
+            return kernels->max_u8(this->data, this->size);
+        default:
+            return 0;
+    }
+}
+
+st_float_t st_typed_array_dot(st_typed_array_t *this, st_typed_array_t *other)
+{
+    const st_typed_array_kernels_t *kernels = _st_typed_array_kernels();
+    st_float_t sum = 0;
+    st_size_t i;
+
+    if (this->type != other->type || this->size != other->size) {
+        return 0;
+    }
+
+    switch(this->type) {
+        case ST_TYPED_ARRAY_INT32:
+            return kernels->dot_i32((const int32_t *)this->data, (const int32_t *)other->data, this->size);
+        case ST_TYPED_ARRAY_FLOAT64:
+            return kernels->dot_f64((const double *)this->data, (const double *)other->data, this->size);
+        case ST_TYPED_ARRAY_UINT8:
+            return kernels->dot_u8(this->data, other->data, this->size);
+        default:
+            // Neither SSE2 nor AVX2 can multiply or convert 64-bit integers, int64 stays scalar
+            for (i=0; i<this->size; i++) {
+                sum += st_typed_array_get_float(this, i) * st_typed_array_get_float(other, i);
+            }
+            return sum;
+    }
+}
+
+void st_typed_array_scale(st_typed_array_t *this, st_float_t factor)
+{
+    const st_typed_array_kernels_t *kernels = _st_typed_array_kernels();
+    st_size_t i;
+
+    switch(this->type) {
+        case ST_TYPED_ARRAY_INT32:
+            kernels->scale_i32((int32_t *)this->data, this->size, factor);
+            break;
+        case ST_TYPED_ARRAY_INT64:
+            for (i=0; i<this->size; i++) {
+                ((int64_t *)this->data)[i] = (int64_t)(((int64_t *)this->data)[i] * factor);
+            }
+            break;
+        case ST_TYPED_ARRAY_FLOAT64:
+            kernels->scale_f64((double *)this->data, this->size, factor);
+            break;
+        case ST_TYPED_ARRAY_UINT8:
+            for (i=0; i<this->size; i++) {
+                this->data[i] = (uint8_t)(this->data[i] * factor);
+            }
+            break;
+    }
+}
@@ -0,0 +1,151 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef __ST_OBJECTS_ST_TYPED_ARRAY_H__
+#define __ST_OBJECTS_ST_TYPED_ARRAY_H__
+
+#include "st_object.h"
+
+/* Alignment of the element storage (an AVX2 register) */
+#define ST_TYPED_ARRAY_ALIGN 32
+
+typedef enum
+{
+    ST_TYPED_ARRAY_INT32,
+    ST_TYPED_ARRAY_INT64,
+    ST_TYPED_ARRAY_FLOAT64,
+    ST_TYPED_ARRAY_UINT8
+} st_typed_array_type_t;
+
+typedef enum
+{
+    ST_TYPED_ARRAY_ISA_SCALAR,
+    ST_TYPED_ARRAY_ISA_SSE2,
+    ST_TYPED_ARRAY_ISA_AVX2
+} st_typed_array_isa_t;
+
+/**
+ * A packed array of numbers of one type.  The elements are stored
+ * contiguously in the heap, so an element costs its own size instead of a
+ * link, an object and a value.  When the storage is full it is extended in
+ * place if it is the last allocation of the heap, otherwise it is moved to a
+ * block twice the size (the old block stays in the heap until it is freed).
+ */
+typedef struct st_typed_array_s
+{
+    st_malloc_t *malloc;
+    st_byte_t *data;
+    st_size_t size;
+    st_size_t capacity;
+    st_typed_array_type_t type;
+} st_typed_array_t;
+
+/**
+ * Creates a typed array
+ * @param malloc Pointer to the st_malloc instance
+ * @param type The type of the elements
+ * @param capacity The number of elements to reserve storage for (can be 0)
+ * @return Pointer to the typed array (or NULL if the heap is full or "type" is not valid)
+ */
+st_typed_array_t *st_typed_array_new(st_malloc_t *malloc, st_typed_array_type_t type, st_size_t capacity);
+
+st_size_t st_typed_array_get_size(st_typed_array_t *this);
+st_size_t st_typed_array_get_element_size(st_typed_array_t *this);
+
+/* Pointer to the elements (e.g. "(double *)"), it moves when the array grows */
+void *st_typed_array_get_data(st_typed_array_t *this);
+
+/* Appends a value converted to the element type, returns "FALSE" if the heap is full */
+st_bool_t st_typed_array_append_long(st_typed_array_t *this, st_long_t value);
+st_bool_t st_typed_array_append_float(st_typed_array_t *this, st_float_t value);
+
+/**
+ * Appends elements that already have the element type
+ * @param this Pointer to the typed array
+ * @param values Pointer to the elements
+ * @param count The number of elements
+ * @return "TRUE" if the elements were appended
+ */
+st_bool_t st_typed_array_append_values(st_typed_array_t *this, const void *values, st_size_t count);
+
+/* Returns the element at "index" converted to the requested type (or 0 if out of range) */
+st_long_t st_typed_array_get_long(st_typed_array_t *this, st_size_t index);
+st_float_t st_typed_array_get_float(st_typed_array_t *this, st_size_t index);
+
+/**
+ * Copies the elements in ["start", "end") to a new typed array in the same heap
+ * @param this Pointer to the typed array
+ * @param start Index of the first element
+ * @param end Index past the last element (clamped to the size)
+ * @return Pointer to the new typed array (or NULL)
+ */
+st_typed_array_t *st_typed_array_slice(st_typed_array_t *this, st_size_t start, st_size_t end);
+
+/**
+ * Binary search in a typed array sorted in ascending order
+ * @param this Pointer to the typed array
+ * @param value The value to look for
+ * @return Index of the first element that is not less than "value" (the size if there is none)
+ */
+st_size_t st_typed_array_lower_bound(st_typed_array_t *this, st_float_t value);
+
+/**
+ * Reductions.  Integer sums are exact up to 2^53, the dot product is
+ * computed in double precision and all of them return 0 for an empty array.
+ * The result of "min" and "max" is unspecified if a double is NaN.
+ */
+st_float_t st_typed_array_sum(st_typed_array_t *this);
+st_float_t st_typed_array_min(st_typed_array_t *this);
+st_float_t st_typed_array_max(st_typed_array_t *this);
+
+/**
+ * Returns the dot product of two typed arrays
+ * @param this Pointer to the first typed array
+ * @param other Pointer to the second typed array (same type and size)
+ * @return The dot product (or 0 if the arrays do not match)
+ */
+st_float_t st_typed_array_dot(st_typed_array_t *this, st_typed_array_t *other);
+
+/**
+ * Multiplies every element by "factor".  Integer results are truncated
+ * towards zero and must fit the element type.
+ * @param this Pointer to the typed array
+ * @param factor The factor
+ */
+void st_typed_array_scale(st_typed_array_t *this, st_float_t factor);
+
+/**
+ * Selects the kernels used by the reductions.  By default the best kernels
+ * supported by the CPU are used, picked once on first use.  The selection is
+ * shared by every thread and can be changed from any of them.
+ * @param isa The instruction set
+ * @return "TRUE" if the instruction set is supported and now in use
+ */
+st_bool_t st_typed_array_use_isa(st_typed_array_isa_t isa);
+st_typed_array_isa_t st_typed_array_get_isa(void);
+
+#endif // __ST_OBJECTS_ST_TYPED_ARRAY_H__
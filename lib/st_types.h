@@ -29,13 +29,26 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define __ST_OBJECTS_ST_TYPES_H__
 
 #include <stdint.h>
+#include "st_config.h"
 
 typedef uintptr_t st_ptr_t;
 typedef uint8_t st_bool_t;
+#if ST_SIZE_BITS == 16
 typedef uint16_t st_size_t;
+#define ST_SIZE_MAX UINT16_MAX
+#elif ST_SIZE_BITS == 32
+typedef uint32_t st_size_t;
+#define ST_SIZE_MAX UINT32_MAX
+#elif ST_SIZE_BITS == 64
+typedef uint64_t st_size_t;
+#define ST_SIZE_MAX UINT64_MAX
+#else
+#error "ST_SIZE_BITS must be 16, 32 or 64"
+#endif
 typedef uint8_t st_byte_t;
 struct st_dict_s;
 struct st_array_s;
+struct st_typed_array_s;
 typedef char * st_string_t;
 typedef int32_t st_int_t;
 typedef int64_t st_long_t;
@@ -26,17 +26,31 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 extern int test_st_malloc();
+extern int test_st_malloc_shared();
+extern int test_st_malloc_mmap();
 extern int test_st_object();
 extern int test_st_array();
 extern int test_st_dict();
+extern int test_st_clone();
+extern int test_st_image();
+extern int test_st_intern();
+extern int test_st_index();
+extern int test_st_typed_array();
 
 int main() {
     int errors = 0;
 
     errors += test_st_malloc();
+    errors += test_st_malloc_shared();
+    errors += test_st_malloc_mmap();
     errors += test_st_object();
     errors += test_st_array();
     errors += test_st_dict();
+    errors += test_st_clone();
+    errors += test_st_image();
+    errors += test_st_intern();
+    errors += test_st_index();
+    errors += test_st_typed_array();
 
     return errors;
 }
\ No newline at end of file
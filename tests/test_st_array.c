@@ -26,7 +26,8 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 #include <stdio.h>
-#include "../lib/st_array.h"
+#include <string.h>
+#include "../lib/st_dict.h"
 
 static uint8_t _heap[1024];
 
@@ -50,7 +51,7 @@ void compare_link_value(st_array_t *array, int index, int value)
 
 void compare_object_value(st_array_t *array, int index, int value)
 {
-    st_object_t *temp_object = st_array_get_object(array, (uint16_t)index);
+    st_object_t *temp_object = st_array_get_object(array, ST_SIZE(index));
     if (st_object_get_int(temp_object) != value)
     {
         printf("object value != %d and was supposed to\n", value);
@@ -135,6 +136,25 @@ void link_tests()
 
     compare_array_length(temp_array, 1);
     compare_link_value(temp_array, 0, 12);
+
+    /* A link owned by the caller is not handed to the free lists when its object is removed */
+    {
+        st_link_t caller_link;
+
+        st_link_init(&caller_link, temp_object, NULL);
+        st_array_append_link(temp_array, &caller_link);
+        st_array_remove_object(temp_array, 1);
+
+        if (st_link_new(&st_m, temp_object, NULL) == &caller_link)
+        {
+            printf("A caller owned link was recycled by the array\n");
+            errors++;
+        }
+        else
+        {
+            passes++;
+        }
+    }
 }
 
 void object_tests()
@@ -214,12 +234,667 @@ void object_tests()
     }
 }
 
+/* Orders ints by their tens only, so the sort has to keep equal elements in order */
+static int order_tens(st_object_t *object1, st_object_t *object2)
+{
+    return st_object_get_int(object1) / 10 - st_object_get_int(object2) / 10;
+}
+
+/* Checks both directions of the links after a sort */
+static st_bool_t check_links(st_array_t *array)
+{
+    st_link_t *link, *prev = NULL;
+    st_size_t count = 0;
+
+    for (link = array->first; link != NULL; prev = link, link = link->next, count++) {
+        if (link->prev != prev) {
+            return FALSE;
+        }
+    }
+    return ST_BOOL(prev == array->last && count == array->size);
+}
+
+void sort_tests()
+{
+    static st_ptr_t heap[4096/sizeof(st_ptr_t)];
+    st_malloc_t st_m;
+    st_array_t *array;
+    st_dict_t *dict;
+    st_object_t *objects[8], *key;
+    st_link_t *link;
+    st_bool_t sorted = TRUE;
+    int i, previous;
+
+    st_malloc_init(&st_m, (st_byte_t *)heap, sizeof(heap));
+
+    // Mixed types follow the total order
+    array = st_array_new(&st_m);
+    dict = st_dict_new(&st_m);
+    st_array_append_object(array, st_object_new_dict(&st_m, dict));
+    st_array_append_object(array, st_object_new_string(&st_m, "b"));
+    st_array_append_object(array, st_object_new_float(&st_m, 2.5));
+    st_array_append_object(array, st_object_new_long(&st_m, 1));
+    st_array_append_object(array, st_object_new_blob(&st_m, "a", 1));
+    st_array_append_object(array, st_object_new_bool(&st_m, TRUE));
+    st_array_append_object(array, st_object_new_int(&st_m, 1));
+    st_array_append_object(array, st_object_new_string(&st_m, "a"));
+
+    if (!st_array_sort(array, NULL) || !check_links(array) ||
+        st_object_get_type(st_array_get_object(array, 0)) != ST_OBJECT_TYPE_BOOL ||
+        st_object_get_type(st_array_get_object(array, 1)) != ST_OBJECT_TYPE_INT ||
+        st_object_get_type(st_array_get_object(array, 2)) != ST_OBJECT_TYPE_LONG ||
+        st_object_get_float(st_array_get_object(array, 3)) != 2.5 ||
+        *st_object_get_string(st_array_get_object(array, 4)) != 'a' ||
+        *st_object_get_string(st_array_get_object(array, 5)) != 'b' ||
+        st_object_get_type(st_array_get_object(array, 6)) != ST_OBJECT_TYPE_BLOB ||
+        st_object_get_dict(st_array_get_object(array, 7)) != dict)
+    {
+        printf("mixed types were not sorted in the total order\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // Binary search over the sorted objects
+    for (link = array->first, i = 0; link != NULL; link = link->next, i++) {
+        objects[i] = link->object;
+    }
+    key = st_object_new_int(&st_m, 1);
+    if (st_object_lower_bound(objects, 8, key, NULL) != 1 ||
+        st_object_lower_bound(objects, 8, st_object_new_float(&st_m, 1.0), NULL) != 3 ||
+        st_object_lower_bound(objects, 8, st_object_new_string(&st_m, "ab"), NULL) != 5 ||
+        st_object_lower_bound(objects, 8, st_object_new_array(&st_m, array), NULL) != 7)
+    {
+        printf("the lower bound was wrong\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // A custom order, equal elements keep their order (element "v" was appended at (v * 23) % 50)
+    array = st_array_new(&st_m);
+    for (i=0; i<50; i++) {
+        st_array_append_object(array, st_object_new_int(&st_m, (i * 37) % 50));
+    }
+    st_array_sort(array, order_tens);
+    for (link = array->first, previous = -1; link != NULL; link = link->next) {
+        i = st_object_get_int(link->object);
+        sorted = ST_BOOL(sorted && (previous < 0 || previous / 10 < i / 10 ||
+                                    (previous / 10 == i / 10 && (previous * 23) % 50 < (i * 23) % 50)));
+        previous = i;
+    }
+    if (!sorted || !check_links(array) || st_array_get_size(array) != 50)
+    {
+        printf("the custom sort was not stable\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // A dict sorted by its keys, frozen arrays are not sorted
+    dict = st_dict_new(&st_m);
+    st_dict_set_object(dict, st_object_new_string(&st_m, "y"), st_object_new_int(&st_m, 1));
+    st_dict_set_object(dict, st_object_new_string(&st_m, "x"), st_object_new_int(&st_m, 2));
+    key = st_object_new_dict(&st_m, dict);
+    st_array_sort_keys(dict->array, NULL);
+    st_object_set_frozen(key);
+    if (*st_object_get_string(dict->array->first->key) != 'x' || !check_links(dict->array) ||
+        st_array_sort_keys(dict->array, NULL))
+    {
+        printf("the dict was not sorted by its keys\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+/* Checks that the slots, the links and "expected" agree */
+static st_bool_t check_vector(st_array_t *array, const int *expected, int count)
+{
+    st_link_t *link;
+    int i;
+
+    for (link = array->first, i = 0; link != NULL && i < count; link = link->next, i++) {
+        if (array->slots[i] != link || st_object_get_int(st_array_get_object(array, ST_SIZE(i))) != expected[i]) {
+            return FALSE;
+        }
+    }
+    return ST_BOOL(link == NULL && i == count && array->size == count && check_links(array));
+}
+
+void vector_tests()
+{
+    static st_ptr_t heap[4096/sizeof(st_ptr_t)];
+    static const int after_insert[] = { -1, 0, 1, -2, 2, 3, 4, 5, 6, 7, 8, 9, -3 };
+    static const int after_remove[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    static const int sorted[] = { 1, 2, 3 };
+    st_malloc_t st_m;
+    st_array_t *array;
+    st_link_t **slots;
+    int i;
+
+    st_malloc_init(&st_m, (st_byte_t *)heap, sizeof(heap));
+
+    // Appends grow the slots, the old buffer is left behind
+    array = st_array_new_vector(&st_m, 2);
+    slots = array->slots;
+    for (i=0; i<10; i++) {
+        st_array_append_object(array, st_object_new_int(&st_m, i));
+    }
+    st_array_insert_object(array, st_object_new_int(&st_m, -1), 0);
+    st_array_insert_object(array, st_object_new_int(&st_m, -2), 3);
+    st_array_insert_object(array, st_object_new_int(&st_m, -3), 100);
+    if (array->slots == slots || array->capacity < 13 || !check_vector(array, after_insert, 13))
+    {
+        printf("inserting into the vector failed\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    st_array_remove_object(array, 0);
+    st_array_remove_object(array, 2);
+    st_array_remove_link(array, 10);
+    if (!check_vector(array, after_remove, 10) || st_array_get_link(array, 10) != NULL)
+    {
+        printf("removing from the vector failed\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // An existing list switches to vector mode and stays indexed after a sort
+    array = st_array_new(&st_m);
+    st_array_append_object(array, st_object_new_int(&st_m, 3));
+    st_array_append_object(array, st_object_new_int(&st_m, 1));
+    st_array_append_object(array, st_object_new_int(&st_m, 2));
+    if (!st_array_use_vector(array, 0) || array->capacity < 3 || !st_array_sort(array, NULL) ||
+        !check_vector(array, sorted, 3))
+    {
+        printf("switching to vector mode failed\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+/* Compares the objects of an array with "expected", walking the links both ways */
+static st_bool_t check_values(st_array_t *array, const int *expected, int count)
+{
+    st_link_t *link;
+    int i = 0;
+
+    ST_ARRAY_FOREACH(array, link) {
+        if (i >= count || st_object_get_int(link->object) != expected[i++]) {
+            return FALSE;
+        }
+    }
+    ST_ARRAY_FOREACH_REVERSE(array, link) {
+        if (i == 0 || st_object_get_int(link->object) != expected[--i]) {
+            return FALSE;
+        }
+    }
+    return ST_BOOL(i == 0 && array->size == count && check_links(array) &&
+                   (array->slots == NULL || check_vector(array, expected, count)));
+}
+
+void cursor_tests()
+{
+    static st_ptr_t heap[4096/sizeof(st_ptr_t)];
+    static const int forward[] = { -1, 1, -3, 3, -5, 5, -7, 7, -9, 9, 10 };
+    static const int reverse[] = { 20, 1, 8, 3, 5, 24, 7, 9, 40 };
+    st_malloc_t st_m;
+    st_array_t *array;
+    st_array_cursor_t cursor;
+    st_dict_t *dict;
+    st_link_t *link;
+    int i, vector;
+    st_bool_t ok;
+
+    for (vector=0; vector<2; vector++)
+    {
+        st_malloc_init(&st_m, (st_byte_t *)heap, sizeof(heap));
+        array = vector?st_array_new_vector(&st_m, 4):st_array_new(&st_m);
+        for (i=0; i<10; i++) {
+            st_array_append_object(array, st_object_new_int(&st_m, i));
+        }
+
+        // Remove the even values and put the negated odd ones in front of them
+        for (st_array_cursor_init(&cursor, array, FALSE); (link = st_array_cursor_get_link(&cursor)) != NULL; )
+        {
+            i = st_object_get_int(link->object);
+            if (i % 2 == 0) {
+                st_array_cursor_remove(&cursor);
+            }
+            else {
+                st_array_cursor_insert(&cursor, st_object_new_int(&st_m, -i));
+                st_array_cursor_next(&cursor);
+            }
+        }
+        st_array_cursor_insert(&cursor, st_object_new_int(&st_m, 10));
+        ok = ST_BOOL(check_values(array, forward, 11) && cursor.index == 11 &&
+                     st_object_get_int(st_array_cursor_prev(&cursor)->object) == 10 &&
+                     st_object_get_int(st_array_cursor_prev(&cursor)->object) == 9);
+
+        // The same in reverse, the negated values go and the inserts are visited before the current link
+        for (st_array_cursor_init(&cursor, array, TRUE); (link = st_array_cursor_get_link(&cursor)) != NULL; )
+        {
+            i = st_object_get_int(link->object);
+            if (i < 0 || i == 10) {
+                st_array_cursor_remove(&cursor);
+            }
+            else {
+                if (i % 4 == 1) {
+                    st_array_cursor_insert(&cursor, st_object_new_int(&st_m, i * 4 + 4));
+                }
+                st_array_cursor_next(&cursor);
+            }
+        }
+        st_array_cursor_insert(&cursor, st_object_new_int(&st_m, 20));
+        ok = ST_BOOL(ok && check_values(array, reverse, 9) && st_array_cursor_prev(&cursor) == array->first &&
+                     st_array_cursor_prev(&cursor) == array->first->next && cursor.index == 1);
+
+        st_array_cursor_init(&cursor, array, FALSE);
+        ok = ST_BOOL(ok && st_array_cursor_prev(&cursor) == NULL && cursor.link == array->first && cursor.index == 0);
+
+        if (!ok)
+        {
+            printf("the %s cursor failed\n", vector?"vector":"list");
+            errors++;
+        }
+        else
+        {
+            passes++;
+        }
+    }
+
+    // Dict entries removed while walking
+    dict = st_dict_new(&st_m);
+    for (i=0; i<6; i++) {
+        st_dict_set_object(dict, st_object_new_int(&st_m, i), st_object_new_int(&st_m, i * i));
+    }
+    for (st_dict_cursor_init(&cursor, dict, TRUE); cursor.link != NULL; ) {
+        if (st_object_get_int(cursor.link->object) % 2 == 1) {
+            st_array_cursor_remove(&cursor);
+        }
+        else {
+            st_array_cursor_next(&cursor);
+        }
+    }
+    if (st_dict_get_size(dict) != 3 || st_dict_has_key(dict, st_object_new_int(&st_m, 3)) ||
+        st_object_get_int(st_dict_get_object(dict, st_object_new_int(&st_m, 4))) != 16 ||
+        !st_dict_remove_object(dict, st_object_new_int(&st_m, 2)) || st_dict_get_size(dict) != 2)
+    {
+        printf("the dict cursor failed\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+/* Checks the chain of blocks of an unrolled array and compares its objects with "expected" both ways */
+static st_bool_t check_unrolled(st_array_t *array, const int *expected, int count)
+{
+    st_array_block_t *block, *prev = NULL;
+    st_array_cursor_t cursor;
+    int i = 0, total = 0;
+
+    for (block = array->first_block; block != NULL; prev = block, block = block->next) {
+        if (block->prev != prev || block->count == 0 || block->count > ST_ARRAY_BLOCK_SLOTS) {
+            return FALSE;
+        }
+        total += block->count;
+    }
+    if (array->last_block != prev || total != count || array->size != count) {
+        return FALSE;
+    }
+
+    ST_ARRAY_CURSOR_FOREACH(&cursor, array) {
+        if (i >= count || cursor.index != i || st_object_get_int(st_array_cursor_get_object(&cursor)) != expected[i] ||
+            st_object_get_int(st_array_get_object(array, ST_SIZE(i))) != expected[i])
+        {
+            return FALSE;
+        }
+        i++;
+    }
+    for (st_array_cursor_init(&cursor, array, TRUE); !st_array_cursor_at_end(&cursor); st_array_cursor_next(&cursor)) {
+        if (i == 0 || st_object_get_int(st_array_cursor_get_object(&cursor)) != expected[--i]) {
+            return FALSE;
+        }
+    }
+    return ST_BOOL(i == 0 && st_array_get_object(array, ST_SIZE(count)) == NULL);
+}
+
+void unrolled_tests()
+{
+    static st_ptr_t heap[32768/sizeof(st_ptr_t)];
+    static const int forward[] = { -1, 1, -3, 3, -5, 5, -7, 7, -9, 9, 10 };
+    static const int reverse[] = { 20, 1, 8, 3, 5, 24, 7, 9, 40 };
+    int model[200];
+    st_malloc_t st_m;
+    st_array_t *array;
+    st_array_cursor_t cursor;
+    st_dict_t *dict, *list_dict;
+    st_object_t *object1, *object2;
+    int i, index, size = 0;
+    st_bool_t ok = TRUE;
+
+    st_malloc_init(&st_m, (st_byte_t *)heap, sizeof(heap));
+    array = st_array_new_unrolled(&st_m, FALSE);
+
+    // Inserts all over the array split the blocks
+    for (i=0; i<200; i++) {
+        index = (i * 7) % (size + 1);
+        memmove(model + index + 1, model + index, (size - index) * sizeof(int));
+        model[index] = i;
+        size++;
+        ok = ST_BOOL(ok && st_array_insert_object(array, st_object_new_int(&st_m, i), ST_SIZE(index)));
+    }
+    ok = ST_BOOL(ok && check_unrolled(array, model, size));
+
+    // Removes merge the blocks that fall below half full
+    while (size > 20) {
+        index = (size * 7) % 23 % size;
+        memmove(model + index, model + index + 1, (size - index - 1) * sizeof(int));
+        size--;
+        ok = ST_BOOL(ok && st_array_remove_object(array, ST_SIZE(index)));
+    }
+    ok = ST_BOOL(ok && check_unrolled(array, model, size) && !st_array_remove_object(array, ST_SIZE(size)) &&
+                 !st_array_insert_object(array, NULL, ST_SIZE(size + 1)));
+
+    // The link methods do not apply
+    ok = ST_BOOL(ok && st_array_get_link(array, 0) == NULL && array->first == NULL &&
+                 !st_array_append_link(array, st_link_new(&st_m, NULL, NULL)) &&
+                 !st_array_sort(array, NULL) && !st_array_use_vector(array, 0));
+
+    if (!ok)
+    {
+        printf("the unrolled array failed\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // The cursor test of the other modes gives the same results
+    array = st_array_new_unrolled(&st_m, FALSE);
+    for (i=0; i<10; i++) {
+        st_array_append_object(array, st_object_new_int(&st_m, i));
+    }
+    for (st_array_cursor_init(&cursor, array, FALSE); !st_array_cursor_at_end(&cursor); )
+    {
+        i = st_object_get_int(st_array_cursor_get_object(&cursor));
+        if (i % 2 == 0) {
+            st_array_cursor_remove(&cursor);
+        }
+        else {
+            st_array_cursor_insert(&cursor, st_object_new_int(&st_m, -i));
+            st_array_cursor_next(&cursor);
+        }
+    }
+    st_array_cursor_insert(&cursor, st_object_new_int(&st_m, 10));
+    ok = ST_BOOL(check_unrolled(array, forward, 11) && cursor.index == 11);
+    st_array_cursor_prev(&cursor);
+    ok = ST_BOOL(ok && st_object_get_int(st_array_cursor_get_object(&cursor)) == 10);
+    st_array_cursor_prev(&cursor);
+    ok = ST_BOOL(ok && st_object_get_int(st_array_cursor_get_object(&cursor)) == 9 && cursor.index == 9);
+
+    for (st_array_cursor_init(&cursor, array, TRUE); !st_array_cursor_at_end(&cursor); )
+    {
+        i = st_object_get_int(st_array_cursor_get_object(&cursor));
+        if (i < 0 || i == 10) {
+            st_array_cursor_remove(&cursor);
+        }
+        else {
+            if (i % 4 == 1) {
+                st_array_cursor_insert(&cursor, st_object_new_int(&st_m, i * 4 + 4));
+            }
+            st_array_cursor_next(&cursor);
+        }
+    }
+    st_array_cursor_insert(&cursor, st_object_new_int(&st_m, 20));
+    ok = ST_BOOL(ok && check_unrolled(array, reverse, 9));
+    st_array_cursor_prev(&cursor);
+    st_array_cursor_prev(&cursor);
+    ok = ST_BOOL(ok && st_object_get_int(st_array_cursor_get_object(&cursor)) == 1 && cursor.index == 1);
+
+    if (!ok)
+    {
+        printf("the unrolled cursor failed\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // An unrolled dict equals (and hashes like) a linked one with the same entries
+    dict = st_dict_new_unrolled(&st_m);
+    list_dict = st_dict_new(&st_m);
+    for (i=0; i<40; i++) {
+        st_dict_set_object(dict, st_object_new_int(&st_m, i), st_object_new_int(&st_m, i * i));
+        st_dict_set_object(list_dict, st_object_new_int(&st_m, 39 - i), st_object_new_int(&st_m, (39 - i) * (39 - i)));
+    }
+    st_dict_set_object(dict, st_object_new_int(&st_m, 5), st_object_new_int(&st_m, -5));
+    st_dict_set_object(list_dict, st_object_new_int(&st_m, 5), st_object_new_int(&st_m, -5));
+    for (i=0; i<40; i+=3) {
+        st_dict_remove_object(dict, st_object_new_int(&st_m, i));
+        st_dict_remove_object(list_dict, st_object_new_int(&st_m, i));
+    }
+    object1 = st_object_new_dict(&st_m, dict);
+    object2 = st_object_new_dict(&st_m, list_dict);
+    ok = ST_BOOL(st_dict_get_size(dict) == 26 && !st_dict_has_key(dict, st_object_new_int(&st_m, 3)) &&
+                 st_object_get_int(st_dict_get_object(dict, st_object_new_int(&st_m, 5))) == -5 &&
+                 st_object_get_int(st_dict_get_object(dict, st_object_new_int(&st_m, 38))) == 38 * 38 &&
+                 st_object_compare(object1, object2) && st_object_hash(object1) == st_object_hash(object2));
+
+    st_object_set_frozen(object1);
+    ok = ST_BOOL(ok && !st_dict_set_object(dict, st_object_new_int(&st_m, 100), NULL) &&
+                 !st_dict_remove_object(dict, st_object_new_int(&st_m, 4)) && st_dict_get_size(dict) == 26);
+
+    if (!ok)
+    {
+        printf("the unrolled dict failed\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // Objects appended to the array of an unrolled dict have no key and are skipped by the lookups
+    dict = st_dict_new_unrolled(&st_m);
+    st_array_append_object(dict->array, st_object_new_int(&st_m, 1));
+    st_dict_set_object(dict, st_object_new_int(&st_m, 2), st_object_new_int(&st_m, 4));
+    if (st_dict_has_key(dict, st_object_new_int(&st_m, 1)) ||
+        st_dict_get_object(dict, st_object_new_int(&st_m, 1)) != NULL ||
+        st_object_get_int(st_dict_get_object(dict, st_object_new_int(&st_m, 2))) != 4)
+    {
+        printf("the unrolled dict did not skip an entry without a key\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+/* Fills "values" with the ints from "first" to "last" */
+static int fill_range(int *values, int first, int last)
+{
+    int i;
+
+    for (i=first; i<=last; i++) {
+        values[i - first] = i;
+    }
+    return last - first + 1;
+}
+
+void bulk_tests()
+{
+    static st_ptr_t heap[32768/sizeof(st_ptr_t)];
+    static const int spliced[] = { 0, 1, 101, 102, 103, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14 };
+    static const int rest[] = { 100, 104 };
+    st_object_t *objects[40], *view_object, *copy_object;
+    int expected[40], count, i, vector;
+    st_array_t *array, *other, *view, *copy;
+    st_array_cursor_t cursor;
+    st_malloc_t st_m;
+    st_link_t *link;
+    st_bool_t ok;
+
+    for (vector=0; vector<2; vector++)
+    {
+        st_malloc_init(&st_m, (st_byte_t *)heap, sizeof(heap));
+        for (i=0; i<40; i++) {
+            objects[i] = st_object_new_int(&st_m, (i < 20)?i:i + 80);
+        }
+
+        // Lists and vectors mix, the appended array is left empty
+        array = vector?st_array_new_vector(&st_m, 4):st_array_new(&st_m);
+        other = vector?st_array_new(&st_m):st_array_new_vector(&st_m, 0);
+        ok = ST_BOOL(st_array_append_objects(array, objects, 10) && st_array_append_objects(other, objects + 10, 5) &&
+                     st_array_concat(array, other) && check_values(other, expected, 0));
+        count = fill_range(expected, 0, 14);
+        ok = ST_BOOL(ok && check_values(array, expected, count));
+
+        // A run moves to the middle of the array and back again
+        other = st_array_new(&st_m);
+        st_array_append_objects(other, objects + 20, 5);
+        ok = ST_BOOL(ok && st_array_splice(array, 2, other, 1, 3) && check_values(array, spliced, 18) &&
+                     check_values(other, rest, 2) && st_array_splice(other, 1, array, 2, 3) &&
+                     check_values(array, expected, count));
+        fill_range(expected, 100, 104);
+        ok = ST_BOOL(ok && check_values(other, expected, 5) && !st_array_splice(array, 0, array, 0, 1) &&
+                     !st_array_splice(array, 16, other, 0, 1) && !st_array_splice(array, 0, other, 3, 3) &&
+                     !st_array_concat(array, st_array_new_unrolled(&st_m, FALSE)));
+
+        // A view walks, indexes, compares and hashes like a copy but can not be modified
+        view = st_array_slice(array, 3, 5);
+        copy = st_array_new(&st_m);
+        st_array_append_objects(copy, objects + 3, 5);
+        view_object = st_object_new_array(&st_m, view);
+        copy_object = st_object_new_array(&st_m, copy);
+        i = 0;
+        ST_ARRAY_FOREACH_REVERSE(view, link) {
+            i++;
+        }
+        ok = ST_BOOL(ok && view != NULL && i == 5 && st_array_get_size(view) == 5 &&
+                     st_object_get_int(st_array_get_object(view, 4)) == 7 && st_array_get_object(view, 5) == NULL &&
+                     st_object_compare(view_object, copy_object) &&
+                     st_object_hash(view_object) == st_object_hash(copy_object) &&
+                     !st_array_append_object(view, objects[0]) && !st_array_remove_object(view, 0) &&
+                     !st_array_sort(view, NULL) && !st_array_concat(view, copy));
+        i = 3;
+        ST_ARRAY_CURSOR_FOREACH(&cursor, view) {
+            ok = ST_BOOL(ok && st_object_get_int(st_array_cursor_get_object(&cursor)) == i++);
+        }
+        ok = ST_BOOL(ok && i == 8 && st_array_slice(array, 15, 0) != NULL && st_array_slice(array, 14, 2) == NULL &&
+                     st_array_get_size(array) == 15);
+
+        if (!ok)
+        {
+            printf("the %s bulk operations failed\n", vector?"vector":"list");
+            errors++;
+        }
+        else
+        {
+            passes++;
+        }
+    }
+
+    // Unrolled arrays move whole blocks on concat and entries on splice
+    array = st_array_new_unrolled(&st_m, FALSE);
+    other = st_array_new_unrolled(&st_m, FALSE);
+    ok = ST_BOOL(st_array_append_object(array, objects[0]) && st_array_append_objects(array, objects + 1, 19) &&
+                 st_array_append_objects(other, objects + 20, 20) && st_array_concat(array, other) &&
+                 check_unrolled(other, expected, 0));
+    count = fill_range(expected, 0, 19);
+    count += fill_range(expected + count, 100, 119);
+    ok = ST_BOOL(ok && check_unrolled(array, expected, count) && st_array_splice(other, 0, array, 5, 30));
+    fill_range(expected, 5, 19);
+    fill_range(expected + 15, 100, 114);
+    ok = ST_BOOL(ok && check_unrolled(other, expected, 30) && st_array_splice(array, 5, other, 0, 30));
+    count = fill_range(expected, 0, 19);
+    count += fill_range(expected + count, 100, 119);
+    ok = ST_BOOL(ok && check_unrolled(array, expected, count) && check_unrolled(other, expected, 0) &&
+                 st_array_slice(array, 0, 1) == NULL && !st_array_concat(array, st_array_new_unrolled(&st_m, TRUE)));
+
+    if (!ok)
+    {
+        printf("the unrolled bulk operations failed\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+#if ST_SIZE_BITS >= 32
+static uint8_t _large_heap[4*1024*1024];
+
+void large_tests()
+{
+    st_size_t i;
+    st_array_t *temp_array;
+
+    st_malloc_t st_m;
+    st_malloc_init(&st_m, _large_heap, sizeof(_large_heap));
+
+    /* More elements than a 16-bit st_size_t can index */
+    temp_array = st_array_new(&st_m);
+    for (i=0; i<70000; i++)
+    {
+        st_array_append_object(temp_array, st_object_new_int(&st_m, ST_INT(i)));
+    }
+
+    if (st_malloc_did_overflow(&st_m))
+    {
+        printf("large array overflowed the heap\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    compare_array_length(temp_array, 70000);
+    compare_object_value(temp_array, 69999, 69999);
+}
+#endif
+
 int test_st_array()
 {
     printf("\nRunning 'st_array' test\n");
 
     link_tests();
     object_tests();
+    sort_tests();
+    vector_tests();
+    cursor_tests();
+    unrolled_tests();
+    bulk_tests();
+#if ST_SIZE_BITS >= 32
+    large_tests();
+#endif
 
     if (errors == 0) {
         printf("Test passed with '%d' passes\n", passes);
@@ -0,0 +1,177 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "../lib/st_clone.h"
+
+static int errors = 0;
+static int passes = 0;
+
+static st_ptr_t _src_heap[1024/sizeof(st_ptr_t)];
+static st_ptr_t _dst_heap[1024/sizeof(st_ptr_t)];
+
+/* Builds {"name": "sensor", "values": [1, 2.5, TRUE, 1 << 40], "nested": {7: "seven"}} */
+static st_object_t *build_source(st_malloc_t *st_m)
+{
+    st_dict_t *dict = st_dict_new(st_m);
+    st_dict_t *nested = st_dict_new(st_m);
+    st_array_t *values = st_array_new(st_m);
+
+    st_array_append_object(values, st_object_new_int(st_m, 1));
+    st_array_append_object(values, st_object_new_float(st_m, 2.5));
+    st_array_append_object(values, st_object_new_bool(st_m, TRUE));
+    st_array_append_object(values, st_object_new_long(st_m, ST_LONG(1) << 40));
+
+    st_dict_set_object(nested, st_object_new_int(st_m, 7), st_object_new_string(st_m, "seven"));
+
+    st_dict_set_object(dict, st_object_new_string(st_m, "name"), st_object_new_string(st_m, "sensor"));
+    st_dict_set_object(dict, st_object_new_string(st_m, "values"), st_object_new_array(st_m, values));
+    st_dict_set_object(dict, st_object_new_string(st_m, "nested"), st_object_new_dict(st_m, nested));
+
+    return st_object_new_dict(st_m, dict);
+}
+
+static void check_copy(st_object_t *copy, st_malloc_t *dst)
+{
+    st_malloc_t keys;
+    st_ptr_t key_heap[256/sizeof(st_ptr_t)];
+    st_dict_t *dict, *nested;
+    st_array_t *values;
+
+    st_malloc_init(&keys, (st_byte_t *)key_heap, sizeof(key_heap));
+
+    dict = st_object_get_dict(copy);
+    values = st_object_get_array(st_dict_get_object(dict, st_object_new_string(&keys, "values")));
+    nested = st_object_get_dict(st_dict_get_object(dict, st_object_new_string(&keys, "nested")));
+
+    if (dict == NULL || values == NULL || nested == NULL ||
+        strcmp(st_object_get_string(st_dict_get_object(dict, st_object_new_string(&keys, "name"))), "sensor") != 0 ||
+        st_array_get_size(values) != 4 ||
+        st_object_get_int(st_array_get_object(values, 0)) != 1 ||
+        st_object_get_float(st_array_get_object(values, 1)) != 2.5 ||
+        st_object_get_bool(st_array_get_object(values, 2)) != TRUE ||
+        st_object_get_long(st_array_get_object(values, 3)) != ST_LONG(1) << 40 ||
+        strcmp(st_object_get_string(st_dict_get_object(nested, st_object_new_int(&keys, 7))), "seven") != 0)
+    {
+        printf("copy did not hold the source values\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // Containers in the copy allocate from the destination heap
+    if (values == NULL || values->malloc != dst || dict->malloc != dst || dict->array->malloc != dst)
+    {
+        printf("copy containers were not owned by the destination heap\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+static void test_clone()
+{
+    st_malloc_t src, dst;
+    st_object_t *object, *copy;
+
+    st_malloc_init(&src, (st_byte_t *)_src_heap, sizeof(_src_heap));
+    st_malloc_init(&dst, (st_byte_t *)_dst_heap, sizeof(_dst_heap));
+
+    object = build_source(&src);
+    copy = st_object_clone(&dst, object);
+
+    // The copy must not depend on the source heap
+    st_malloc_free(&src);
+    memset(_src_heap, 0xa5, sizeof(_src_heap));
+
+    check_copy(copy, &dst);
+}
+
+static void test_clone_reserved()
+{
+    st_malloc_t src, dst;
+    st_object_t *object, *copy;
+    st_size_t size;
+
+    st_malloc_init(&src, (st_byte_t *)_src_heap, sizeof(_src_heap));
+    st_malloc_init(&dst, (st_byte_t *)_dst_heap, sizeof(_dst_heap));
+
+    object = build_source(&src);
+    size = st_object_clone_size(object);
+    copy = st_object_clone_reserved(&dst, object);
+
+    if (copy == NULL || st_malloc_used_bytes(&dst) != size || (st_byte_t *)copy >= dst.heap + size)
+    {
+        printf("reserved copy did not use exactly %u bytes\n", (unsigned)size);
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    st_malloc_free(&src);
+    memset(_src_heap, 0xa5, sizeof(_src_heap));
+    check_copy(copy, &dst);
+
+    // A copy that does not fit fails before anything is built
+    st_malloc_init(&src, (st_byte_t *)_src_heap, sizeof(_src_heap));
+    st_malloc_init(&dst, (st_byte_t *)_dst_heap, ST_SIZE(size - 1));
+    object = build_source(&src);
+
+    if (st_object_clone_reserved(&dst, object) != NULL || !st_malloc_did_overflow(&dst))
+    {
+        printf("reserved copy did not fail as expected\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+int test_st_clone()
+{
+    printf("\nRunning 'st_clone' test\n");
+
+    test_clone();
+    test_clone_reserved();
+
+    if (errors == 0) {
+        printf("Test passed with '%d' passes\n", passes);
+    }
+    else {
+        printf("Test failed with '%d' errors\n", errors);
+    }
+
+    return errors;
+}
@@ -26,13 +26,309 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 #include <stdio.h>
+#include <string.h>
 #include "../lib/st_dict.h"
+#include "../lib/st_typed_array.h"
 
 static int errors = 0;
 static int passes = 0;
 
 static uint8_t _heap[1024];
 
+static void test_borrowed()
+{
+    char rx[] = "name=sensor;data=\x01\x02\x00\x03";
+    st_ptr_t heap[1024/sizeof(st_ptr_t)];
+    st_malloc_t st_m;
+    st_dict_t *dict;
+    st_object_t *object, *name, *data;
+    st_size_t used;
+
+    st_malloc_init(&st_m, (st_byte_t *)heap, sizeof(heap));
+
+    // Parse the packet in place, nothing is copied
+    dict = st_dict_new(&st_m);
+    object = st_object_new_dict(&st_m, dict);
+    st_dict_set_object(dict, st_object_new_string_ref(&st_m, rx, 4), st_object_new_string_ref(&st_m, rx + 5, 6));
+    st_dict_set_object(dict, st_object_new_string_ref(&st_m, rx + 12, 4), st_object_new_blob_ref(&st_m, rx + 17, 4));
+    used = st_malloc_used_bytes(&st_m);
+
+    name = st_dict_get_object(dict, st_object_new_string(&st_m, "name"));
+    data = st_dict_get_object(dict, st_object_new_string(&st_m, "data"));
+
+    if (name == NULL || data == NULL || !st_object_is_borrowed(name) ||
+        st_object_get_string(name) != rx + 5 || st_object_get_string_length(name) != 6 ||
+        st_object_get_blob(data) != (st_byte_t *)rx + 17 || st_object_get_blob_length(data) != 4 ||
+        !st_object_compare(data, st_object_new_blob(&st_m, "\x01\x02\x00\x03", 4)) ||
+        st_object_compare(data, st_object_new_string_n(&st_m, "\x01\x02\x00\x03", 4)))
+    {
+        printf("borrowed strings and blobs did not reference the packet\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // Copy everything into the heap before the packet buffer is reused
+    if (!st_object_materialize(&st_m, object) || st_object_is_borrowed(name) || st_object_is_borrowed(data))
+    {
+        printf("materializing the dict failed\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+    memset(rx, 'x', sizeof(rx));
+
+    if (st_dict_get_object(dict, st_object_new_string(&st_m, "name")) != name ||
+        strcmp(st_object_get_string(name), "sensor") != 0 ||
+        memcmp(st_object_get_blob(data), "\x01\x02\x00\x03", 4) != 0)
+    {
+        printf("materialized values did not survive the packet buffer\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+    printf("borrowed dict: %u bytes in the heap before materializing\n", (unsigned)used);
+}
+
+/* Builds {"id": 7, "tags": ["a", 1.5, 0.0], "meta": {"x": TRUE, "y": [1, 2]}}, "reverse" inserts the keys backwards */
+static void test_full_heap()
+{
+    st_ptr_t heap[512/sizeof(st_ptr_t)];
+    st_malloc_t st_m;
+    st_dict_t *dict, *unrolled;
+    st_object_t *key, *other, *old_value, *new_value;
+
+    st_malloc_init(&st_m, (st_byte_t *)heap, sizeof(heap));
+    dict = st_dict_new(&st_m);
+    unrolled = st_dict_new_unrolled(&st_m);
+    key = st_object_new_int(&st_m, 1);
+    other = st_object_new_int(&st_m, 2);
+    old_value = st_object_new_int(&st_m, 10);
+    new_value = st_object_new_int(&st_m, 20);
+    st_dict_set_object(dict, key, old_value);
+    st_dict_set_object(unrolled, key, old_value);
+
+    // Overwriting a key needs no allocation, a new key fails without touching the others
+    st_malloc_bytes(&st_m, sizeof(heap));
+    if (!st_malloc_did_overflow(&st_m) ||
+        !st_dict_set_object(dict, key, new_value) || st_dict_get_object(dict, key) != new_value ||
+        !st_dict_set_object(unrolled, key, new_value) || st_dict_get_object(unrolled, key) != new_value ||
+        st_dict_set_object(dict, other, old_value) || st_dict_get_size(dict) != 1 ||
+        st_dict_get_object(dict, key) != new_value)
+    {
+        printf("setting a key on a full heap lost its value\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+#if ST_DICT_INDEX_THRESHOLD > 0
+/* A dict that passes the threshold on a nearly full heap stays a list and leaves the heap usable */
+static void test_index_full_heap()
+{
+    st_ptr_t heap[1024/sizeof(st_ptr_t)];
+    st_malloc_t st_m;
+    st_dict_t *dict;
+    st_object_t *key, *value;
+    st_size_t used;
+    int i;
+
+    st_malloc_init(&st_m, (st_byte_t *)heap, sizeof(heap));
+    dict = st_dict_new(&st_m);
+    for (i=0; i<ST_DICT_INDEX_THRESHOLD; i++) {
+        st_dict_set_object(dict, st_object_new_int(&st_m, i), st_object_new_int(&st_m, i));
+    }
+    key = st_object_new_int(&st_m, i);
+    value = st_object_new_int(&st_m, i);
+
+    // Leave room for the link of the next key, not for the index it triggers
+    st_malloc_bytes(&st_m, ST_SIZE(sizeof(heap) - st_malloc_used_bytes(&st_m) - sizeof(st_link_t)));
+    used = st_malloc_used_bytes(&st_m);
+
+    if (st_malloc_did_overflow(&st_m) || !st_dict_set_object(dict, key, value) ||
+        dict->array->index != NULL || st_malloc_did_overflow(&st_m) ||
+        st_malloc_used_bytes(&st_m) != used + sizeof(st_link_t) ||
+        st_dict_get_object(dict, key) != value || st_dict_get_size(dict) != ST_DICT_INDEX_THRESHOLD + 1)
+    {
+        printf("a failed index left the heap overflowed\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+#endif
+
+static st_object_t *build_document(st_malloc_t *st_m, st_bool_t reverse, st_float_t zero)
+{
+    st_dict_t *dict = st_dict_new(st_m), *meta = st_dict_new(st_m);
+    st_array_t *tags = st_array_new(st_m), *y = st_array_new(st_m);
+    st_object_t *keys[3], *values[3];
+    int i;
+
+    st_array_append_object(tags, st_object_new_string(st_m, "a"));
+    st_array_append_object(tags, st_object_new_float(st_m, 1.5));
+    st_array_append_object(tags, st_object_new_float(st_m, zero));
+    st_array_append_object(y, st_object_new_int(st_m, 1));
+    st_array_append_object(y, st_object_new_long(st_m, 2));
+
+    keys[0] = st_object_new_string(st_m, "id");
+    values[0] = st_object_new_int(st_m, 7);
+    keys[1] = st_object_new_string(st_m, "tags");
+    values[1] = st_object_new_array(st_m, tags);
+    keys[2] = st_object_new_string(st_m, "meta");
+    values[2] = st_object_new_dict(st_m, meta);
+
+    for (i=0; i<3; i++) {
+        st_dict_set_object(dict, keys[reverse?2-i:i], values[reverse?2-i:i]);
+    }
+    st_dict_set_object(meta, st_object_new_string(st_m, reverse?"y":"x"),
+                       reverse?st_object_new_array(st_m, y):st_object_new_bool(st_m, TRUE));
+    st_dict_set_object(meta, st_object_new_string(st_m, reverse?"x":"y"),
+                       reverse?st_object_new_bool(st_m, TRUE):st_object_new_array(st_m, y));
+
+    return st_object_new_dict(st_m, dict);
+}
+
+static void test_structural()
+{
+    static st_ptr_t heap[8192/sizeof(st_ptr_t)];
+    int32_t samples[] = { 1, 2, 3 };
+    st_malloc_t st_m;
+    st_object_t *document1, *document2, *tags, *typed1, *typed2;
+    st_typed_array_t *array1, *array2;
+    st_array_t *list1, *list2;
+    st_dict_t *cache;
+    uint32_t hash;
+
+    st_malloc_init(&st_m, (st_byte_t *)heap, sizeof(heap));
+    document1 = build_document(&st_m, FALSE, 0.0);
+    document2 = build_document(&st_m, TRUE, -0.0);
+    hash = st_object_hash(document1);
+
+    // Same values in a different order (and 0.0 vs -0.0) are equal and hash the same
+    if (!st_object_compare(document1, document2) || !st_object_compare(document2, document1) ||
+        hash != st_object_hash(document2) || hash == 0)
+    {
+        printf("equal documents did not compare or hash as equal\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // Arrays keep their order
+    tags = st_dict_get_object(st_object_get_dict(document2), st_object_new_string(&st_m, "tags"));
+    st_array_remove_object(st_object_get_array(tags), 0);
+    st_array_append_object(st_object_get_array(tags), st_object_new_string(&st_m, "a"));
+    if (st_object_compare(document1, document2) || hash == st_object_hash(document2))
+    {
+        printf("reordering an array did not change the document\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // Documents as keys, the cached response is found with an equal request
+    cache = st_dict_new(&st_m);
+    st_dict_set_object(cache, document1, st_object_new_string(&st_m, "response"));
+    document2 = build_document(&st_m, TRUE, 0.0);
+    if (st_dict_get_object(cache, document2) == NULL || st_dict_has_key(cache, tags))
+    {
+        printf("a document could not be used as a key\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // Frozen containers cache their hashes and refuse to be modified
+    st_object_set_frozen(document1);
+    tags = st_dict_get_object(st_object_get_dict(document1), st_object_new_string(&st_m, "tags"));
+    if (!st_object_is_frozen(document1) || !st_object_is_frozen(tags) || st_object_hash(document1) != hash ||
+        st_array_append_object(st_object_get_array(tags), st_object_new_int(&st_m, 1)) ||
+        st_array_remove_object(st_object_get_array(tags), 0) ||
+        st_dict_set_object(st_object_get_dict(document1), tags, tags) ||
+        st_array_get_size(st_object_get_array(tags)) != 3 || !st_object_compare(document1, document2))
+    {
+        printf("the frozen document was wrong\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    array1 = st_typed_array_new(&st_m, ST_TYPED_ARRAY_INT32, 0);
+    array2 = st_typed_array_new(&st_m, ST_TYPED_ARRAY_INT32, 0);
+    st_typed_array_append_values(array1, samples, 3);
+    st_typed_array_append_values(array2, samples, 3);
+    typed1 = st_object_new_typed_array(&st_m, array1);
+    typed2 = st_object_new_typed_array(&st_m, array2);
+    if (!st_object_compare(typed1, typed2) || st_object_hash(typed1) != st_object_hash(typed2) ||
+        !st_typed_array_append_long(array2, 4) || st_object_compare(typed1, typed2))
+    {
+        printf("typed arrays did not compare by value\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // Typed arrays stay writable in frozen containers, which must still compare by their current values
+    list1 = st_array_new(&st_m);
+    list2 = st_array_new(&st_m);
+    st_array_append_object(list1, typed1);
+    st_array_append_object(list2, typed2);
+    document1 = st_object_new_array(&st_m, list1);
+    document2 = st_object_new_array(&st_m, list2);
+    st_object_set_frozen(document1);
+    st_object_set_frozen(document2);
+    st_typed_array_append_long(array1, 4);
+    if (!st_object_compare(document1, document2) || st_object_hash(document1) != st_object_hash(document2))
+    {
+        printf("a typed array changed after freezing did not compare by value\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // 0.0 and -0.0 differ in a typed array, the order agrees with the compare
+    array1 = st_typed_array_new(&st_m, ST_TYPED_ARRAY_FLOAT64, 0);
+    array2 = st_typed_array_new(&st_m, ST_TYPED_ARRAY_FLOAT64, 0);
+    st_typed_array_append_float(array1, 0.0);
+    st_typed_array_append_float(array2, -0.0);
+    typed1 = st_object_new_typed_array(&st_m, array1);
+    typed2 = st_object_new_typed_array(&st_m, array2);
+    if (st_object_compare(typed1, typed2) || st_object_order(typed1, typed2) == 0 ||
+        st_object_order(typed1, typed2) != -st_object_order(typed2, typed1))
+    {
+        printf("the order of typed arrays did not agree with the compare\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
 int test_st_dict() {
     st_dict_t *temp_dict;
     st_object_t *temp_object, *temp_key;
@@ -136,6 +432,42 @@ int test_st_dict() {
         passes++;
     }
 
+#if ST_MALLOC_FREE_LISTS
+    // Overwriting a key reuses the link and the freed value, the heap reaches a steady state
+    {
+        st_size_t used;
+        int i;
+
+        temp_key = st_object_new_string(&st_m, "session");
+        st_dict_set_object(temp_dict, temp_key, st_object_new_long(&st_m, 0));
+        used = st_malloc_used_bytes(&st_m);
+
+        for (i=1; i<1000; i++)
+        {
+            st_object_free(&st_m, st_dict_get_object(temp_dict, temp_key));
+            st_dict_set_object(temp_dict, temp_key, st_object_new_long(&st_m, i));
+        }
+
+        if (st_malloc_did_overflow(&st_m) || st_malloc_used_bytes(&st_m) != used ||
+            st_object_get_long(st_dict_get_object(temp_dict, temp_key)) != 999)
+        {
+            printf("Overwriting a key did not reach a steady state\n");
+            errors++;
+        }
+        else
+        {
+            passes++;
+        }
+    }
+#endif
+
+    test_borrowed();
+    test_full_heap();
+#if ST_DICT_INDEX_THRESHOLD > 0
+    test_index_full_heap();
+#endif
+    test_structural();
+
     if (errors == 0) {
         printf("Test passed with '%d' passes\n", passes);
     }
@@ -0,0 +1,261 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "../lib/st_image.h"
+
+static int errors = 0;
+static int passes = 0;
+
+static st_ptr_t _src_heap[2048/sizeof(st_ptr_t)];
+static uint64_t _image[512/sizeof(uint64_t)];
+static uint64_t _moved[512/sizeof(uint64_t)];
+
+static const st_byte_t _blob[] = { 0, 1, 0, 255 };
+
+/* Builds {"name": "", "values": [-3, -0.125, FALSE, -(1 << 40)], "blob": 00 01 00 ff, "nested": {-7: "seven"}},
+ * the empty string, negative scalars and the zero bytes of the blob must survive the image */
+static st_object_t *build_source(st_malloc_t *st_m)
+{
+    st_dict_t *dict = st_dict_new(st_m);
+    st_dict_t *nested = st_dict_new(st_m);
+    st_array_t *values = st_array_new(st_m);
+
+    st_array_append_object(values, st_object_new_int(st_m, -3));
+    st_array_append_object(values, st_object_new_float(st_m, -0.125));
+    st_array_append_object(values, st_object_new_bool(st_m, FALSE));
+    st_array_append_object(values, st_object_new_long(st_m, -(ST_LONG(1) << 40)));
+
+    st_dict_set_object(nested, st_object_new_int(st_m, -7), st_object_new_string(st_m, "seven"));
+
+    st_dict_set_object(dict, st_object_new_string(st_m, "name"), st_object_new_string(st_m, ""));
+    st_dict_set_object(dict, st_object_new_string(st_m, "values"), st_object_new_array(st_m, values));
+    st_dict_set_object(dict, st_object_new_string(st_m, "blob"), st_object_new_blob(st_m, _blob, sizeof(_blob)));
+    st_dict_set_object(dict, st_object_new_string(st_m, "nested"), st_object_new_dict(st_m, nested));
+
+    return st_object_new_dict(st_m, dict);
+}
+
+static void test_write_image()
+{
+    st_malloc_t src;
+    st_object_t *object;
+    st_size_t size, written;
+    const st_byte_t *image = (const st_byte_t *)_moved;
+    st_image_ref_t root, values, blob, nested;
+    const char *name, *seven;
+
+    st_malloc_init(&src, (st_byte_t *)_src_heap, sizeof(_src_heap));
+    object = build_source(&src);
+
+    size = st_object_image_size(object);
+    written = st_object_write_image(object, (st_byte_t *)_image, sizeof(_image));
+
+    if (size == 0 || written != size)
+    {
+        printf("image size %u did not match the written size %u\n", (unsigned)size, (unsigned)written);
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // Move the image and throw away the source graph, the image must stand on its own
+    memcpy(_moved, _image, sizeof(_image));
+    memset(_image, 0xa5, sizeof(_image));
+    st_malloc_free(&src);
+    memset(_src_heap, 0xa5, sizeof(_src_heap));
+
+    root = st_image_root(image);
+    values = st_image_dict_get(image, root, "values");
+    blob = st_image_dict_get(image, root, "blob");
+    nested = st_image_dict_get(image, root, "nested");
+    name = st_image_get_string(image, st_image_dict_get(image, root, "name"));
+    seven = st_image_get_string(image, st_image_dict_value(image, nested, 0));
+
+    if (!st_image_valid(image, written) ||
+        st_image_get_type(image, root) != ST_OBJECT_TYPE_DICT ||
+        st_image_get_size(image, root) != 4 ||
+        name == NULL || strcmp(name, "") != 0 ||
+        st_image_get_size(image, values) != 4 ||
+        st_image_get_int(image, st_image_array_get(image, values, 0)) != -3 ||
+        st_image_get_float(image, st_image_array_get(image, values, 1)) != -0.125 ||
+        st_image_get_bool(image, st_image_array_get(image, values, 2)) != FALSE ||
+        st_image_get_long(image, st_image_array_get(image, values, 3)) != -(ST_LONG(1) << 40) ||
+        st_image_get_size(image, blob) != sizeof(_blob) ||
+        memcmp(st_image_get_blob(image, blob), _blob, sizeof(_blob)) != 0 ||
+        st_image_get_int(image, st_image_dict_key(image, nested, 0)) != -7 ||
+        seven == NULL || strcmp(seven, "seven") != 0)
+    {
+        printf("moved image did not hold the source values\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // Lookups that miss return the invalid reference
+    if (st_image_dict_get(image, root, "missing") != 0 ||
+        st_image_array_get(image, values, 4) != 0 ||
+        st_image_array_get(image, root, 0) != 0)
+    {
+        printf("missing entries did not return 0\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+static void test_write_image_overflow()
+{
+    st_malloc_t src;
+    st_object_t *object;
+    st_size_t size;
+
+    st_malloc_init(&src, (st_byte_t *)_src_heap, sizeof(_src_heap));
+    object = build_source(&src);
+    size = st_object_image_size(object);
+
+    if (st_object_write_image(object, (st_byte_t *)_image, ST_SIZE(size - 1)) != 0 ||
+        st_image_valid((const st_byte_t *)_moved, ST_SIZE(size - 1)))
+    {
+        printf("freezing into a short buffer did not fail\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+static void test_image_keys()
+{
+    st_malloc_t src;
+    st_dict_t *dict;
+    const st_byte_t *image = (const st_byte_t *)_image;
+    st_image_ref_t root;
+
+    // The keys are "a\0b" and "a", only their lengths tell them apart
+    st_malloc_init(&src, (st_byte_t *)_src_heap, sizeof(_src_heap));
+    dict = st_dict_new(&src);
+    st_dict_set_object(dict, st_object_new_string_n(&src, "a\0b", 3), st_object_new_int(&src, 1));
+    st_dict_set_object(dict, st_object_new_string(&src, "a"), st_object_new_int(&src, 2));
+    root = st_object_write_image(st_object_new_dict(&src, dict), (st_byte_t *)_image, sizeof(_image))?st_image_root(image):0;
+
+    if (root == 0 ||
+        st_image_get_int(image, st_image_dict_get(image, root, "a")) != 2 ||
+        st_image_get_int(image, st_image_dict_get_n(image, root, "a\0b", 3)) != 1 ||
+        st_image_dict_get_n(image, root, "a\0c", 3) != 0)
+    {
+        printf("image keys were not compared by their length and bytes\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+static void test_image_corrupted()
+{
+    st_malloc_t src;
+    st_size_t written;
+    st_byte_t *image = (st_byte_t *)_image;
+    st_image_header_t *header = (st_image_header_t *)_image;
+    st_image_ref_t root, values, name;
+
+    st_malloc_init(&src, (st_byte_t *)_src_heap, sizeof(_src_heap));
+    written = st_object_write_image(build_source(&src), image, sizeof(_image));
+    root = st_image_root(image);
+    values = st_image_dict_get(image, root, "values");
+    name = st_image_dict_get(image, root, "name");
+
+    // A truncated image is rejected by its header
+    if (written == 0 || !st_image_valid(image, written) || st_image_valid(image, ST_SIZE(written - 8)))
+    {
+        printf("a truncated image was not rejected\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // Offsets past the end or into the middle of a node, and a string without its NUL, are not followed
+    ((st_image_ref_t *)(image + values + sizeof(st_image_node_t)))[0] = 0xfffffff8u;
+    ((st_image_ref_t *)(image + values + sizeof(st_image_node_t)))[1] = values + 4;
+    image[name + sizeof(st_image_node_t)] = 'x';
+
+    if (st_image_get_type(image, st_image_array_get(image, values, 0)) != ST_IMAGE_TYPE_INVALID ||
+        st_image_get_float(image, st_image_array_get(image, values, 1)) != 0 ||
+        st_image_get_string(image, name) != NULL || st_image_get_size(image, values) != 4)
+    {
+        printf("a corrupted image was read past its nodes\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // A header whose size cuts the root node off
+    header->size = root;
+    if (st_image_valid(image, written) || st_image_get_size(image, root) != 0 ||
+        st_image_dict_get(image, root, "values") != 0)
+    {
+        printf("a node past the size of the header was read\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+int test_st_image()
+{
+    printf("\nRunning 'st_image' test\n");
+
+    test_write_image();
+    test_write_image_overflow();
+    test_image_keys();
+    test_image_corrupted();
+
+    if (errors == 0) {
+        printf("Test passed with '%d' passes\n", passes);
+    }
+    else {
+        printf("Test failed with '%d' errors\n", errors);
+    }
+
+    return errors;
+}
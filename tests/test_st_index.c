@@ -0,0 +1,336 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "../lib/st_clone.h"
+
+#define KEYS 300
+#define WINDOW 80
+
+static int errors = 0;
+static int passes = 0;
+
+static st_ptr_t _heap[32768/sizeof(st_ptr_t)];
+
+/* Equal but not the same objects as the keys of the links */
+static st_object_t *_probes[KEYS];
+
+static void check(st_bool_t condition, const char *message)
+{
+    if (!condition)
+    {
+        printf("%s\n", message);
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+/* Returns "TRUE" if exactly the keys in [first, last) with the given parity (-1 for any) are found */
+static st_bool_t check_keys(st_index_t *index, st_link_t *links, int first, int last, int parity)
+{
+    st_link_t *link;
+    int i;
+
+    for (i=0; i<KEYS; i++) {
+        link = st_index_find(index, _probes[i]);
+        if ((i >= first && i < last && (parity < 0 || i % 2 == parity)) != (link == &links[i])) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static void test_index()
+{
+    static st_link_t links[KEYS];
+    st_malloc_t st_m;
+    st_index_t *index;
+    st_size_t capacity, used, count;
+    int i, round;
+    st_bool_t ok = TRUE;
+
+    st_malloc_init(&st_m, (st_byte_t *)_heap, sizeof(_heap));
+    for (i=0; i<KEYS; i++) {
+        st_link_init(&links[i], NULL, st_object_new_int(&st_m, i));
+        _probes[i] = st_object_new_int(&st_m, i);
+    }
+
+    // The index grows from a single group
+    index = st_index_new(&st_m, 0);
+    check(index != NULL && index->capacity == ST_INDEX_GROUP_SIZE && st_index_find(index, links[0].key) == NULL,
+          "an empty index was not created");
+    for (i=0; i<KEYS; i++) {
+        ok = ST_BOOL(ok && st_index_insert(index, &links[i]));
+    }
+    check(ok && index->count == KEYS && index->capacity == 512 && check_keys(index, links, 0, KEYS, -1),
+          "the keys were not found after growing");
+
+    // Removed keys are not found, the others still are
+    for (i=0; i<KEYS; i+=2) {
+        ok = ST_BOOL(ok && st_index_remove(index, &links[i]));
+    }
+    check(ok && index->count == KEYS / 2 && !st_index_remove(index, &links[0]) &&
+          check_keys(index, links, 0, KEYS, 1), "removing every other key failed");
+
+    // Churn reuses the deleted slots instead of growing
+    capacity = index->capacity;
+    for (round=0; round<20; round++) {
+        for (i=0; i<KEYS; i+=2) {
+            ok = ST_BOOL(ok && st_index_insert(index, &links[i]));
+        }
+        for (i=0; i<KEYS; i+=2) {
+            ok = ST_BOOL(ok && st_index_remove(index, &links[i]));
+        }
+    }
+    check(ok && index->capacity == capacity && check_keys(index, links, 0, KEYS, 1),
+          "the deleted slots were not reclaimed");
+
+    // Tombstones left in full groups are dropped in place when the other keys run out of room.  The keys
+    // are picked by the first of the 4 groups they probe: the first ones fill and empty 3 groups, the others
+    // then go to the last group until the index must drop the tombstones
+    index = st_index_new(&st_m, 56);
+    capacity = index->capacity;
+    used = st_malloc_used_bytes(&st_m);
+    for (round=0; round<20; round++) {
+        for (i=0, count=0; i<KEYS && count<48; i++) {
+            if (((st_object_hash(links[i].key) >> 7) & 3) == 0) {
+                ok = ST_BOOL(ok && st_index_insert(index, &links[i]));
+                count++;
+            }
+        }
+        for (i=0, count=0; i<KEYS && count<48; i++) {
+            if (((st_object_hash(links[i].key) >> 7) & 3) == 0) {
+                ok = ST_BOOL(ok && st_index_remove(index, &links[i]));
+                count++;
+            }
+        }
+        for (i=0, count=0; i<KEYS && count<12; i++) {
+            if (((st_object_hash(links[i].key) >> 7) & 3) == 2) {
+                ok = ST_BOOL(ok && st_index_insert(index, &links[i]) && st_index_find(index, _probes[i]) == &links[i]);
+                count++;
+            }
+        }
+        for (i=0, count=0; i<KEYS && count<12; i++) {
+            if (((st_object_hash(links[i].key) >> 7) & 3) == 2) {
+                ok = ST_BOOL(ok && st_index_remove(index, &links[i]));
+                count++;
+            }
+        }
+    }
+    check(ok && index->count == 0 && index->capacity == capacity && st_malloc_used_bytes(&st_m) == used,
+          "the tombstones took more heap");
+
+    // A reserved index has room for the links without growing
+    index = st_index_new(&st_m, 100);
+    capacity = index->capacity;
+    ok = ST_BOOL(index->growth_left >= 100 && st_index_reserve(index, 100));
+    for (i=0; i<100; i++) {
+        ok = ST_BOOL(ok && st_index_insert(index, &links[i]));
+    }
+    check(ok && index->capacity == capacity && check_keys(index, links, 0, 100, -1),
+          "the reserved index grew");
+}
+
+static void test_dict_index()
+{
+    st_malloc_t st_m;
+    st_dict_t *dict, *plain, *other;
+    st_array_cursor_t cursor;
+    char key[16];
+    int i, vector;
+    st_bool_t ok;
+
+    for (vector=0; vector<2; vector++)
+    {
+        st_malloc_init(&st_m, (st_byte_t *)_heap, sizeof(_heap));
+        dict = st_dict_new(&st_m);
+        plain = st_dict_new(&st_m);
+        ok = ST_BOOL(!vector || st_array_use_vector(dict->array, 0));
+        for (i=0; i<100; i++) {
+            sprintf(key, "key%d", i);
+            ok = ST_BOOL(ok && st_dict_set_object(dict, st_object_new_string(&st_m, key), st_object_new_int(&st_m, i)));
+            st_dict_set_object(plain, st_object_new_string(&st_m, key), st_object_new_int(&st_m, i));
+
+            // Half of the keys are indexed when they are set, the others when the index is built
+            if (i == 49) {
+                ok = ST_BOOL(ok && st_dict_use_index(dict) && dict->array->index->count == 50);
+            }
+        }
+
+        // Overwrites (which keep the position of the key) and removes keep the index in step with the links
+        for (i=0; i<100; i+=3) {
+            sprintf(key, "key%d", i);
+            st_dict_set_object(dict, st_object_new_string(&st_m, key), st_object_new_int(&st_m, -i));
+            st_dict_set_object(plain, st_object_new_string(&st_m, key), st_object_new_int(&st_m, -i));
+        }
+        for (i=1; i<100; i+=3) {
+            sprintf(key, "key%d", i);
+            ok = ST_BOOL(ok && st_dict_remove_object(dict, st_object_new_string(&st_m, key)));
+            st_dict_remove_object(plain, st_object_new_string(&st_m, key));
+        }
+        ok = ST_BOOL(ok && st_dict_get_size(dict) == 67 && dict->array->index->count == 67 &&
+                     st_object_get_int(st_dict_get_object(dict, st_object_new_string(&st_m, "key3"))) == -3 &&
+                     st_object_get_int(st_dict_get_object(dict, st_object_new_string(&st_m, "key5"))) == 5 &&
+                     !st_dict_has_key(dict, st_object_new_string(&st_m, "key4")) &&
+                     !st_dict_remove_object(dict, st_object_new_string(&st_m, "key4")) &&
+                     st_object_compare(st_object_new_dict(&st_m, dict), st_object_new_dict(&st_m, plain)) &&
+                     st_object_get_int(st_array_get_object(dict->array, 0)) == 0 &&
+                     st_object_get_int(st_array_get_object(dict->array, 1)) == 2);
+
+        // Entries removed by a cursor leave the index too
+        for (st_dict_cursor_init(&cursor, dict, FALSE); !st_array_cursor_at_end(&cursor); ) {
+            if (st_object_get_int(st_array_cursor_get_object(&cursor)) < 0) {
+                st_array_cursor_remove(&cursor);
+            }
+            else {
+                st_array_cursor_next(&cursor);
+            }
+        }
+        ok = ST_BOOL(ok && st_dict_get_size(dict) == 34 && dict->array->index->count == 34 &&
+                     st_dict_get_object(dict, st_object_new_string(&st_m, "key3")) == NULL);
+
+        // Moving the entries to another indexed dict moves them between the indexes
+        other = st_dict_new(&st_m);
+        ok = ST_BOOL(ok && st_dict_use_index(other) && st_array_concat(other->array, dict->array) &&
+                     dict->array->index->count == 0 && other->array->index->count == 34 &&
+                     !st_dict_has_key(dict, st_object_new_string(&st_m, "key5")) &&
+                     st_object_get_int(st_dict_get_object(other, st_object_new_string(&st_m, "key5"))) == 5);
+
+        check(ok, vector?"the indexed vector dict failed":"the indexed dict failed");
+    }
+
+    check(!st_dict_use_index(st_dict_new_unrolled(&st_m)), "an unrolled dict was indexed");
+}
+
+#if ST_DICT_INDEX_THRESHOLD > 0
+static void test_adaptive()
+{
+    st_malloc_t st_m;
+    st_dict_t *dict, *unrolled;
+    st_size_t used;
+    int i;
+    st_bool_t ok = TRUE;
+
+    st_malloc_init(&st_m, (st_byte_t *)_heap, sizeof(_heap));
+    dict = st_dict_new(&st_m);
+    unrolled = st_dict_new_unrolled(&st_m);
+
+    // Small dicts stay lists, overwriting a key does not count
+    for (i=0; i<ST_DICT_INDEX_THRESHOLD; i++) {
+        ok = ST_BOOL(ok && st_dict_set_object(dict, st_object_new_int(&st_m, i), st_object_new_int(&st_m, i)));
+        st_dict_set_object(unrolled, st_object_new_int(&st_m, i), st_object_new_int(&st_m, i));
+    }
+    st_dict_set_object(dict, st_object_new_int(&st_m, 0), st_object_new_int(&st_m, 0));
+    check(ok && dict->array->index == NULL, "a small dict was indexed");
+
+    // One more key builds the index over the existing links
+    used = st_malloc_used_bytes(&st_m);
+    for (; i<ST_DICT_INDEX_THRESHOLD + 20; i++) {
+        ok = ST_BOOL(ok && st_dict_set_object(dict, st_object_new_int(&st_m, i), st_object_new_int(&st_m, i)));
+        st_dict_set_object(unrolled, st_object_new_int(&st_m, i), st_object_new_int(&st_m, i));
+    }
+    check(ok && dict->array->index != NULL && dict->array->index->count == st_dict_get_size(dict) &&
+          st_malloc_used_bytes(&st_m) > used &&
+          st_object_get_int(st_dict_get_object(dict, st_object_new_int(&st_m, 0))) == 0 &&
+          st_object_get_int(st_dict_get_object(dict, st_object_new_int(&st_m, i - 1))) == i - 1 &&
+          st_object_compare(st_object_new_dict(&st_m, dict), st_object_new_dict(&st_m, unrolled)) &&
+          unrolled->array->index == NULL, "a large dict was not indexed");
+}
+
+/* The threshold also applies to the dicts that grow without "st_dict_set_object" */
+static void test_adaptive_paths()
+{
+    st_malloc_t st_m;
+    st_dict_t *appended, *spliced, *extra, *small;
+    st_object_t *source, *copy, *reserved, *small_copy;
+    st_dict_t *copied, *reserved_dict;
+    int i;
+
+    st_malloc_init(&st_m, (st_byte_t *)_heap, sizeof(_heap));
+    appended = st_dict_new(&st_m);
+    spliced = st_dict_new(&st_m);
+    extra = st_dict_new(&st_m);
+    small = st_dict_new(&st_m);
+
+    for (i=0; i<=ST_DICT_INDEX_THRESHOLD; i++) {
+        st_array_append_entry(appended->array, st_object_new_int(&st_m, i), st_object_new_int(&st_m, i));
+    }
+    for (i=0; i<ST_DICT_INDEX_THRESHOLD; i++) {
+        st_dict_set_object(spliced, st_object_new_int(&st_m, i), st_object_new_int(&st_m, i));
+    }
+    st_dict_set_object(extra, st_object_new_int(&st_m, i), st_object_new_int(&st_m, i));
+    check(st_array_concat(spliced->array, extra->array) &&
+          appended->array->index != NULL && appended->array->index->count == st_dict_get_size(appended) &&
+          spliced->array->index != NULL && spliced->array->index->count == st_dict_get_size(spliced) &&
+          st_object_get_int(st_dict_get_object(spliced, st_object_new_int(&st_m, i))) == i,
+          "a dict grown by an append or a splice was not indexed");
+
+    // A clone of a large dict is indexed and so is the clone of an indexed small one
+    st_dict_set_object(small, st_object_new_int(&st_m, 1), st_object_new_int(&st_m, 1));
+    st_dict_use_index(small);
+    source = st_object_new_dict(&st_m, appended);
+    copy = st_object_clone(&st_m, source);
+    reserved = st_object_clone_reserved(&st_m, source);
+    small_copy = st_object_clone(&st_m, st_object_new_dict(&st_m, small));
+    copied = st_object_get_dict(copy);
+    reserved_dict = st_object_get_dict(reserved);
+
+    check(copied != NULL && copied->array->index != NULL &&
+          copied->array->index->count == st_dict_get_size(copied) &&
+          reserved_dict != NULL && reserved_dict->array->index != NULL &&
+          reserved_dict->array->index->count == st_dict_get_size(reserved_dict) &&
+          st_object_get_dict(small_copy)->array->index != NULL &&
+          st_object_get_int(st_dict_get_object(copied, st_object_new_int(&st_m, ST_DICT_INDEX_THRESHOLD))) ==
+              ST_DICT_INDEX_THRESHOLD &&
+          st_object_compare(copy, source) && st_object_compare(reserved, source), "a cloned dict lost its index");
+}
+#endif
+
+int test_st_index()
+{
+    printf("\nRunning 'st_index' test\n");
+
+    test_index();
+    test_dict_index();
+#if ST_DICT_INDEX_THRESHOLD > 0
+    test_adaptive();
+    test_adaptive_paths();
+#endif
+
+    if (errors == 0) {
+        printf("Test passed with '%d' passes\n", passes);
+    }
+    else {
+        printf("Test failed with '%d' errors\n", errors);
+    }
+
+    return errors;
+}
@@ -0,0 +1,140 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "../lib/st_intern.h"
+#include "../lib/st_dict.h"
+
+static int errors = 0;
+static int passes = 0;
+
+static const char *const _seed_keys[] = { "id", "name", "values", "timestamp" };
+
+static st_ptr_t _seed_heap[512/sizeof(st_ptr_t)];
+static st_object_t *_seed_slots[8];
+static st_ptr_t _heap[2048/sizeof(st_ptr_t)];
+
+static void check(st_bool_t condition, const char *message)
+{
+    if (!condition)
+    {
+        printf("%s\n", message);
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+static void test_intern()
+{
+    st_malloc_t seed_m, st_m;
+    st_malloc_mark_t mark;
+    st_intern_t seed, *keys;
+    st_object_t *name, *other;
+    st_dict_t *dict;
+    char buffer[16];
+    int packet, i;
+
+    st_malloc_init(&seed_m, (st_byte_t *)_seed_heap, sizeof(_seed_heap));
+    st_intern_init(&seed, &seed_m, _seed_slots, 8, NULL);
+    check(st_intern_seed(&seed, _seed_keys, 4) && seed.count == 4, "seeding the static table failed");
+
+    // Every packet uses its own table on top of the seeded one
+    for (packet=0; packet<2; packet++)
+    {
+        st_malloc_init(&st_m, (st_byte_t *)_heap, sizeof(_heap));
+        keys = st_intern_new(&st_m, 4, &seed);
+
+        name = st_intern_string(keys, "name");
+        check(name == st_intern_find(&seed, "name") && keys->count == 0,
+              "a seeded key was not taken from the static table");
+
+        other = st_intern_string(keys, "unit");
+        check(other != NULL && other == st_intern_string(keys, "unit") && keys->count == 1 &&
+              st_intern_find(&seed, "unit") == NULL, "a new key was not interned in the packet table");
+
+        // Interned keys compare by pointer, a plain string still finds them
+        check(!st_object_compare(name, other) &&
+              st_object_compare(name, st_object_new_string(&st_m, "name")) &&
+              st_object_compare(st_object_new_string(&st_m, "name"), name),
+              "interned keys did not compare as expected");
+
+
+        dict = st_dict_new(&st_m);
+        st_dict_set_object(dict, name, st_object_new_int(&st_m, packet));
+        st_dict_set_object(dict, st_intern_string(keys, "id"), st_object_new_int(&st_m, 7));
+        check(st_object_get_int(st_dict_get_object(dict, st_intern_string(keys, "name"))) == packet &&
+              st_object_get_int(st_dict_get_object(dict, st_object_new_string(&st_m, "id"))) == 7,
+              "dict lookups with interned keys failed");
+
+        // The packet table grows past its initial capacity
+        for (i=0; i<20; i++)
+        {
+            sprintf(buffer, "key%d", i);
+            if (st_intern_string(keys, buffer) == NULL) {
+                break;
+            }
+        }
+        check(i == 20 && keys->count == 21 && keys->capacity >= 32 &&
+              strcmp(st_object_get_string(st_intern_find(keys, "key7")), "key7") == 0,
+              "the packet table did not grow");
+
+        st_malloc_free(&st_m);
+        memset(_heap, 0xa5, sizeof(_heap));
+    }
+
+    // The same string interned by an unrelated table is a different object but still equal
+    st_malloc_mark(&seed_m, &mark);
+    other = st_intern_string(st_intern_new(&seed_m, 4, NULL), "name");
+    name = st_intern_find(&seed, "name");
+    check(other != NULL && other != name && st_object_compare(other, name) && st_object_compare(name, other),
+          "equal keys of separate tables did not compare equal");
+    st_malloc_rewind(&seed_m, &mark);
+
+    // The seeded keys survive freeing the packet heaps
+    check(strcmp(st_object_get_string(st_intern_find(&seed, "timestamp")), "timestamp") == 0,
+          "the static table did not survive st_malloc_free");
+}
+
+int test_st_intern()
+{
+    printf("\nRunning 'st_intern' test\n");
+
+    test_intern();
+
+    if (errors == 0) {
+        printf("Test passed with '%d' passes\n", passes);
+    }
+    else {
+        printf("Test failed with '%d' errors\n", errors);
+    }
+
+    return errors;
+}
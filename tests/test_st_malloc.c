@@ -25,16 +25,449 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include "../lib/st_malloc.h"
 
+typedef struct test_struct_s
+{
+    void *first;
+    void *second;
+} test_struct_t;
+
+#if ST_SIZE_BITS >= 32
+static uint8_t _large_heap[128*1024];
+#endif
+
+static st_ptr_t _pool[3][64/sizeof(st_ptr_t)];
+static int _pool_used = 0;
+static int _pool_released = 0;
+
+static void *pool_alloc(void *context, st_size_t size)
+{
+    return (size <= sizeof(_pool[0]) && _pool_used < 3)?_pool[_pool_used++]:NULL;
+}
+
+static void pool_release(void *context, void *block)
+{
+    _pool_released++;
+}
+
+static int test_chunked()
+{
+    int errors = 0;
+    int passes = 0;
+    st_ptr_t heap[64/sizeof(st_ptr_t)];
+    st_malloc_t st_m;
+    st_malloc_mark_t mark;
+    st_malloc_provider_t provider = {
+        .alloc = pool_alloc, .release = pool_release, .reset = NULL, .context = NULL,
+        .chunk_size = sizeof(_pool[0])
+    };
+    st_size_t block = ST_SIZE(64 - sizeof(st_malloc_chunk_t));
+    void *first, *second;
+
+    printf("Testing chunked heap...\n");
+
+    st_malloc_init_chunked(&st_m, (st_byte_t *)heap, sizeof(heap), &provider);
+
+    first = st_malloc_bytes(&st_m, block);
+    second = st_malloc_bytes(&st_m, 1);
+
+    if (first == NULL || second == NULL || _pool_used != 1 || st_malloc_did_overflow(&st_m) ||
+        st_malloc_used_bytes(&st_m) != block + 1)
+    {
+        errors++;
+        printf("allocation did not move to a second block as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    st_malloc_mark(&st_m, &mark);
+    st_malloc_bytes(&st_m, block);
+
+    if (_pool_used != 2 || !st_malloc_rewind(&st_m, &mark) || st_malloc_used_bytes(&st_m) != block + 1)
+    {
+        errors++;
+        printf("rewind across blocks did not restore the used bytes as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    // Temporary blocks left in the old block are counted until they are freed
+    st_malloc_free(&st_m);
+    st_malloc_temp(&st_m, 8, 8);
+    st_malloc_bytes(&st_m, block);
+
+    if (st_malloc_temp_used_bytes(&st_m) != 8 || st_malloc_used_bytes(&st_m) != block + 8)
+    {
+        errors++;
+        printf("temporary block of the old block was not counted as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    st_malloc_temp_free(&st_m);
+    if (st_malloc_temp_used_bytes(&st_m) != 0 || st_malloc_used_bytes(&st_m) != block)
+    {
+        errors++;
+        printf("temporary block of the old block was not freed as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    // Free returns to the first block, the next allocations reuse the cached blocks
+    st_malloc_free(&st_m);
+    st_malloc_bytes(&st_m, block);
+    st_malloc_bytes(&st_m, block);
+    st_malloc_bytes(&st_m, block);
+
+    if (_pool_used != 2 || st_malloc_used_bytes(&st_m) != 3 * block || st_malloc_did_overflow(&st_m))
+    {
+        errors++;
+        printf("cached blocks were not reused as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    // The provider is exhausted after the last pool block
+    st_malloc_bytes(&st_m, block);
+    if (st_malloc_bytes(&st_m, 1) != NULL || !st_malloc_did_overflow(&st_m))
+    {
+        errors++;
+        printf("did overflow was not TRUE once the provider was exhausted\n");
+    }
+    else {
+        passes++;
+    }
+
+    st_malloc_free(&st_m);
+    st_malloc_trim(&st_m);
+
+    if (_pool_released != 3 || st_m.first->next != NULL)
+    {
+        errors++;
+        printf("trim did not release the cached blocks as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    if (errors != 0) {
+        printf("Chunked heap failed with '%d' errors\n", errors);
+    }
+
+    return errors;
+}
+
+static int test_aligned()
+{
+    int errors = 0;
+    int passes = 0;
+    static uint8_t heap[512];
+    st_malloc_t st_m;
+    st_size_t aligns[] = { 64, 32, 16, 8, 4, 2, 1, 64 };
+    st_size_t i, requested = 0, padding;
+    void *block;
+
+    printf("Testing aligned allocations...\n");
+
+    st_malloc_init(&st_m, heap, sizeof(heap));
+
+    // Start from an odd offset so that every alignment needs padding
+    requested += 1;
+    st_malloc_bytes(&st_m, 1);
+
+    for (i=0; i<sizeof(aligns)/sizeof(aligns[0]); i++)
+    {
+        block = st_malloc_aligned(&st_m, 24, aligns[i]);
+        requested += 24;
+
+        if (block == NULL || (st_ptr_t)block % aligns[i] != 0)
+        {
+            errors++;
+            printf("block was not aligned to %u as expected\n", (unsigned)aligns[i]);
+        }
+        else {
+            passes++;
+        }
+    }
+
+    padding = ST_SIZE(st_malloc_used_bytes(&st_m) - requested);
+    printf("Padding waste: %u of %u bytes\n", (unsigned)padding, (unsigned)st_malloc_used_bytes(&st_m));
+
+    if (st_malloc_aligned(&st_m, 8, 24) != NULL)
+    {
+        errors++;
+        printf("non power of two alignment did not fail as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    // 12 bytes is aligned to 4
+    st_malloc_bytes(&st_m, 1);
+    block = st_malloc_var(&st_m, 12);
+    if (block == NULL || (st_ptr_t)block % 4 != 0)
+    {
+        errors++;
+        printf("12 byte variable was not aligned to 4 as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    if (errors != 0) {
+        printf("Aligned allocations failed with '%d' errors\n", errors);
+    }
+
+    return errors;
+}
+
+static int test_temp()
+{
+    int errors = 0;
+    int passes = 0;
+    st_ptr_t heap[64/sizeof(st_ptr_t)];
+    st_malloc_t st_m;
+    void *object, *temp;
+
+    printf("Testing temporary allocations...\n");
+
+    st_malloc_init(&st_m, (st_byte_t *)heap, sizeof(heap));
+
+    object = st_malloc_bytes(&st_m, 16);
+    temp = st_malloc_temp(&st_m, 16, 8);
+
+    if (temp != (st_byte_t *)heap + 48 || st_malloc_temp_used_bytes(&st_m) != 16 ||
+        st_malloc_used_bytes(&st_m) != 32)
+    {
+        errors++;
+        printf("temporary block was not taken from the top as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    // The cursors meet, the temporary allocation fails without overflowing the heap
+    st_malloc_bytes(&st_m, 32);
+    if (st_malloc_temp(&st_m, 1, 1) != NULL || st_malloc_did_overflow(&st_m))
+    {
+        errors++;
+        printf("temporary allocation did not fail as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    st_malloc_temp_free(&st_m);
+    if (st_malloc_temp_used_bytes(&st_m) != 0 || st_malloc_temp(&st_m, 8, 8) == NULL ||
+        object != heap)
+    {
+        errors++;
+        printf("temporary blocks were not freed as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    if (st_malloc_bytes(&st_m, 9) != NULL || !st_malloc_did_overflow(&st_m))
+    {
+        errors++;
+        printf("did overflow was not TRUE when the cursors met\n");
+    }
+    else {
+        passes++;
+    }
+
+    // Freeing the temporary blocks does not clear the overflow
+    st_malloc_free(&st_m);
+    st_malloc_temp(&st_m, 16, 8);
+    st_malloc_bytes(&st_m, 60);
+    st_malloc_temp_free(&st_m);
+
+    if (!st_malloc_did_overflow(&st_m) || st_malloc_used_bytes(&st_m) != 0 ||
+        st_malloc_bytes(&st_m, 1) != NULL)
+    {
+        errors++;
+        printf("overflow was not sticky across temp free as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    if (errors != 0) {
+        printf("Temporary allocations failed with '%d' errors\n", errors);
+    }
+
+    return errors;
+}
+
+#if ST_MALLOC_FREE_LISTS
+static int test_free_lists()
+{
+    int errors = 0;
+    int passes = 0;
+    st_ptr_t heap[64/sizeof(st_ptr_t)];
+    st_malloc_t st_m;
+    st_malloc_mark_t mark;
+    test_struct_t *first, *second;
+
+    printf("Testing free lists...\n");
+
+    st_malloc_init(&st_m, (st_byte_t *)heap, sizeof(heap));
+
+    first = st_malloc_struct(&st_m, sizeof(test_struct_t));
+    st_malloc_recycle(&st_m, first, sizeof(test_struct_t));
+    second = st_malloc_struct(&st_m, sizeof(test_struct_t));
+
+    if (first != second || st_malloc_used_bytes(&st_m) != sizeof(test_struct_t))
+    {
+        errors++;
+        printf("recycled block was not reused as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    // A smaller block can not satisfy a larger request
+    st_malloc_recycle(&st_m, st_malloc_struct(&st_m, sizeof(st_ptr_t)), sizeof(st_ptr_t));
+    if (st_malloc_struct(&st_m, sizeof(test_struct_t)) == heap + 2)
+    {
+        errors++;
+        printf("smaller recycled block was reused for a larger request\n");
+    }
+    else {
+        passes++;
+    }
+
+    // Rewinding empties the free lists
+    st_malloc_mark(&st_m, &mark);
+    st_malloc_recycle(&st_m, st_malloc_struct(&st_m, sizeof(test_struct_t)), sizeof(test_struct_t));
+    st_malloc_rewind(&st_m, &mark);
+    if (st_m.free_lists[1] != NULL)
+    {
+        errors++;
+        printf("free lists were not emptied by rewind as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    if (errors != 0) {
+        printf("Free lists failed with '%d' errors\n", errors);
+    }
+
+    return errors;
+}
+#endif
+
+#if ST_MALLOC_STATS
+static st_ptr_t _stats_chunk[64/sizeof(st_ptr_t)];
+static char _dump[512];
+
+static void *stats_alloc(void *context, st_size_t size)
+{
+    return (size <= sizeof(_stats_chunk))?_stats_chunk:NULL;
+}
+
+static int dump_print(const char *format, ...)
+{
+    size_t length = strlen(_dump);
+    va_list args;
+    int result;
+
+    va_start(args, format);
+    result = vsnprintf(_dump + length, sizeof(_dump) - length, format, args);
+    va_end(args);
+    return result;
+}
+
+static int test_stats()
+{
+    int errors = 0;
+    int passes = 0;
+    st_ptr_t heap[64/sizeof(st_ptr_t)];
+    st_malloc_t st_m;
+    st_malloc_stats_t *stats = &st_m.stats;
+    st_malloc_provider_t provider = {
+        .alloc = stats_alloc, .release = NULL, .reset = NULL, .context = NULL,
+        .chunk_size = sizeof(_stats_chunk)
+    };
+    char expected[64];
+
+    printf("Testing statistics...\n");
+
+    st_malloc_init(&st_m, (st_byte_t *)heap, sizeof(heap));
+
+    st_malloc_bytes(&st_m, 3);
+    st_malloc_var(&st_m, 4);                // 1 byte of padding
+    st_malloc_struct(&st_m, 16);
+    st_malloc_bytes(&st_m, 1);
+    st_malloc_aligned(&st_m, 8, 8);         // 7 bytes of padding
+    st_malloc_free(&st_m);
+    st_malloc_bytes(&st_m, 40);
+    st_malloc_bytes(&st_m, 40);             // Overflow
+
+    if (stats->bytes_count != 4 || stats->var_count != 1 || stats->struct_count != 1 ||
+        stats->aligned_count != 1)
+    {
+        errors++;
+        printf("allocation counts were not as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    if (stats->padding_bytes != 8 || stats->peak_bytes != 40 || stats->overflow_count != 1 ||
+        stats->free_count != 1)
+    {
+        errors++;
+        printf("padding, peak, overflow or free count was not as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    st_malloc_stats_dump(&st_m, printf);
+
+    // A chunked heap reports the size of all of its chunks
+    st_malloc_init_chunked(&st_m, (st_byte_t *)heap, sizeof(heap), &provider);
+    st_malloc_bytes(&st_m, ST_SIZE(sizeof(heap) - sizeof(st_malloc_chunk_t)));
+    st_malloc_bytes(&st_m, 1);
+    _dump[0] = '\0';
+    st_malloc_stats_dump(&st_m, dump_print);
+    sprintf(expected, "of %lu bytes used", (unsigned long)(2 * (sizeof(heap) - sizeof(st_malloc_chunk_t))));
+    if (strstr(_dump, expected) == NULL) {
+        errors++;
+        printf("the chunked heap size was not the total of its chunks\n");
+    }
+    else {
+        passes++;
+    }
+
+    if (errors != 0) {
+        printf("Statistics failed with '%d' errors\n", errors);
+    }
+
+    return errors;
+}
+#endif
+
 int test_st_malloc()
 {
     int errors = 0;
     int passes = 0;
     uint8_t *test_bytes;
     int16_t *test_integer;
-    st_malloc_t *test_struct;
+    test_struct_t *test_struct;
+    st_malloc_mark_t outer_mark, inner_mark;
 
     /* Create Malloc */
     uint8_t heap[64];
@@ -45,7 +478,7 @@ int test_st_malloc()
 
     test_bytes = (uint8_t *)st_malloc_bytes(&st_m, 15);
     test_integer = (int16_t *)st_malloc_var(&st_m, sizeof(int16_t));
-    test_struct = (st_malloc_t *)st_malloc_struct(&st_m, sizeof(st_malloc_t));
+    test_struct = (test_struct_t *)st_malloc_struct(&st_m, sizeof(test_struct_t));
 
     printf("Testing mallocs and alignment...\n");
 
@@ -140,6 +573,93 @@ int test_st_malloc()
         passes++;
     }
 
+    printf("Testing overflow-safe sizes...\n");
+
+    st_malloc_free(&st_m);
+    st_malloc_bytes(&st_m, 8);
+
+    if (st_malloc_bytes(&st_m, ST_SIZE_MAX) != NULL || !st_malloc_did_overflow(&st_m))
+    {
+        errors++;
+        printf("allocating ST_SIZE_MAX bytes did not overflow as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+#if ST_SIZE_BITS >= 32
+    st_malloc_init(&st_m, _large_heap, sizeof(_large_heap));
+
+    if (st_malloc_bytes(&st_m, 100000) == NULL || st_malloc_used_bytes(&st_m) != 100000 ||
+        st_malloc_did_overflow(&st_m))
+    {
+        errors++;
+        printf("large heap did not allocate 100000 bytes as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    st_malloc_init(&st_m, heap, 64);
+#endif
+
+    printf("Testing mark/rewind...\n");
+
+    st_malloc_free(&st_m);
+    st_malloc_bytes(&st_m, 8);
+    st_malloc_mark(&st_m, &outer_mark);
+    st_malloc_bytes(&st_m, 8);
+    st_malloc_mark(&st_m, &inner_mark);
+    st_malloc_bytes(&st_m, 8);
+
+    if (!st_malloc_rewind(&st_m, &inner_mark) || st_malloc_used_bytes(&st_m) != 16)
+    {
+        errors++;
+        printf("used bytes != 16 after inner rewind as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+    // Overflow the heap, rewinding should recover it
+    st_malloc_bytes(&st_m, 64);
+
+    if (!st_malloc_rewind(&st_m, &outer_mark) || st_malloc_used_bytes(&st_m) != 8 ||
+        st_malloc_did_overflow(&st_m))
+    {
+        errors++;
+        printf("used bytes != 8 after outer rewind as expected\n");
+    }
+    else {
+        passes++;
+    }
+
+#if ST_MALLOC_DEBUG
+    // The outer rewind discarded the inner mark
+    st_malloc_mark(&st_m, &outer_mark);
+    st_malloc_mark(&st_m, &inner_mark);
+    st_malloc_rewind(&st_m, &outer_mark);
+
+    if (st_malloc_rewind(&st_m, &inner_mark))
+    {
+        errors++;
+        printf("rewind of a discarded mark did not fail as expected\n");
+    }
+    else {
+        passes++;
+    }
+#endif
+
+    errors += test_chunked();
+    errors += test_aligned();
+    errors += test_temp();
+#if ST_MALLOC_FREE_LISTS
+    errors += test_free_lists();
+#endif
+#if ST_MALLOC_STATS
+    errors += test_stats();
+#endif
+
     if (errors == 0) {
         printf("Test passed with '%d' passes\n", passes);
     }
@@ -0,0 +1,158 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "../lib/st_malloc.h"
+
+static int errors = 0;
+static int passes = 0;
+
+#if ST_TEST_MMAP
+#include <sys/mman.h>
+#include <unistd.h>
+#include "../lib/st_malloc_mmap.h"
+
+#define HEAP_SIZE 60000
+#define THRESHOLD 8192
+
+/* Returns the number of resident pages in [start, start+size) */
+static int resident_pages(st_byte_t *start, size_t size)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    st_ptr_t first = (st_ptr_t)start & ~(st_ptr_t)(page - 1);
+    unsigned char pages[HEAP_SIZE/1024 + 2];
+    size_t count = ((st_ptr_t)start + size - first + page - 1) / page;
+    size_t i;
+    int resident = 0;
+
+    if (count > sizeof(pages) || mincore((void *)first, count * page, pages) != 0) {
+        return -1;
+    }
+    for (i=0; i<count; i++) {
+        resident += pages[i] & 1;
+    }
+    return resident;
+}
+
+static void test_release()
+{
+    st_malloc_mmap_t mmap_heap;
+    st_malloc_t *st_m = &mmap_heap.malloc;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    st_malloc_mark_t mark;
+    st_byte_t *bytes, *temp;
+
+    if (!st_malloc_mmap_init(&mmap_heap, HEAP_SIZE, THRESHOLD, FALSE))
+    {
+        printf("mmap heap could not be reserved\n");
+        errors++;
+        return;
+    }
+
+    // Nothing is committed until it is touched
+    if (resident_pages(st_m->heap, HEAP_SIZE) != 0)
+    {
+        printf("mmap heap was committed before it was used\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    bytes = st_malloc_bytes(st_m, 50000);
+    memset(bytes, 0x5a, 50000);
+    st_malloc_free(st_m);
+
+    // Pages above the threshold are released, the ones below are kept
+    if (resident_pages(st_m->heap + THRESHOLD + page, 50000 - THRESHOLD - page) != 0 ||
+        resident_pages(st_m->heap, THRESHOLD - page) <= 0 || bytes[0] != 0x5a)
+    {
+        printf("pages above the threshold were not released as expected\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // The heap is still usable after the release
+    bytes = st_malloc_bytes(st_m, 50000);
+    if (bytes == NULL || bytes[40000] != 0 || st_malloc_did_overflow(st_m))
+    {
+        printf("mmap heap was not usable after free\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // A spike of temporary and rewound allocations is released as well
+    st_malloc_free(st_m);
+    st_malloc_mark(st_m, &mark);
+    temp = st_malloc_temp(st_m, 20000, 8);
+    bytes = st_malloc_bytes(st_m, 20000);
+    memset(temp, 0x5a, 20000);
+    memset(bytes, 0x5a, 20000);
+    st_malloc_rewind(st_m, &mark);
+    st_malloc_free(st_m);
+
+    if (resident_pages(st_m->heap + THRESHOLD + page, HEAP_SIZE - THRESHOLD - 2 * page) != 0)
+    {
+        printf("pages of a rewound spike were not released as expected\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    st_malloc_mmap_destroy(&mmap_heap);
+}
+#endif
+
+int test_st_malloc_mmap()
+{
+    printf("\nRunning 'st_malloc_mmap' test\n");
+
+#if ST_TEST_MMAP
+    test_release();
+#else
+    printf("Skipping mmap tests\n");
+#endif
+
+    if (errors == 0) {
+        printf("Test passed with '%d' passes\n", passes);
+    }
+    else {
+        printf("Test failed with '%d' errors\n", errors);
+    }
+
+    return errors;
+}
@@ -0,0 +1,260 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stdio.h>
+#include "../lib/st_malloc_shared.h"
+#include "../lib/st_array.h"
+
+static int errors = 0;
+static int passes = 0;
+
+#if ST_TEST_THREADS
+#include <pthread.h>
+
+#define THREADS 4
+#define ALLOCATIONS 500
+#define ELEMENTS 200
+
+static uint8_t _heap[60000];
+static st_malloc_shared_t _shared;
+
+typedef struct worker_s
+{
+    int id;
+    uint8_t *blocks[ALLOCATIONS];
+    st_malloc_t local;
+    st_array_t *array;
+} worker_t;
+
+static worker_t _workers[THREADS];
+
+static void *shared_worker(void *arg)
+{
+    worker_t *worker = arg;
+    int i, j;
+
+    for (i=0; i<ALLOCATIONS; i++)
+    {
+        worker->blocks[i] = st_malloc_shared_bytes(&_shared, 16);
+        for (j=0; worker->blocks[i] != NULL && j<16; j++)
+        {
+            worker->blocks[i][j] = (uint8_t)worker->id;
+        }
+    }
+    return NULL;
+}
+
+static void *local_worker(void *arg)
+{
+    worker_t *worker = arg;
+    int i;
+
+    st_malloc_shared_init_local(&_shared, &worker->local);
+    worker->array = st_array_new(&worker->local);
+    for (i=0; i<ELEMENTS; i++)
+    {
+        st_array_append_object(worker->array, st_object_new_int(&worker->local, worker->id*1000 + i));
+    }
+    return NULL;
+}
+
+static void run_workers(void *(*function)(void *))
+{
+    pthread_t threads[THREADS];
+    int i;
+
+    for (i=0; i<THREADS; i++)
+    {
+        _workers[i].id = i + 1;
+        pthread_create(&threads[i], NULL, function, &_workers[i]);
+    }
+    for (i=0; i<THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+static void test_shared_stress()
+{
+    int i, j, k, corrupt = 0;
+
+    st_malloc_shared_init(&_shared, _heap, sizeof(_heap), 1024);
+    run_workers(shared_worker);
+
+    // Every block must still hold the id of the thread that allocated it
+    for (i=0; i<THREADS; i++)
+    {
+        for (j=0; j<ALLOCATIONS; j++)
+        {
+            for (k=0; _workers[i].blocks[j] != NULL && k<16; k++)
+            {
+                corrupt += (_workers[i].blocks[j][k] != _workers[i].id);
+            }
+            corrupt += (_workers[i].blocks[j] == NULL);
+        }
+    }
+
+    if (corrupt != 0 || st_malloc_shared_used_bytes(&_shared) != THREADS*ALLOCATIONS*16)
+    {
+        printf("shared blocks overlapped or were lost\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+static void test_local_stress()
+{
+    int i, j, wrong = 0;
+
+    st_malloc_shared_free(&_shared);
+    run_workers(local_worker);
+
+    for (i=0; i<THREADS; i++)
+    {
+        wrong += (st_malloc_did_overflow(&_workers[i].local) != FALSE);
+        wrong += (st_array_get_size(_workers[i].array) != ELEMENTS);
+        for (j=0; j<ELEMENTS; j++)
+        {
+            wrong += (st_object_get_int(st_array_get_object(_workers[i].array, ST_SIZE(j))) != _workers[i].id*1000 + j);
+        }
+    }
+
+    if (wrong != 0 || st_malloc_shared_did_overflow(&_shared))
+    {
+        printf("local arrays were not built as expected\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // A global free reclaims every local block
+    st_malloc_shared_free(&_shared);
+
+    if (st_malloc_shared_used_bytes(&_shared) != 0)
+    {
+        printf("used bytes != 0 after free as expected\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+#endif
+
+static void test_shared_overflow()
+{
+    static uint8_t heap[64];
+    st_malloc_shared_t shared;
+    st_malloc_t local;
+    void *block;
+
+    st_malloc_shared_init(&shared, heap, sizeof(heap), 48);
+
+    block = st_malloc_shared_aligned(&shared, 8, 32);
+    if (block == NULL || (st_ptr_t)block % 32 != 0)
+    {
+        printf("shared block was not aligned to 32 as expected\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+
+    // The local instance can not get a second block
+    st_malloc_shared_free(&shared);
+    st_malloc_shared_init_local(&shared, &local);
+    st_malloc_bytes(&local, 16);
+
+    if (st_malloc_bytes(&local, 40) != NULL || !st_malloc_shared_did_overflow(&shared))
+    {
+        printf("local instance did not overflow as expected\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+/* An aligned start past the end of a heap of the largest st_size_t must not wrap around to its beginning */
+static void test_shared_wrap()
+{
+    static st_ptr_t heap[0x10000/sizeof(st_ptr_t)];
+    st_malloc_shared_t shared;
+    st_byte_t *first;
+    st_size_t padding;
+
+    // The heap is pointer aligned so the padding to 64 bytes leaves room for the filler below
+    st_malloc_shared_init(&shared, (st_byte_t *)heap, ST_SIZE(0xffff), 0);
+
+    // Start on a 64 byte boundary, then stop just past the last one that fits
+    first = st_malloc_shared_aligned(&shared, 0, 64);
+    padding = ST_SIZE(first - (st_byte_t *)heap);
+    st_malloc_shared_bytes(&shared, ST_SIZE(0xffc0 + 1));
+
+    if (first == NULL || padding >= 64 || st_malloc_shared_aligned(&shared, 4, 64) != NULL ||
+        !st_malloc_shared_did_overflow(&shared) ||
+        st_malloc_shared_used_bytes(&shared) != ST_SIZE(padding + 0xffc0 + 1))
+    {
+        printf("an aligned start past the heap wrapped around\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+int test_st_malloc_shared()
+{
+    printf("\nRunning 'st_malloc_shared' test\n");
+
+    test_shared_overflow();
+    test_shared_wrap();
+#if ST_TEST_THREADS
+    test_shared_stress();
+    test_local_stress();
+#else
+    printf("Skipping multi-threaded tests\n");
+#endif
+
+    if (errors == 0) {
+        printf("Test passed with '%d' passes\n", passes);
+    }
+    else {
+        printf("Test failed with '%d' errors\n", errors);
+    }
+
+    return errors;
+}
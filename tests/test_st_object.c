@@ -26,13 +26,14 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 #include <stdio.h>
+#include <math.h>
 #include <string.h>
 #include "../lib/st_object.h"
 
 static int errors = 0;
 static int passes = 0;
 
-static uint8_t _heap[256];
+static uint8_t _heap[512];
 static st_malloc_t _st_m;
 
 static void object_compare(st_object_t *object1, st_object_t *object2, st_bool_t expected)
@@ -178,6 +179,161 @@ static void test_string() {
     }
 }
 
+static void test_string_n() {
+    const char packet[] = "name=sensor;namf";
+    st_object_t *object1, *object2;
+    st_malloc_t *st_m = &_st_m;
+
+    st_malloc_init(st_m, _heap, sizeof(_heap));
+
+    // Strings can be taken straight out of a packet without a terminator
+    object1 = st_object_new_string_n(st_m, packet, 4);
+    object2 = st_object_new_string(st_m, "name");
+
+    object_compare(object1, object2, TRUE);
+    object_compare(object1, st_object_new_string_n(st_m, packet + 12, 4), FALSE);
+    object_compare(object1, st_object_new_string_n(st_m, packet, 3), FALSE);
+    object_compare(st_object_new_string_n(st_m, packet + 5, 0), st_object_new_string(st_m, ""), TRUE);
+
+    if (strcmp(st_object_get_string(object1), "name") != 0 || st_object_get_string_length(object1) != 4 ||
+        st_object_get_string_hash(object1) != st_object_get_string_hash(object2) ||
+        st_object_get_string_hash(object1) != st_object_hash_string("name", 4) ||
+        st_object_get_string_length(st_object_new_int(st_m, 4)) != 0)
+    {
+        printf("object1 did not cache the length and hash of 'name'\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+static char _long_string[70001];
+#if ST_SIZE_BITS >= 32
+static uint8_t _large_heap[80*1024];
+#endif
+
+static void test_long_string() {
+    st_object_t *object1;
+    st_malloc_t *st_m = &_st_m;
+
+    memset(_long_string, 'a', sizeof(_long_string) - 1);
+
+#if ST_SIZE_BITS >= 32
+    st_malloc_init(st_m, _large_heap, sizeof(_large_heap));
+    object1 = st_object_new_string(st_m, _long_string);
+
+    if (object1 == NULL || strlen(st_object_get_string(object1)) != 70000)
+    {
+        printf("object1 was expected to hold 70000 characters but did not\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+#else
+    /* The string does not fit st_size_t and must not be truncated */
+    st_malloc_init(st_m, _heap, sizeof(_heap));
+    object1 = st_object_new_string(st_m, _long_string);
+
+    if (object1 != NULL)
+    {
+        printf("object1 was expected to be NULL but was not\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+#endif
+}
+
+/* The layout objects had when every scalar lived in a separate allocation */
+typedef struct legacy_object_s
+{
+    st_object_type_t type;
+    void *value;
+} legacy_object_t;
+
+static void test_inline_size() {
+    st_ptr_t heap[256/sizeof(st_ptr_t)];
+    st_malloc_t st_m;
+    st_size_t sizes[] = { sizeof(st_bool_t), sizeof(st_int_t), sizeof(st_long_t), sizeof(st_float_t) };
+    st_size_t i, legacy, used, expected;
+
+    for (i=0; i<4; i++)
+    {
+        st_malloc_init(&st_m, (st_byte_t *)heap, sizeof(heap));
+
+        switch(i) {
+            case 0: st_object_new_bool(&st_m, TRUE); break;
+            case 1: st_object_new_int(&st_m, 22); break;
+            case 2: st_object_new_long(&st_m, 22); break;
+            default: st_object_new_float(&st_m, 22.1); break;
+        }
+
+        // A scalar object is a single allocation (a NaN-boxed long keeps its value apart)
+        used = st_malloc_used_bytes(&st_m);
+        expected = sizeof(st_object_t);
+#if ST_OBJECT_NAN_BOX
+        if (i == 2) {
+            expected += sizeof(st_long_t);
+        }
+#endif
+        legacy = ST_SIZE(sizeof(legacy_object_t) + ((sizes[i] + sizeof(st_ptr_t) - 1) & ~(sizeof(st_ptr_t) - 1)));
+        printf("scalar of %u bytes: %u bytes per object, %d saved\n", (unsigned)sizes[i],
+               (unsigned)used, (int)legacy - (int)used);
+
+        if (used != expected)
+        {
+            printf("scalar object used %u bytes instead of %u\n", (unsigned)used, (unsigned)expected);
+            errors++;
+        }
+        else
+        {
+            passes++;
+        }
+    }
+}
+
+static void test_encoding() {
+    st_ptr_t heap[256/sizeof(st_ptr_t)];
+    st_malloc_t st_m;
+    st_object_t *nan, *zero, *negative_zero, *negative, *big;
+
+    st_malloc_init(&st_m, (st_byte_t *)heap, sizeof(heap));
+
+    nan = st_object_new_float(&st_m, NAN);
+    zero = st_object_new_float(&st_m, 0.0);
+    negative_zero = st_object_new_float(&st_m, -0.0);
+    negative = st_object_new_int(&st_m, -22);
+    big = st_object_new_long(&st_m, INT64_MIN);
+
+    object_compare(nan, nan, TRUE);
+    object_compare(nan, st_object_new_float(&st_m, NAN), FALSE);
+    object_compare(zero, negative_zero, TRUE);
+    object_compare(negative, st_object_new_int(&st_m, -22), TRUE);
+    object_compare(negative, st_object_new_long(&st_m, -22), FALSE);
+    object_compare(big, st_object_new_long(&st_m, INT64_MIN), TRUE);
+
+    // Every value keeps its type and the getters of other types return 0
+    if (st_object_get_type(nan) != ST_OBJECT_TYPE_FLOAT || st_object_get_float(nan) == st_object_get_float(nan) ||
+        st_object_get_type(negative) != ST_OBJECT_TYPE_INT || st_object_get_int(negative) != -22 ||
+        st_object_get_long(negative) != 0 || st_object_get_float(negative) != 0 ||
+        st_object_get_type(big) != ST_OBJECT_TYPE_LONG || st_object_get_long(big) != INT64_MIN ||
+        st_object_get_int(big) != 0 || st_object_get_string(zero) != NULL)
+    {
+        printf("objects did not keep their type and value\n");
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
 int test_st_object() {
 
     printf("\nRunning 'st_object' test\n");
@@ -187,6 +343,10 @@ int test_st_object() {
     test_long();
     test_float();
     test_string();
+    test_string_n();
+    test_long_string();
+    test_inline_size();
+    test_encoding();
 
     if (errors == 0) {
         printf("Test passed with '%d' passes\n", passes);
@@ -0,0 +1,278 @@
+/**
+
+Copyright (c) 2016 Eric Chapman
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "../lib/st_typed_array.h"
+#include "../lib/st_clone.h"
+#include "../lib/st_image.h"
+
+#define COUNT 37
+
+static int errors = 0;
+static int passes = 0;
+
+static st_ptr_t _heap[4096/sizeof(st_ptr_t)];
+static st_ptr_t _dst_heap[2048/sizeof(st_ptr_t)];
+static uint64_t _image[1024/sizeof(uint64_t)];
+
+static void check(st_bool_t condition, const char *message)
+{
+    if (!condition)
+    {
+        printf("%s\n", message);
+        errors++;
+    }
+    else
+    {
+        passes++;
+    }
+}
+
+static void test_append()
+{
+    st_malloc_t st_m;
+    st_typed_array_t *array;
+    st_byte_t *data;
+    st_bool_t ok = TRUE;
+    int i, n;
+
+    st_malloc_init(&st_m, (st_byte_t *)_heap, sizeof(_heap));
+    array = st_typed_array_new(&st_m, ST_TYPED_ARRAY_INT32, 0);
+    check(array != NULL && st_typed_array_get_size(array) == 0 && st_typed_array_get_data(array) == NULL &&
+          st_typed_array_sum(array) == 0 && st_typed_array_max(array) == 0, "the empty typed array was wrong");
+
+    // The storage is the last allocation, so it grows in place
+    st_typed_array_append_long(array, 0);
+    data = st_typed_array_get_data(array);
+    for (i=1; i<COUNT; i++) {
+        ok = ST_BOOL(ok && st_typed_array_append_long(array, i * 3));
+    }
+    check(ok && st_typed_array_get_data(array) == data && ((st_ptr_t)data % ST_TYPED_ARRAY_ALIGN) == 0 &&
+          array->capacity >= COUNT && st_typed_array_get_long(array, 36) == 108,
+          "the storage was not extended in place");
+
+    // Something else was allocated after it, the storage moves
+    st_malloc_bytes(&st_m, 1);
+    for (i=COUNT, n=array->capacity; i<=n; i++) {
+        st_typed_array_append_long(array, i * 3);
+    }
+    check(st_typed_array_get_data(array) != data &&
+          ((st_ptr_t)st_typed_array_get_data(array) % ST_TYPED_ARRAY_ALIGN) == 0 &&
+          st_typed_array_get_long(array, 5) == 15 && st_typed_array_get_float(array, 36) == 108 &&
+          st_typed_array_get_long(array, array->size) == 0, "the storage was not moved");
+
+    // Conversions to the element type
+    array = st_typed_array_new(&st_m, ST_TYPED_ARRAY_UINT8, 4);
+    st_typed_array_append_long(array, 255);
+    st_typed_array_append_float(array, 2.75);
+    check(st_typed_array_get_long(array, 0) == 255 && st_typed_array_get_long(array, 1) == 2 &&
+          st_typed_array_get_element_size(array) == 1, "the values were not converted to uint8");
+
+    // A heap that is too small
+    array = st_typed_array_new(&st_m, ST_TYPED_ARRAY_FLOAT64, 0);
+    check(array != NULL && !st_typed_array_append_values(array, _heap, sizeof(_heap) / sizeof(double)) &&
+          st_typed_array_get_size(array) == 0, "appending more than the heap did not fail");
+
+    // An element type that does not exist
+    check(st_typed_array_new(&st_m, (st_typed_array_type_t)(ST_TYPED_ARRAY_UINT8 + 1), 4) == NULL,
+          "a typed array of an unknown type was created");
+}
+
+static void test_kernels()
+{
+    static const st_typed_array_isa_t isas[] = { ST_TYPED_ARRAY_ISA_SCALAR, ST_TYPED_ARRAY_ISA_SSE2,
+                                                 ST_TYPED_ARRAY_ISA_AVX2 };
+    st_typed_array_isa_t isa = st_typed_array_get_isa();
+    st_malloc_t st_m;
+    st_typed_array_t *reals, *others, *ints, *longs, *bytes;
+    int32_t int_values[COUNT];
+    int64_t long_values[COUNT];
+    double real_values[COUNT];
+    uint8_t byte_values[COUNT * 3];
+    unsigned i, n;
+
+    // Integral values keep every result exact whatever the order of the additions
+    for (i=0; i<COUNT; i++) {
+        int_values[i] = (int32_t)((i * 7919) % 201) - 100;
+        real_values[i] = (double)int_values[i] * 0.5;
+    }
+    for (i=0; i<COUNT * 3; i++) {
+        byte_values[i] = (uint8_t)(255 - i);
+    }
+    int_values[23] = -1000;
+    real_values[30] = 1000;
+    for (i=0; i<COUNT; i++) {
+        long_values[i] = (int64_t)int_values[i] * (ST_LONG(1) << 33);
+    }
+
+    for (n=0; n<sizeof(isas) / sizeof(isas[0]); n++)
+    {
+        if (!st_typed_array_use_isa(isas[n])) {
+            printf("skipping unsupported isa %u\n", (unsigned)isas[n]);
+            continue;
+        }
+
+        st_malloc_init(&st_m, (st_byte_t *)_heap, sizeof(_heap));
+        reals = st_typed_array_new(&st_m, ST_TYPED_ARRAY_FLOAT64, COUNT);
+        others = st_typed_array_new(&st_m, ST_TYPED_ARRAY_FLOAT64, COUNT);
+        ints = st_typed_array_new(&st_m, ST_TYPED_ARRAY_INT32, COUNT);
+        longs = st_typed_array_new(&st_m, ST_TYPED_ARRAY_INT64, COUNT);
+        bytes = st_typed_array_new(&st_m, ST_TYPED_ARRAY_UINT8, COUNT * 3);
+        st_typed_array_append_values(reals, real_values, COUNT);
+        st_typed_array_append_values(others, real_values, COUNT);
+        st_typed_array_append_values(ints, int_values, COUNT);
+        st_typed_array_append_values(longs, long_values, COUNT);
+        st_typed_array_append_values(bytes, byte_values, COUNT * 3);
+
+        check(st_typed_array_get_isa() == isas[n] &&
+              st_typed_array_sum(reals) == 1123 &&
+              st_typed_array_min(reals) == -50 && st_typed_array_max(reals) == 1000 &&
+              st_typed_array_sum(ints) == -596 &&
+              st_typed_array_min(ints) == -1000 && st_typed_array_max(ints) == 99 &&
+              st_typed_array_sum(longs) == -596.0 * (ST_LONG(1) << 33) &&
+              st_typed_array_min(longs) == -1000.0 * (ST_LONG(1) << 33) &&
+              st_typed_array_max(longs) == 99.0 * (ST_LONG(1) << 33) &&
+              st_typed_array_sum(bytes) == 22200 &&
+              st_typed_array_min(bytes) == 145 && st_typed_array_max(bytes) == 255, "the reductions returned the wrong values");
+
+        check(st_typed_array_dot(reals, others) == 1030522 &&
+              st_typed_array_dot(ints, ints) == 1125248 &&
+              st_typed_array_dot(reals, ints) == 0 &&
+              st_typed_array_dot(bytes, bytes) == 4553960, "the dot products returned the wrong values");
+
+        // The 64-bit sum wraps around instead of overflowing
+        longs = st_typed_array_new(&st_m, ST_TYPED_ARRAY_INT64, COUNT + 1);
+        st_typed_array_append_long(longs, ST_LONG(0x7fffffffffffffff));
+        for (i=0; i<COUNT; i++) {
+            st_typed_array_append_long(longs, (i == 20)?1:0);
+        }
+        check(st_typed_array_sum(longs) == -9223372036854775808.0, "the int64 sum did not wrap around");
+
+        st_typed_array_scale(reals, 2);
+        st_typed_array_scale(ints, -0.5);
+        check(st_typed_array_get_float(reals, 30) == 2000 && st_typed_array_get_float(reals, 36) == -34 &&
+              st_typed_array_get_long(ints, 23) == 500 && st_typed_array_get_long(ints, 36) == 17,
+              "scaling returned the wrong values");
+    }
+
+    st_typed_array_use_isa(isa);
+}
+
+static void test_slice()
+{
+    st_malloc_t st_m;
+    st_typed_array_t *array, *slice;
+    int64_t values[] = { 1, -2, ST_LONG(1) << 40, 4, 5 };
+
+    st_malloc_init(&st_m, (st_byte_t *)_heap, sizeof(_heap));
+    array = st_typed_array_new(&st_m, ST_TYPED_ARRAY_INT64, 0);
+    st_typed_array_append_values(array, values, 5);
+
+    slice = st_typed_array_slice(array, 1, 4);
+    check(slice != NULL && st_typed_array_get_size(slice) == 3 &&
+          st_typed_array_get_long(slice, 1) == ST_LONG(1) << 40 && st_typed_array_sum(slice) == (double)((ST_LONG(1) << 40) + 2) && st_typed_array_min(slice) == -2,
+          "the slice was wrong");
+
+    // The copy does not share the storage
+    st_typed_array_scale(slice, 2);
+    check(st_typed_array_get_long(array, 3) == 4 && st_typed_array_get_long(slice, 2) == 8,
+          "the slice shared the storage");
+
+    slice = st_typed_array_slice(array, 3, 100);
+    check(slice != NULL && st_typed_array_get_size(slice) == 2 && st_typed_array_max(slice) == 5,
+          "the end of the slice was not clamped");
+    check(st_typed_array_lower_bound(slice, 4) == 0 && st_typed_array_lower_bound(slice, 4.5) == 1 &&
+          st_typed_array_lower_bound(slice, 6) == 2, "the lower bound was wrong");
+
+    slice = st_typed_array_slice(array, 7, 9);
+    check(slice != NULL && st_typed_array_get_size(slice) == 0, "the slice past the end was not empty");
+}
+
+static void test_object()
+{
+    st_malloc_t st_m, dst;
+    st_typed_array_t *array, *copy;
+    st_dict_t *dict;
+    st_object_t *key, *object, *clone;
+    st_typed_array_type_t type;
+    const st_byte_t *image = (const st_byte_t *)_image;
+    const double *elements;
+    st_image_ref_t ref;
+    st_size_t size;
+    int i;
+
+    st_malloc_init(&st_m, (st_byte_t *)_heap, sizeof(_heap));
+    array = st_typed_array_new(&st_m, ST_TYPED_ARRAY_FLOAT64, 0);
+    for (i=0; i<10; i++) {
+        st_typed_array_append_float(array, i * 1.5);
+    }
+
+    dict = st_dict_new(&st_m);
+    key = st_object_new_string(&st_m, "samples");
+    st_dict_set_object(dict, key, st_object_new_typed_array(&st_m, array));
+    object = st_dict_get_object(dict, key);
+    check(object != NULL && st_object_get_type(object) == ST_OBJECT_TYPE_TYPED_ARRAY &&
+          st_object_get_typed_array(object) == array && st_object_get_array(object) == NULL,
+          "the boxed typed array was wrong");
+
+    // Deep copy, the copy keeps growing in its own heap
+    st_malloc_init(&dst, (st_byte_t *)_dst_heap, sizeof(_dst_heap));
+    size = st_object_clone_size(object);
+    clone = st_object_clone_reserved(&dst, object);
+    copy = (clone != NULL)?st_object_get_typed_array(clone):NULL;
+    check(copy != NULL && copy != array && copy->type == ST_TYPED_ARRAY_FLOAT64 &&
+          st_typed_array_sum(copy) == 67.5 && st_malloc_used_bytes(&dst) <= size &&
+          st_typed_array_append_float(copy, 2) && copy->malloc == &dst,
+          "the typed array was not cloned");
+
+    ref = st_object_write_image(object, (st_byte_t *)_image, sizeof(_image))?st_image_root(image):0;
+    elements = st_image_get_typed_array(image, ref, &type);
+    check(ref != 0 && elements != NULL && type == ST_TYPED_ARRAY_FLOAT64 &&
+          st_image_get_size(image, ref) == 10 && elements[9] == 13.5 &&
+          st_image_get_typed_array(image, ref, NULL) == elements,
+          "the typed array in the image was wrong");
+}
+
+int test_st_typed_array()
+{
+    printf("\nRunning 'st_typed_array' test\n");
+
+    test_append();
+    test_kernels();
+    test_slice();
+    test_object();
+
+    if (errors == 0) {
+        printf("Test passed with '%d' passes\n", passes);
+    }
+    else {
+        printf("Test failed with '%d' errors\n", errors);
+    }
+
+    return errors;
+}